@@ -12,8 +12,10 @@
 //#define CE_OBJ_CONFIG
 //#define CE_OBJ_DISPLAY
 //#define CE_OBJ_DISTANCE        
+//#define CE_OBJ_ICCBUS
 //#define CE_OBJ_INFRARED
 //#define CE_OBJ_FS20
+//#define CE_OBJ_FS20RX
 #define CE_OBJ_KEY
 //#define CE_OBJ_KS300
 //#define CE_OBJ_LCD
@@ -27,8 +29,11 @@
 //#define CE_OBJ_PERSON
 //--#define CE_OBJ_PRESSURE
 //#define CE_OBJ_RADIO
+//#define CE_OBJ_RDS
 //#define CE_OBJ_RFID
 //#define CE_OBJ_TEMPERA
+//#define CE_OBJ_TEMPFILTER
+//#define CE_OBJ_TIMELOG
 #define CE_OBJ_SSEGDIS
 //#define CE_OBJ_ST7735
 //#define CE_OBJ_RTC
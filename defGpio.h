@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// File...: defGpio.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Fast GPIO access for objFs20, objFs20Rx, objLed
+//------------------------------------------------------------------------------
+// digitalWrite() looks up port and mask in PROGMEM tables and checks the
+// PWM timer on every call (several us on AVR). Two pin bindings:
+//
+//   gpioAvr<PORT, BIT> : compile time (AVR), sbi/cbi on the port register
+//                        e.g. Uno pin 3 = PD3 -> gpioAvr<GPIO_PORTD, 3>
+//   gpioPin            : pin number resolved once to port register and
+//                        mask ("Bind()"), other cores use digitalWrite()
+//------------------------------------------------------------------------------
+#ifndef _CPP_DEFGPIO
+#define _CPP_DEFGPIO
+
+#include <Arduino.h>
+
+/* AVR PORTx data memory address (DDRx = PORTx - 1, PINx = PORTx - 2) */
+#define GPIO_PORTB  0x25
+#define GPIO_PORTC  0x28
+#define GPIO_PORTD  0x2B
+
+//==============================================================================
+// PIN: gpioAvr - compile time port register and mask (AVR only)
+//==============================================================================
+template <U16 PORT_ADDR, U8 BIT>
+struct gpioAvr
+{
+    static_assert(BIT < 8, "gpioAvr: BIT 0..7");
+    static_assert(PORT_ADDR >= 0x22, "gpioAvr: PORT_ADDR is no PORTx");
+    
+    static constexpr U8 MASK = (1 << BIT);
+    
+    /* Single instruction (sbi/cbi) for ports in the I/O space -> atomic */
+    static void Output(void) { *(volatile U8 *)(PORT_ADDR - 1) |= MASK; }
+    static void Input(void)  { *(volatile U8 *)(PORT_ADDR - 1) &= ~MASK; }
+    static void High(void)   { *(volatile U8 *)(PORT_ADDR) |= MASK; }
+    static void Low(void)    { *(volatile U8 *)(PORT_ADDR) &= ~MASK; }
+    static void Write(bool bHigh) { if (bHigh) High(); else Low(); }
+    static bool Read(void)   { return ((*(volatile U8 *)(PORT_ADDR - 2) & MASK) != 0); }
+};
+
+//==============================================================================
+// PIN: gpioPin - pin number resolved once at runtime
+//==============================================================================
+class gpioPin
+{
+    public:
+        gpioPin(void)
+        {
+#ifdef __AVR__
+            pOut = NULL;
+            pIn = NULL;
+            bitMask = 0;
+#endif
+            pinNumber = 0;
+        }
+        
+        /* Bind Arduino pin number, FALSE if no valid pin */
+        bool Bind(U8 pinNum, U8 pinMod)
+        {
+            pinNumber = pinNum;
+            pinMode(pinNumber, pinMod);
+#ifdef __AVR__
+            U8 portNum = digitalPinToPort(pinNumber);
+            if (portNum == NOT_A_PIN)
+            {
+                return false; // ERROR
+            }
+            pOut = portOutputRegister(portNum);
+            pIn = portInputRegister(portNum);
+            bitMask = digitalPinToBitMask(pinNumber);
+#endif
+            return true; // OK
+        }
+        
+#ifdef __AVR__
+        /* Read-modify-write, ISR may change other bits of the port */
+        void High(void) { U8 sreg = SREG; cli(); *pOut |= bitMask; SREG = sreg; }
+        void Low(void)  { U8 sreg = SREG; cli(); *pOut &= ~bitMask; SREG = sreg; }
+        bool Read(void) { return ((*pIn & bitMask) != 0); }
+#else
+        void High(void) { digitalWrite(pinNumber, HIGH); }
+        void Low(void)  { digitalWrite(pinNumber, LOW); }
+        bool Read(void) { return (digitalRead(pinNumber) == HIGH); }
+#endif
+        void Write(bool bHigh) { if (bHigh) High(); else Low(); }
+        U8 Number(void) { return pinNumber; }
+#ifdef __AVR__
+        /* Port input register and bit mask (read several pins at once) */
+        volatile U8 *InPort(void) { return pIn; }
+        U8 Mask(void) { return bitMask; }
+#endif
+        
+    private:
+#ifdef __AVR__
+        volatile U8 *pOut;
+        volatile U8 *pIn;
+        U8 bitMask;
+#endif
+        U8 pinNumber;
+};
+
+#endif // _CPP_DEFGPIO
@@ -0,0 +1,83 @@
+//------------------------------------------------------------------------------
+// File...: defIccBus.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// I2C bus interface for objRadio, objTempera, objIccBus
+//------------------------------------------------------------------------------
+// Devices do not use the global "Wire" object directly, they get an
+// "iccBus" (default: shared "iccWire::Default()" on "Wire"). Other buses
+// (Wire1, software I2C, I2C multiplexer channel, simulated bus on a host)
+// implement Write/Read. objIccBus identifies a bus by its iccBus object ->
+// use one iccWire per TwoWire.
+//------------------------------------------------------------------------------
+#ifndef _CPP_DEFICCBUS
+#define _CPP_DEFICCBUS
+
+#include <Wire.h>
+
+//==============================================================================
+// INTERFACE: iccBus - I2C bus
+//==============================================================================
+class iccBus
+{
+    public:
+        virtual ~iccBus() {}
+        
+        /* Initialize bus (default: nothing to do) */
+        virtual void Begin(void) {}
+        
+        /* Write "dataLen" bytes to device (0 = probe), 0 = OK (Wire status) */
+        virtual U8 Write(U8 devAddr, const U8 *pData, U8 dataLen) = 0;
+        
+        /* Read "dataLen" bytes from device, return number of bytes read */
+        virtual U8 Read(U8 devAddr, U8 *pData, U8 dataLen) = 0;
+};
+
+//==============================================================================
+// BUS: iccWire - Arduino TwoWire (Wire, Wire1, ..)
+//==============================================================================
+class iccWire : public iccBus
+{
+    public:
+        iccWire(void) { pWire = &Wire; }
+        iccWire(TwoWire *pTwoWire) { pWire = pTwoWire; }
+        
+        /* Initialize "Wire.begin()" */
+        virtual void Begin(void) { pWire->begin(); }
+        
+        /* Bus on "Wire" shared by all devices without "SetBus()" */
+        static iccWire *Default(void)
+        {
+            static iccWire wireBus;
+            return &wireBus;
+        }
+        
+        //----------------------------------------------------------------------
+        virtual U8 Write(U8 devAddr, const U8 *pData, U8 dataLen)
+        {
+            pWire->beginTransmission(devAddr);
+            if (dataLen > 0)
+            {
+                pWire->write(pData, dataLen);
+            }
+            return pWire->endTransmission();
+        }
+        
+        //----------------------------------------------------------------------
+        virtual U8 Read(U8 devAddr, U8 *pData, U8 dataLen)
+        {
+            U8 readLen = 0;
+            pWire->requestFrom((uint8_t)devAddr, (uint8_t)dataLen);
+            while ((readLen < dataLen) && pWire->available())
+            {
+                pData[readLen++] = pWire->read();
+            }
+            return readLen;
+        }
+        
+    private:
+        TwoWire *pWire;
+};
+
+#endif // _CPP_DEFICCBUS
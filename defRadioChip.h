@@ -0,0 +1,1093 @@
+//------------------------------------------------------------------------------
+// File...: defRadioChip.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Radio chip and band policies for objRadioT<CHIP, BAND> - TEA5767, RDA5807M
+//------------------------------------------------------------------------------
+// Every chip policy is a struct with constants and static inline functions,
+// objRadioT<CHIP, BAND> calls them directly (no virtual functions, no #ifdef):
+//
+//   ICC_ADDR, BUF_SIZE, READ_OFS, ...  Buffer layout and transfer length
+//   InitBuffer()    Default register values
+//   SetBand<BAND>() Band and channel spacing bits
+//   PowerUp()       Power-up step (RADIO_STATE_xxx) -> next state
+//   DirtyBit()      Dirty mask bit of register
+//   CommitLen()     Burst length for dirty registers (0 = single register)
+//   CommitDone()    Clear command bits (TUNE, SEEK) after write
+//   RegisterFrame() Single register write frame
+//   Channel<BAND>() .. Rds()  Setter -> changed register (RADIO_REG_NONE)
+//   SeekStart<BAND>(), SeekStatus<BAND>(), SignalLevel(), SignalSample(),
+//   RdsGroup()
+//
+// The band policy radioBand<..> describes the channel grid, a channel index
+// is encoded into register bytes without division (TEA5767: PLL word table
+// in flash, generated at compile time; RDA5807M: CHAN is the index).
+//
+// SI4705: not supported yet -> add "radioSi4705" with the same members.
+//------------------------------------------------------------------------------
+#ifndef _CPP_DEFRADIOCHIP
+#define _CPP_DEFRADIOCHIP
+
+//==============================================================================
+// BAND POLICY: radioBand<FMIN, FMAX, SPACE, BAND, BL>
+//==============================================================================
+/* FMIN, FMAX : Band limits [10 kHz] (87,0 MHz -> 8700), FMIN = channel 0
+ * SPACE      : Channel spacing [kHz] (25, 50, 100, 200)
+ * BAND       : RDA5807M BAND [3:2] (0=87-108, 1=76-91, 2=76-108, 3=65-76 MHz)
+ * BL         : TEA5767 band limit (0=US/Europe, 1=Japan)
+ */
+template <U16 FMIN_, U16 FMAX_, U8 SPACE_, U8 BAND_, U8 BL_>
+struct radioBand
+{
+    static constexpr U16 FMIN = FMIN_;
+    static constexpr U16 FMAX = FMAX_;
+    static constexpr U8  SPACE = SPACE_;
+    static constexpr U8  RDA_BAND = BAND_;
+    static constexpr U8  TEA_BL = BL_;
+    
+    /* Number of channels (RDA5807M: CHAN [9:0]) */
+    static constexpr U16 CHAN_CNT = ((U32)(FMAX - FMIN) * 10) / SPACE + 1;
+    
+    static_assert((SPACE == 25) || (SPACE == 50) || (SPACE == 100) || (SPACE == 200),
+                  "radioBand: SPACE must be 25, 50, 100 or 200 kHz");
+    static_assert((FMIN < FMAX) && (CHAN_CNT <= 1024),
+                  "radioBand: band does not fit into 10 bit channel");
+    
+    /* RDA5807M SPACE [1:0]: 00=100 kHz; 01=200 kHz; 10=50 kHz; 11=25 kHz */
+    static constexpr U8 RDA_SPACE = (SPACE == 200) ? 1 : (SPACE == 50) ? 2 :
+                                    (SPACE == 25) ? 3 : 0;
+    
+    /* Channel -> frequence [kHz] */
+    static constexpr U32 KHz(U16 iChannel)
+    {
+        return (U32)FMIN * 10 + (U32)iChannel * SPACE;
+    }
+    
+    /* Channel -> frequence [10 kHz] (no division for 50/100/200 kHz) */
+    static constexpr U16 Frequence(U16 iChannel)
+    {
+        return ((SPACE % 10) == 0) ? FMIN + iChannel * (SPACE / 10) :
+                                     FMIN + ((U32)iChannel * SPACE) / 10;
+    }
+    
+    /* Frequence [10 kHz] -> nearest channel (constant -> compile time) */
+    static constexpr U16 Channel(U16 iFrequence)
+    {
+        return (((U32)(iFrequence - FMIN) * 10) + (SPACE / 2)) / SPACE;
+    }
+    
+    static constexpr bool InBand(U16 iFrequence)
+    {
+        return (iFrequence >= FMIN) && (iFrequence <= FMAX);
+    }
+};
+
+/* Predefined bands with 100 kHz spacing (other spacing -> own typedef) */
+typedef radioBand<8700, 10800, 100, 0, 0> radioBandEu;    // 87-108 MHz
+typedef radioBand<7600,  9100, 100, 1, 1> radioBandJp;    // 76-91 MHz
+typedef radioBand<7600, 10800, 100, 2, 0> radioBandWorld; // 76-108 MHz
+typedef radioBand<6500,  7600, 100, 3, 0> radioBandEast;  // 65-76 MHz (RDA)
+
+//------------------------------------------------------------------------------
+/* Compile-time index list 0..N-1 (C++11 has no index_sequence, log depth) */
+template <U16... I> struct radioIndex {};
+
+template <class A, class B> struct radioJoin;
+
+template <U16... I, U16... J>
+struct radioJoin<radioIndex<I...>, radioIndex<J...> >
+{
+    typedef radioIndex<I..., (U16)(sizeof...(I) + J)...> type;
+};
+
+template <U16 N>
+struct radioMakeIndex : radioJoin<typename radioMakeIndex<N / 2>::type,
+                                  typename radioMakeIndex<N - N / 2>::type> {};
+template <> struct radioMakeIndex<0> { typedef radioIndex<> type; };
+template <> struct radioMakeIndex<1> { typedef radioIndex<0> type; };
+
+//------------------------------------------------------------------------------
+/* Radio ChipConfiguration TEA5767 */
+//-----------------------------------------------------------------------------
+// REGISTER: MUTE / TUNING 1
+//-----------------------------------------------------------------------------
+#define TEA_00_REG     0x00 
+#define TEA_00_VALUE   0b00000000 
+    /* DMUTE (7) - mute enable
+     * 0 = normal operation
+     * 1 = L and R audio are muted
+     *
+     * SM (6) - Search mode
+     * 1 = in search mode
+     * 0 = not in search mode
+     *
+     * PLL[5:0] (13:8) - synthesizer programmable counter for search/preset     
+     * 00 0000
+     */
+//-----------------------------------------------------------------------------
+// REGISTER: TUNING 2
+//-----------------------------------------------------------------------------
+#define TEA_01_REG     0x01 
+#define TEA_01_VALUE   0b00000000
+    /* PLL[7:0] (7:0) - synthesizer programmable counter for search/preset     
+     * 0000 0000
+     */
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 1
+//-----------------------------------------------------------------------------
+#define TEA_02_REG     0x02 
+#define TEA_02_VALUE   0b10110000
+    /* SUD (7) - Search Up/Down
+     * 1 = search up
+     * 0 = search down
+     *
+     * SSL[1:0] (6:5) - Search Stop Level
+     * 00 = not allowed in search mode
+     * 01 = low; level ADC output = 5
+     * 10 = mid; level ADC output = 7
+     * 11 = high; level ADC output = 10
+     *
+     * HLSI (4) - High/Low Side Injection
+     * 1 = high side LO injection
+     * 0 = low side LO injection
+     *
+     * MS (3) - Mono to Stereo
+     * 1 = forced mono
+     * 0 = stereo ON
+     *
+     * MR (2) - Mute Right
+     * 1 = the right audio channel is muted and forced mono
+     * 0 = the right audio channel is not muted
+     *
+     * ML (1) - Mute Left
+     * 1 = the left audio channel is muted and forced mono
+     * 0 = the left audio channel is not muted
+     *
+     * SWP1 (0) - Software programmable port 1
+     * 1 = port 1 is HIGH
+     * 0 = port 1 is LOW
+     */  
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 2
+//-----------------------------------------------------------------------------
+#define TEA_03_REG     0x03 
+#define TEA_03_VALUE   0b00010000
+    /* SWP2 (7) - Software programmable port 2
+     * 1 = port 2 is HIGH
+     * 0 = port 2 is LOW
+     *
+     * STBY (6) - Standby
+     * 1 = Standby mode
+     * 0 = not in Standby mode
+     *
+     * BL (5) - Band Limits
+     * 1 = Japanese FM band
+     * 0 = US/Europe FM band
+     *
+     * XTAL (4) - Clock frequency
+     * 00 = 13 MHz
+     * 01 = 32.768 kHz
+     * 10 = 6.5 MHz
+     * 11 = not allowed
+     *
+     * SMUTE (3) - Soft Mute
+     * 1 = soft mute is ON
+     * 0 = soft mute is OFF
+     *
+     * HCC (2) - High Cut Control
+     * 1 = high cut control is ON
+     * 0 = high cut control is OFF
+     *
+     * SNC (1) - Stereo Noise Cancelling
+     * 1 = stereo noise cancelling is ON
+     * 0 = stereo noise cancelling is OFF
+     *
+     * SI (0) - Search Indicator
+     * 1 = pin SWPORT1 is output for the ready flag
+     * 0 = pin SWPORT1 is software programmable port 1
+     */
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 3
+//-----------------------------------------------------------------------------
+#define TEA_04_REG     0x04
+#define TEA_04_VALUE   0x00000000
+    /* PLLREF (7) 
+     * 1 = 6.5 MHz reference frequency for the PLL is enabled
+     * 0 = 6.5 MHz reference frequency for the PLL is disabled (see XTAL)
+     *
+     * DTC (6) 
+     * 1 = the de-emphasis time constant is 75 ms
+     * 0 = the de-emphasis time constant is 50 ms
+     *
+     * RESERVED (5:0) - not used; position is don’t care
+     */
+//-----------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+/* TEA5767 PLL word (high side injection): 4 * (f + 225 kHz) / 32768 Hz */
+constexpr U16 radioTeaPll(U32 kHz)
+{
+    return (U16)((kHz * 1000 + 225000) / 8192);
+}
+
+/* PLL word per channel of BAND (flash, generated at compile time) */
+template <class BAND, class IDX = typename radioMakeIndex<BAND::CHAN_CNT>::type>
+struct radioTeaTable;
+
+template <class BAND, U16... I>
+struct radioTeaTable<BAND, radioIndex<I...> >
+{
+    static const U16 pll[sizeof...(I)];
+    
+    /* PLL word -> nearest channel (binary search, table is ascending) */
+    static U16 Find(U16 iPll)
+    {
+        U16 lo = 0;
+        U16 hi = BAND::CHAN_CNT - 1;
+        while (lo < hi)
+        {
+            U16 mid = (lo + hi) / 2;
+            if (pgm_read_word(&pll[mid]) < iPll)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        U16 pllHi = pgm_read_word(&pll[lo]);
+        if ((lo > 0) && (pllHi > iPll) && 
+            ((pllHi - iPll) > (iPll - pgm_read_word(&pll[lo - 1]))))
+        {
+            lo--;
+        }
+        return lo;
+    }
+};
+
+template <class BAND, U16... I>
+const U16 radioTeaTable<BAND, radioIndex<I...> >::pll[sizeof...(I)] PROGMEM =
+{
+    radioTeaPll(BAND::KHz(I))...
+};
+
+//==============================================================================
+// CHIP POLICY: radioTea5767 - I2C Chip ID = 0x60
+//==============================================================================
+struct radioTea5767
+{
+    /* regBuffer: write frame [0..4], read frame [5..9] */
+    static constexpr U8  ICC_ADDR = 0x60;
+    static constexpr U8  BUF_SIZE = 10;
+    static constexpr U8  READ_OFS = 5;
+    static constexpr U8  SEND_LEN = 5;
+    static constexpr U8  READ_LEN = 5;
+    static constexpr U8  SEEK_LEN = 5;
+    static constexpr U8  SIG_LEN  = 5;
+    static constexpr U8  STAT_LEN = 5;
+    static constexpr bool HAS_RDS = false;
+    
+    /* Single register write: I2C address offset */
+    static constexpr U8  REG_ADDR = 0;
+    
+    //--------------------------------------------------------------------------
+    static void InitBuffer(U8 *reg)
+    {
+        reg[TEA_00_REG] = TEA_00_VALUE;                                                    
+        reg[TEA_01_REG] = TEA_01_VALUE; 
+        reg[TEA_02_REG] = TEA_02_VALUE;
+        reg[TEA_03_REG] = TEA_03_VALUE;
+        reg[TEA_04_REG] = TEA_04_VALUE;         
+    }
+    
+    /* BL [5] - Japanese FM band (seek limits), spacing by PLL table */
+    template <class BAND>
+    static void SetBand(U8 *reg)
+    {
+        if (BAND::TEA_BL == 0)
+            reg[TEA_03_REG] &= (~0x20);
+        else
+            reg[TEA_03_REG] |= 0x20;
+    }
+    
+    //--------------------------------------------------------------------------
+    static U8 PowerUp(U8 *reg, U8 state, U8 *msgLen, U16 *msWait)
+    {
+        (void)reg;
+        (void)state;
+        *msgLen = SEND_LEN;
+        *msWait = 100;
+        return RADIO_STATE_READY;
+    }
+    
+    //--------------------------------------------------------------------------
+    static U8 DirtyBit(U8 iRegister) { return (1 << iRegister); }
+    
+    /* TEA5767 has no register address -> always one 5 byte frame */
+    static U8 CommitLen(U8 dirtyMask, U8 *pReg)
+    {
+        (void)dirtyMask;
+        (void)pReg;
+        return SEND_LEN;
+    }
+    
+    /* Search mode is a command -> do not repeat with next frame */
+    static void CommitDone(U8 *reg) { reg[TEA_00_REG] &= (~0x40); }
+    
+    //--------------------------------------------------------------------------
+    static U8 RegisterFrame(const U8 *reg, U8 iRegister, U8 *frame)
+    {
+        frame[0] = iRegister;
+        frame[1] = reg[iRegister];
+        return 2;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* PLL word from table -> no 32 bit multiply/divide on tune */
+    template <class BAND>
+    static U8 Channel(U8 *reg, U16 iChannel)
+    {
+        U16 pll = pgm_read_word(&radioTeaTable<BAND>::pll[iChannel]);
+        reg[TEA_00_REG] = ((pll >> 8) & 0x3F);
+        reg[TEA_01_REG] = pll & 0XFF;                      
+        return TEA_00_REG;
+    }
+    
+    static U8 Volume(U8 *reg, U8 iVolume)
+    {
+        (void)reg;
+        (void)iVolume;
+        return RADIO_REG_NONE;
+    }
+    
+    /* Mute_On:MR[2]=1,ML[1]=1; Mute_Off:MR[2]=00,ML[1]=0 (0x06) */
+    static U8 Mute(U8 *reg, bool bMute)
+    {
+        if (bMute == 0)         
+            reg[TEA_02_REG] &= (~0x06);     
+        else
+            reg[TEA_02_REG] |= 0x06;     
+        return TEA_02_REG;
+    }
+    
+    static U8 Bass(U8 *reg, bool bBass)
+    {
+        (void)reg;
+        (void)bBass;
+        return RADIO_REG_NONE;
+    }
+    
+    /* Mono_On:MS[3]=1; Mono_Off/Stereo:MS[3]=0; (0x08) */
+    static U8 Mono(U8 *reg, bool bMono)
+    {
+        if (bMono == 0)         
+            reg[TEA_02_REG] &= (~0x08);    
+        else
+            reg[TEA_02_REG] |= 0x08;     
+        return TEA_02_REG;
+    }
+    
+    static U8 Rds(U8 *reg, bool bRds)
+    {
+        (void)reg;
+        (void)bRds;
+        return RADIO_REG_NONE;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* Search starts 100 kHz beside the tuned channel, stops at band limit */
+    template <class BAND>
+    static U8 SeekStart(U8 *reg, U16 *pChan, bool bUp, bool bWrap)
+    {
+        (void)bWrap;
+        const U16 step = (BAND::SPACE < 100) ? (100 / BAND::SPACE) : 1;
+        if (bUp)
+            *pChan = (*pChan + step < BAND::CHAN_CNT) ? (*pChan + step) : 0;
+        else
+            *pChan = (*pChan >= step) ? (*pChan - step) : (BAND::CHAN_CNT - 1);
+        Channel<BAND>(reg, *pChan);
+        
+        /* SM [6]; SUD [7] */
+        reg[TEA_00_REG] |= 0x40;
+        if (bUp)
+            reg[TEA_02_REG] |= 0x80;
+        else
+            reg[TEA_02_REG] &= (~0x80);
+        return TEA_00_REG;
+    }
+    
+    template <class BAND>
+    static U8 SeekStatus(U8 *reg, U16 *pChan, radioStation *pEntry)
+    {
+        /* RF [7] ready flag; BLF [6] band limit reached */
+        U8 status = reg[READ_OFS + TEA_00_REG];
+        if ((status & 0x80) == 0)
+            return RADIO_SEEK_RUN;
+        
+        /* PLL -> nearest channel of band (table search, no division) */
+        U16 pll = ((status & 0x3F) << 8) | reg[READ_OFS + TEA_01_REG];
+        *pChan = radioTeaTable<BAND>::Find(pll);
+        reg[TEA_00_REG] = (status & 0x3F);
+        reg[TEA_01_REG] = reg[READ_OFS + TEA_01_REG];
+        
+        pEntry->stRssi = reg[READ_OFS + TEA_03_REG] >> 4;
+        pEntry->stFlags = (reg[READ_OFS + TEA_02_REG] & 0x80) ? RADIO_ST_STEREO : 0;
+        return (status & 0x40) ? RADIO_SEEK_FAIL : RADIO_SEEK_DONE;
+    }
+    
+    //--------------------------------------------------------------------------
+    static U8 SignalLevel(const U8 *reg, U8 *sigLevel, U8 *bStereo)
+    {
+        *bStereo = (reg[READ_OFS + TEA_02_REG] & 0x80) ?  1 : 0;
+        *sigLevel = (reg[READ_OFS + TEA_03_REG] >> 4);
+        return (reg[READ_OFS + TEA_00_REG] == 0) ? 0 : 1;
+    }
+    
+    /* RF [7] ready flag; STEREO [7]; IF counter [6:0] 0x31..0x3E = station */
+    /* No tune complete flag in preset mode -> always tuned */
+    static U8 SignalSample(const U8 *reg, U8 *pRssi, bool *pStereo)
+    {
+        U8 ifCount = reg[READ_OFS + TEA_02_REG] & 0x7F;
+        U8 flags = RADIO_SG_TUNED;
+        *pRssi = reg[READ_OFS + TEA_03_REG] >> 4;
+        *pStereo = (reg[READ_OFS + TEA_02_REG] & 0x80) != 0;
+        if (reg[READ_OFS + TEA_00_REG] & 0x80)
+            flags |= RADIO_SG_READY;
+        if ((ifCount >= 0x31) && (ifCount <= 0x3E))
+            flags |= RADIO_SG_STATION;
+        return flags;
+    }
+    
+    static bool RdsGroup(const U8 *reg, U16 *pBlock, U8 *pErr)
+    {
+        (void)reg;
+        (void)pBlock;
+        (void)pErr;
+        return false;
+    }
+};
+
+//------------------------------------------------------------------------------
+/* Radio ChipConfiguration RDA5807M */
+#define RDA_00_REG    0x00 // Register not writable: CHIP ID
+#define RDA_01_REG    0x01 // Register not writable: unused!
+//-----------------------------------------------------------------------------
+// ### WRITE REGISTER ###
+//-----------------------------------------------------------------------------
+// REGISTER: MODE and OPTIONS
+//-----------------------------------------------------------------------------
+#define RDA_02_REG    0x02
+#define RDA_H2_BUF    0x00
+#define RDA_H2_VALUE  0b11000000
+    /* DHIZ (15) - audio output high-z disable
+     * 1 = normal operation
+     *
+     * DMUTE (14) - mute disable 
+     * 1 = normal operation
+     *
+     * MONO (13) - mono select
+     * 0 = stereo
+     *
+     * BASS (12) - bass boost
+     * 0 = disabled
+     *
+     * RCLK NON CALIBRATE MODE (11)
+     * 0 = RCLK is always supplied
+     *
+     * RCLK DIRECT INPUT MODE (10)
+     * 0 = ??? not certain what this does
+     *
+     * SEEKUP (9)
+     * 0 = seek in down direction
+     *
+     * SEEK (8)
+     * 0 = disable / stop seek (i.e. don't seek)
+     */                      
+#define RDA_L2_BUF    0x01
+#define RDA_L2_VALUE  0b00000000
+    /* SKMODE (7) - seek mode: 
+     * 0 = wrap at upper or lower band limit and contiue seeking
+     *
+     * CLK_MODE (6:4) - clock mode
+     * 000 = 32.768kHZ clock rate (match the watch cystal on the module) 
+     *
+     * RDS_EN (3) - radio data system enable
+     * 0 = disable radio data system
+     *
+     * NEW_METHOD (2) - use new demodulate method for improved sensitivity
+     * 0 = presumably disabled 
+     *
+     * SOFT_RESET (1)
+     * 1 = perform a reset
+     *
+     * ENABLE (0) - power up enable 
+     * 0 = enabled
+     */     
+//-----------------------------------------------------------------------------
+// REGISTER: TUNING
+//-----------------------------------------------------------------------------
+#define RDA_03_REG    0x03
+#define RDA_H3_BUF    0x02
+#define RDA_H3_VALUE  0b00000000
+    /* CHAN (15:8) - channel select 8 most significant bits of 10 in total
+     * 0000 0000 = don't boher to program a channel at this time
+     */  
+#define RDA_L3_BUF    0x03
+#define RDA_L3_VALUE  0b00000000
+    /* CHAN (7:6) - two least significant bits of 10 in total 
+     * 00 = don't bother to program a channel at this time
+     *
+     * DIRECT MODE (5) - used only when test
+     * 0 = presumably disabled
+     *
+     * TUNE (4) - commence tune operation 
+     * 0 = disable (i.e. don't tune to selected channel)
+     *
+     * BAND (3:2) - band select
+     * 00 = select the 87-108MHz band
+     *
+     * SPACE (1:0) - channel spacing
+     * 00 = select spacing of 100kHz between channels     
+     * 01 = 200 kHz
+     * 10 = 50kHz
+     * 11 = 25KHz
+     */                   
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 1
+//-----------------------------------------------------------------------------
+#define RDA_04_REG    0x04
+#define RDA_H4_BUF    0x04
+#define RDA_H4_VALUE  0b00000000 
+    /* RESERVED (15)
+     *
+     * STCIEN (14) - Seek/Tune Complete Interrupt Enable
+     * 0 = Disable Interrupt
+     * 1 = Enable Interrupt
+     *
+     * RBDS (13)
+     * 1 = RBDS mode enable
+     * 0 = RDS mode only
+     *
+     * RDS_FIFO_EN (12)
+     * 1 = RDS fifo mode enable
+     *
+     * DE de-emphasis (11)
+     * 0 = 75 μs 
+     * 1 = 50 μs
+     *
+     * RDS_FIFO_CLR (10)
+     * 1 = clear RDS fifoRE
+     *
+     * SOFTMUTE_EN (9)
+     * 1 = soft mute enabled
+     *
+     * AFCD (8) - AFC disable
+     * 0 = AFC enabled
+     */               
+#define RDA_L4_BUF    0x05
+#define RDA_L4_VALUE  0b01000000
+    /* RSVD (7) 
+     * Read as 0!
+     *
+     * I2S_ENABLE (6)    
+     * 0 = disabled
+     * 1 = enabled
+     *
+     * GPIO3[1:0] (5:4) - General Purpose I/O 3
+     * 00 = High impedance
+     * 01 = Mono/Stereo indicator (ST)
+     * 10 = Low
+     * 11 = High
+     *
+     * GPIO2[1:0] (3:2) - General Purpose I/O 2
+     * 00 = High impedance
+     * 01 = Interrupt (INT)
+     * 10 = Low
+     * 11 = High
+     *
+     * GPIO1[1:0] (1:0) - General Purpose I/O 1
+     * 00 = High impedance
+     * 01 = Reserved
+     * 10 = Low
+     * 11 = High
+     */ 
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 2
+//-----------------------------------------------------------------------------
+#define RDA_05_REG    0x05
+#define RDA_H5_BUF    0x06
+#define RDA_H5_VALUE  0b10010000
+    /* INT_MODE (15)
+     * 1 = interrupt last until read reg 0x0C
+     *
+     * SEEK:MODE[1:0] (14:13) 
+     * 00=Default; 10=will add the RSSI seek mode
+     *
+     * RSVD (12)
+     *
+     * SEEKTH[3:0] (11:8) - Seek signal to noise ratio threshold
+     * 1000 = suggested defaultSeek SNR threshold
+     */   
+#define RDA_L5_BUF    0x07
+#define RDA_L5_VALUE  0b11101000
+    /* LNA_PORT_SEL[1:0] (7:6) - LNA input port selection bit
+     * 00 = no input
+     * 01 = LNAN
+     * 10 = LNAP
+     * 11 = dual port input
+     *
+     * LNA_ICSEL_BIT[1:0] (5:4) - Lna working current bit
+     * 00 = 1.8mA
+     * 01 = 2.1mA
+     * 10 = 2.5mA
+     * 11 = 3.0mA    
+     *
+     * VOLUME[3:0] (3:0) - Changel output volume
+     * 1111 = loudest volume
+     */                 
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 3
+//-----------------------------------------------------------------------------
+#define RDA_06_REG    0x06
+#define RDA_H6_BUF    0x08
+#define RDA_H6_VALUE  0b00000000
+    /* RESERVED (15)
+     * 0
+     *
+     * OPEN_MODE[1:0] (14:13) - open reserved registers mode
+     * 00 = suggested default
+     
+     * SLAVE_MASTER (12) - slave_master I2S slave or master
+     * 1 = slave; 0 = master
+     *
+     * WS_LR (11) - Ws relation to l/r channel
+     * 0 = ws=0 ->r, ws=1 ->l
+     * 1 = ws=0 ->l, ws=1 ->r
+     * 
+     * SCLK_I_EDGE (10)
+     * 0 = use normal sclk internally
+     * 1 = inverte sclk internally
+     *
+     * DATA_SIGNED (9)
+     * 0 = I2S output unsigned 16-bit audio data
+     * 1 = I2S output signed 16-bit audio data
+     *
+     * WS_I_EDGE (8)
+     * 0 = use normal ws internally
+     * 1 = inverte ws internally
+     */     
+#define RDA_L6_BUF    0x09
+#define RDA_L6_VALUE  0b00000000
+    /* I2S_SW_CNT[3:0] (7:4) - Only valid in master mode
+     * 4'b1000 = WS_STEP = 48
+     * 4'b0111 = WS_STEP = 44.1kbps
+     * 4'b0110 = WS_STEP = 32kbps
+     * 4'b0101 = WS_STEP = 24kbps
+     * 4'b0100 = WS_STEP = 22.05kbps
+     * 4'b0011 = WS_STEP = 16kbps
+     * 4'b0010 = WS_STEP = 12kbps
+     * 4'b0001 = WS_STEP = 11.025kbps
+     * 4'b0000 = WS_STEP = 8kbps
+     *
+     * SW_O_EDGE (3)
+     * 1 = invert ws output when as master 
+     *
+     * SCLK_O_EDGE (2)
+     * 1 = invert sclk output when as master
+     *
+     * L_DELY (1)
+     * 1 = L channel data delay 1T
+     *
+     * R_DELY (0)
+     * 1 = R channel data delay 1T     
+     */          
+//-----------------------------------------------------------------------------
+// REGISTER: CONFIGURATION 4
+//-----------------------------------------------------------------------------
+#define RDA_07_REG    0x07
+#define RDA_H7_BUF    0x0A
+#define RDA_H7_VALUE  0b01000010
+    /* RESERVED (15) 
+     * 0
+     *
+     * TH_SOFRBLEND[4:0] (14:10) - threshhold for noise soft blend setting
+     * 10000 = using default value
+     *
+     * 65M_50M MODE (9) - Valid when band[1:0] = 2’b11 (0x03H_bit<3:2>)      
+     * 1 = 65~76 MHz
+     * 0 = 50~76 MHz
+     *
+     * RESERVED (8)
+     * 0
+     */        
+#define RDA_L7_BUF    0x0B
+#define RDA_L7_VALUE  0b00000010
+    /* SEEK_TH_OLD seek[5:0] (7:2) - threshold for old seek mode
+     * 000000
+     *
+     * SOFTBLEND_EN (1) - soft blend enable
+     * 1 = using default value
+     *
+     * FREQ_MODE (0)
+     * 0 = using defualt value
+     * 1 = then freq setting changed
+     * Freq = 76000(or 87000) kHz + freq_direct (08H) kHz
+     */        
+//-----------------------------------------------------------------------------
+// REGISTER: FREQUENCE SELECT
+//-----------------------------------------------------------------------------
+#define RDA_08_REG    0x08
+#define RDA_H8_BUF    0x0C
+#define RDA_H8_VALUE  0b00000000
+    /* FREQ_DIRECT (15:8) - HI-BYTE - Valid when FREQ_MODE = 1
+     * 0000 0000 
+     */    
+#define RDA_L8_BUF    0x0D
+#define RDA_L8_VALUE  0b00000000
+    /* FREQ_DIRECT (7:0) - HI-BYTE - Valid when FREQ_MODE = 1
+     * 0000 0000 
+     */    
+//-----------------------------------------------------------------------------
+// REGISTER: 09 UNUSED II
+//-----------------------------------------------------------------------------
+#define RDA_09_REG    0x09 // Register not used
+//-----------------------------------------------------------------------------
+// ### READ REGISTER ###
+//-----------------------------------------------------------------------------
+// REGISTER: STATUS I
+//-----------------------------------------------------------------------------
+#define RDA_10_REG    0x0A
+#define RDA_H0_STATUS 0x10
+#define RDA_L0_STATUS 0x11
+    /* RDS READY (15) 
+     * 0 = No RDS/RBDS group ready(default)
+     * 1 = New RDS/RBDS group ready
+     *
+     * STC Seek/Tune Complete  (14)
+     * 0 = Not complete
+     * 1 = Complete
+     *
+     * SF Seek Fail (13)
+     * 0 = Seek successful
+     * 1 = Seek failure
+     *
+     * RDSS RDS Synchronization (12)
+     * 0 = RDS decoder not synchronized(default)
+     * 1 = RDS decoder synchronized
+     *
+     * BLK_E When RDS enable (11)
+     * 1 = Block E has been found
+     * 0 = no Block E has been found
+     * 
+     * ST Stereo Indicator (10)
+     * 0 = Mono
+     * 1 = Stereo
+     * 
+     * READCHAN[9:0] (9:0) Read Channel
+     * Frequency = Channel Spacing (kHz) x READCHAN[9:0] + 87.0 MHz
+     */        
+//-----------------------------------------------------------------------------
+// REGISTER: STATUS II
+//-----------------------------------------------------------------------------
+#define RDA_11_REG    0x0B
+#define RDA_H1_STATUS 0x12
+#define RDA_L1_STATUS 0x13          
+    /* RSSI[6:0] (15:9)
+     * 0000000 = min
+     * 1111111 = max -> RSSI scale is logarithmic.
+     * 
+     * FM TRUE (8)
+     * 1 = the current channel is a station
+     * 0 = the current channel is not a station
+     *      
+     * FM_READY (7) 
+     * 1=ready;  0=not ready
+     * 
+     * RESERVED (6:5) 
+     * 00
+     *
+     * ABCD_E (4) 
+     * 1 = the block id of register 0cH, 0dH, 0eH, 0fH is E
+     * 0 = the block id of register 0cH, 0dH, 0eH, 0fH is A, B, C, D     
+     *     
+     * BLERA[1:0] (3:2)
+     * Block Errors Level of RDS_DATA_0
+     * BLERB[1:0] (1:0)
+     * Block Errors Level of RDS_DATA_1
+     * (see documentation of RDA5708)     
+     */         
+//-----------------------------------------------------------------------------
+// REGISTER: RDS - RADIO DATA SYSTEM 
+//-----------------------------------------------------------------------------
+    /* register 0x0C = READ REGEISTER 3 - RDS BLOCK A / E */  
+#define RDA_12_REG    0x0C
+#define RDA_H2_STATUS 0x14
+#define RDA_L2_STATUS 0x15          
+    /* register 0x0D = READ REGEISTER 4 - RDS BLOCK B / E */  
+#define RDA_13_REG    0x0D
+#define RDA_H3_STATUS 0x16
+#define RDA_L3_STATUS 0x17          
+    /* register 0x0E = READ REGEISTER 5 - RDS BLOCK C / E */       
+#define RDA_14_REG    0x0E
+#define RDA_H4_STATUS 0x18
+#define RDA_L4_STATUS 0x19            
+    /* register 0x0F = READ REGEISTER 6 - RDS BLOCK D / E */  
+#define RDA_15_REG    0x0F
+#define RDA_H5_STATUS 0x1A
+#define RDA_L5_STATUS 0x1B          
+//-----------------------------------------------------------------------------
+// END OF CONFIG AND DATA STRUCTURE
+//-----------------------------------------------------------------------------
+
+/* Transfer length */
+#define RDA_INIT_LEN    8
+#define RDA_TUNE_LEN    4
+
+/* Set by user before power-up: DMUTE, MONO, BASS [14:12]; RDS_EN [3] */
+#define RDA_H2_USER     0b01110000
+#define RDA_L2_USER     0b00001000
+
+//==============================================================================
+// CHIP POLICY: radioRda5807m - I2C Chip ID = 0x10 (0x11 random access)
+//==============================================================================
+struct radioRda5807m
+{
+    /* regBuffer: write register 0x02..0x05 [0..7], read 0x0A..0x0F [16..27] */
+    static constexpr U8  ICC_ADDR = 0x10;
+    static constexpr U8  BUF_SIZE = 28;
+    static constexpr U8  READ_OFS = 16;
+    static constexpr U8  SEND_LEN = RDA_INIT_LEN;
+    static constexpr U8  READ_LEN = 2;
+    static constexpr U8  SEEK_LEN = 4;
+    static constexpr U8  SIG_LEN  = 4;
+    static constexpr U8  STAT_LEN = 12;
+    static constexpr bool HAS_RDS = true;
+    
+    /* Single register write: I2C address offset */
+    static constexpr U8  REG_ADDR = 1;
+    
+    //--------------------------------------------------------------------------
+    static void InitBuffer(U8 *reg)
+    {
+        reg[RDA_H2_BUF] = RDA_H2_VALUE;
+        reg[RDA_L2_BUF] = RDA_L2_VALUE;
+        reg[RDA_H3_BUF] = RDA_H3_VALUE;
+        reg[RDA_L3_BUF] = RDA_L3_VALUE;
+        reg[RDA_H4_BUF] = RDA_H4_VALUE;
+        reg[RDA_L4_BUF] = RDA_L4_VALUE;
+        reg[RDA_H5_BUF] = RDA_H5_VALUE;
+        reg[RDA_L5_BUF] = RDA_L5_VALUE;
+    }
+    
+    /* BAND [3:2]; SPACE [1:0] -> channel 0 = BAND::FMIN */
+    template <class BAND>
+    static void SetBand(U8 *reg)
+    {
+        reg[RDA_L3_BUF] = (reg[RDA_L3_BUF] & 0xF0) | 
+                          (BAND::RDA_BAND << 2) | BAND::RDA_SPACE;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* Mute, mono, bass and RDS set before power-up stay in shadow */
+    static U8 PowerUp(U8 *reg, U8 state, U8 *msgLen, U16 *msWait)
+    {
+        reg[RDA_H2_BUF] &= RDA_H2_USER;
+        reg[RDA_L2_BUF] &= RDA_L2_USER;
+        switch (state)
+        {
+            case RADIO_STATE_POWER:
+                /* Soft reset */
+                reg[RDA_L2_BUF] |= 0x02;
+                *msgLen = RDA_INIT_LEN;
+                *msWait = 500;
+                return RADIO_STATE_ENABLE;
+                
+            case RADIO_STATE_ENABLE:
+                reg[RDA_H2_BUF] |= 0x80; 
+                reg[RDA_L2_BUF] |= 0x01;
+                *msgLen = RDA_INIT_LEN;
+                *msWait = 10;
+                return RADIO_STATE_TUNE;
+        }
+        
+        /* Tune channel in shadow (default or set before power-up) */
+        reg[RDA_H2_BUF] |= 0b10000000;
+        reg[RDA_L2_BUF] |= 0b00000001;    
+        reg[RDA_L3_BUF] |= 0b00010000;    
+        *msgLen = RDA_TUNE_LEN;
+        *msWait = 100;
+        return RADIO_STATE_READY;
+    }
+    
+    //--------------------------------------------------------------------------
+    static U8 DirtyBit(U8 iRegister) { return (1 << (iRegister - RDA_02_REG)); }
+    
+    /* Sequential write starts at register 0x02 -> find highest dirty */
+    static U8 CommitLen(U8 dirtyMask, U8 *pReg)
+    {
+        U8 regHigh = RDA_02_REG;
+        for (U8 i=0; i<(RDA_INIT_LEN / 2); i++)
+        {
+            if (dirtyMask & (1 << i))
+            {
+                regHigh = RDA_02_REG + i;
+            }
+        }
+        U8 seqLen = (regHigh - RDA_02_REG + 1) * 2;
+        
+        /* Single register: random access (3 byte) if shorter than burst */
+        if (((dirtyMask & (dirtyMask - 1)) == 0) && (seqLen > 3))
+        {
+            *pReg = regHigh;
+            return 0;
+        }
+        return seqLen;
+    }
+    
+    /* TUNE and SEEK are commands -> do not repeat with next burst */
+    static void CommitDone(U8 *reg)
+    {
+        reg[RDA_L3_BUF] &= (~0x10);
+        reg[RDA_H2_BUF] &= (~0x01);
+    }
+    
+    //--------------------------------------------------------------------------
+    static U8 RegisterFrame(const U8 *reg, U8 iRegister, U8 *frame)
+    {
+        U8 bufOffset = (iRegister * 2) - 4;
+        frame[0] = iRegister;
+        frame[1] = reg[bufOffset];
+        frame[2] = reg[bufOffset + 1];
+        return 3;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* CHAN [15:6] is the channel index; keep BAND/SPACE; TUNE [4] */
+    template <class BAND>
+    static U8 Channel(U8 *reg, U16 iChannel)
+    {
+        reg[RDA_H3_BUF] = (iChannel >> 2); 
+        reg[RDA_L3_BUF] = (reg[RDA_L3_BUF] & 0x2F) | 
+                          ((iChannel & 0b11) << 6 ) | 0b00010000;     
+        return RDA_03_REG;
+    }
+    
+    static U8 Volume(U8 *reg, U8 iVolume)
+    {
+        reg[RDA_L5_BUF] &= (~0x0F);
+        reg[RDA_L5_BUF] |= iVolume;       
+        return RDA_05_REG;
+    }
+    
+    static U8 Mute(U8 *reg, bool bMute)
+    {
+        if (bMute == 0)         
+            reg[RDA_H2_BUF] |= 0x40;
+        else
+            reg[RDA_H2_BUF] &= (~0x40);    
+        return RDA_02_REG;
+    }
+    
+    static U8 Bass(U8 *reg, bool bBass)
+    {
+        if (bBass == 0)                 
+            reg[RDA_H2_BUF] &= (~0x10);    
+        else
+            reg[RDA_H2_BUF] |= 0x10;
+        return RDA_02_REG;
+    }
+    
+    static U8 Mono(U8 *reg, bool bMono)
+    {
+        if (bMono == 0)         
+            reg[RDA_H2_BUF] |= 0x20;
+        else
+            reg[RDA_H2_BUF] &= (~0x20);    
+        return RDA_02_REG;
+    }
+    
+    /* RDS_EN [3] */
+    static U8 Rds(U8 *reg, bool bRds)
+    {
+        if (bRds == 0)         
+            reg[RDA_L2_BUF] &= (~0x08);
+        else
+            reg[RDA_L2_BUF] |= 0x08;    
+        return RDA_02_REG;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* SEEK [8]; SEEKUP [9]; SKMODE [7] (bWrap=false -> stop at band limit) */
+    template <class BAND>
+    static U8 SeekStart(U8 *reg, U16 *pChan, bool bUp, bool bWrap)
+    {
+        (void)pChan;
+        reg[RDA_H2_BUF] |= 0x01;
+        if (bUp)
+            reg[RDA_H2_BUF] |= 0x02;
+        else
+            reg[RDA_H2_BUF] &= (~0x02);
+        if (bWrap)
+            reg[RDA_L2_BUF] &= (~0x80);
+        else
+            reg[RDA_L2_BUF] |= 0x80;
+        return RDA_02_REG;
+    }
+    
+    template <class BAND>
+    static U8 SeekStatus(U8 *reg, U16 *pChan, radioStation *pEntry)
+    {
+        /* STC [14] seek complete; SF [13] seek fail */
+        U8 status = reg[RDA_H0_STATUS];
+        if ((status & 0x40) == 0)
+            return RADIO_SEEK_RUN;
+        
+        /* READCHAN [9:0] -> keep channel in shadow without TUNE bit */
+        U16 channel = ((status & 0x03) << 8) | reg[RDA_L0_STATUS];
+        *pChan = channel;
+        reg[RDA_H3_BUF] = (channel >> 2);
+        reg[RDA_L3_BUF] = (reg[RDA_L3_BUF] & 0x2F) | ((channel & 0b11) << 6);
+        
+        pEntry->stRssi = reg[RDA_H1_STATUS] >> 1;
+        pEntry->stFlags = (status & 0x04) ? RADIO_ST_STEREO : 0;
+        return (status & 0x20) ? RADIO_SEEK_FAIL : RADIO_SEEK_DONE;
+    }
+    
+    //--------------------------------------------------------------------------
+    /* RSSI [15:9] (0x0B); ST [10] (0x0A); return FM_TRUE [8] */
+    static U8 SignalLevel(const U8 *reg, U8 *sigLevel, U8 *bStereo)
+    {
+        *bStereo = (reg[RDA_H0_STATUS] & 0x04) ? 1 : 0;
+        *sigLevel = reg[RDA_H1_STATUS] >> 1;
+        return reg[RDA_H1_STATUS] & 0x01;
+    }
+    
+    /* STC [14]; ST [10]; RSSI [15:9]; FM_TRUE [8]; FM_READY [7] */
+    static U8 SignalSample(const U8 *reg, U8 *pRssi, bool *pStereo)
+    {
+        U8 flags = 0;
+        *pRssi = reg[RDA_H1_STATUS] >> 1;
+        *pStereo = (reg[RDA_H0_STATUS] & 0x04) != 0;
+        if (reg[RDA_H0_STATUS] & 0x40)
+            flags |= RADIO_SG_TUNED;
+        if (reg[RDA_H1_STATUS] & 0x01)
+            flags |= RADIO_SG_STATION;
+        if (reg[RDA_L1_STATUS] & 0x80)
+            flags |= RADIO_SG_READY;
+        return flags;
+    }
+    
+    /* RDSR [15] - new group ready in 0x0C..0x0F */
+    static bool RdsGroup(const U8 *reg, U16 *pBlock, U8 *pErr)
+    {
+        if ((reg[RDA_H0_STATUS] & 0x80) == 0)
+            return false;
+        
+        pBlock[0] = (reg[RDA_H2_STATUS] << 8) | reg[RDA_L2_STATUS];
+        pBlock[1] = (reg[RDA_H3_STATUS] << 8) | reg[RDA_L3_STATUS];
+        pBlock[2] = (reg[RDA_H4_STATUS] << 8) | reg[RDA_L4_STATUS];
+        pBlock[3] = (reg[RDA_H5_STATUS] << 8) | reg[RDA_L5_STATUS];
+        *pErr = reg[RDA_L1_STATUS] & 0x0F;
+        return true;
+    }
+};
+
+#endif // _CPP_DEFRADIOCHIP
@@ -16,15 +16,39 @@
 #define FS20_ZERO         400     //   400uS
 #define FS20_ONE          600     //   600uS
 #define FS20_PAUSE         10     // 10000mS
+#define FS20_GAP         8000     //  8000uS between repetitions
 
 //------------------------------------------------------------------------------
 #define FS20_MAX_SYNC      12
 #define FS20_REP_CNT        3
 
+/* Duty cycle slot length [ms] and admission result */
+#define FS20_DC_SLOT_MS    (3600000UL / FS20_DC_SLOTS)
+#define FS20_DC_SEND        0
+#define FS20_DC_DEFER       1
+#define FS20_DC_DROP        2
+
+//------------------------------------------------------------------------------
+#if defined(FS20_TX_TIMER1) && !defined(__AVR__)
+  #pragma message ("+++WARNING: FS20_TX_TIMER1 only on AVR, use Tick()!+++")
+  #undef FS20_TX_TIMER1
+#endif
+
+/* Data pin output */
+#ifdef FS20_DATA_PIN
+  #define FS20_PIN_WRITE(b)  FS20_DATA_PIN::Write(b)
+#else
+  #define FS20_PIN_WRITE(b)  fs20DataPin.Write(b)
+#endif
+
+
 //------------------------------------------------------------------------------
 #define FS20_SWITCH_OFF    0x00
 #define FS20_SWITCH_ON     0x10
+#define FS20_SWITCH_OLD    0x11
 #define FS20_SWITCH_TOGGLE 0x12
+#define FS20_DIMM_UP       0x13
+#define FS20_DIMM_DOWN     0x14
 
 //------------------------------------------------------------------------------
 // FS20 Bit Sample Telegram (Reference):
@@ -50,13 +74,69 @@ U8 bit_buffer[BIT_BUFFER_SIZE] =
 };               
 #endif
 
+#ifdef FS20_TX_TIMER1
+//------------------------------------------------------------------------------
+// Timer1 compare interrupt - next edge of active transmitter
+//------------------------------------------------------------------------------
+static objFs20 *txOwner = NULL;
+
+ISR(TIMER1_COMPA_vect)
+{
+    U16 usWait = txOwner->TxEdge();
+    if (usWait == 0)
+    {
+        TIMSK1 &= ~(1 << OCIE1A);
+        TCCR1B = 0;
+    }
+    else
+    {
+        /* CTC: counter restarted at match -> exact interval */
+        OCR1A = FS20_TIMER_TICKS(usWait, F_CPU) - 1;
+    }
+}
+#endif
+
 //------------------------------------------------------------------------------
 // Class Constructor
 //------------------------------------------------------------------------------
 objFs20::objFs20(void)
 {    
-    fs20Index = 0;
-    fs20DataPin = 0;    
+#if FS20_CACHE_LEN > 0
+    cacheCnt = 0;
+#endif
+    statHit = 0;
+    statMiss = 0;
+    txBusy = false;
+    txActive = false;
+    txBit = 0;
+    txRep = 0;
+    txHigh = false;
+    doneFunc = NULL;
+    pScene = NULL;
+    sceneCnt = 0;
+    sceneIdx = 0;
+    txScene = false;
+    for (U8 i=0; i<FS20_RAMP_CNT; i++)
+    {
+        rampTable[i].stepCnt = 0;
+    }
+    rampCnt = 0;
+    cmdCnt = 0;
+    statMerged = 0;
+    statDropped = 0;
+    for (U8 i=0; i<FS20_DC_SLOTS; i++)
+    {
+        dcSlot[i] = 0;
+    }
+    dcIndex = 0;
+    dcSlotNum = 0;
+    dcLimit = FS20_DC_LIMIT;
+    statDeferred = 0;
+    statDcDropped = 0;
+#ifndef FS20_TX_TIMER1
+    txEdgeTime = 0;
+    txWait = 0;
+#endif
 }
 
 //------------------------------------------------------------------------------
@@ -64,57 +144,683 @@ objFs20::objFs20(void)
 //------------------------------------------------------------------------------
 bool objFs20::Init(U8 dataPin)
 {
-    fs20DataPin = dataPin;
-    pinMode(fs20DataPin, OUTPUT);
-    digitalWrite(fs20DataPin, 0);
+#ifdef FS20_DATA_PIN
+    (void)dataPin;
+    FS20_DATA_PIN::Output();
+#else
+    if (!fs20DataPin.Bind(dataPin, OUTPUT))
+    {
+        return false; // ERROR
+    }
+#endif
+    FS20_PIN_WRITE(0);
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Send FS20 Actor Data in background (3x telegram), FALSE if queue full
+//------------------------------------------------------------------------------
+bool objFs20::Send(U16 homeCode, U8 addrByte, U8 cmdByte)
+{
+    U8 cmdPrio = (cmdByte == FS20_SWITCH_OFF) ? FS20_PRIO_HIGH : FS20_PRIO_NORMAL;
+    return SendPrio(homeCode, addrByte, cmdByte, cmdPrio);
+}
+
+//------------------------------------------------------------------------------
+// Send with priority, FALSE if not queued
+//------------------------------------------------------------------------------
+bool objFs20::SendPrio(U16 homeCode, U8 addrByte, U8 cmdByte, U8 cmdPrio)
+{
+    /* Absolute command supersedes pending commands for covered actors */
+    if (cmdByte <= FS20_SWITCH_OLD)
+    {
+        U8 i = 0;
+        while (i < cmdCnt)
+        {
+            if ((cmdQueue[i].homeCode == homeCode) && 
+                cmdCovers(addrByte, cmdQueue[i].addrByte))
+            {
+                cmdRemove(i);
+                statMerged++;
+            }
+            else
+            {
+                i++;
+            }
+        }
+    }
+    
+    /* Queue full -> drop newest command with lowest priority */
+    if (cmdCnt >= FS20_CMDQ_LEN)
+    {
+        U8 dropIndex = 0;
+        for (U8 i=1; i<cmdCnt; i++)
+        {
+            if (cmdQueue[i].cmdPrio <= cmdQueue[dropIndex].cmdPrio)
+            {
+                dropIndex = i;
+            }
+        }
+        statDropped++;
+        if (cmdQueue[dropIndex].cmdPrio >= cmdPrio)
+        {
+            return false; // ERROR
+        }
+        cmdRemove(dropIndex);
+    }
+    
+    fs20Cmd *pCmd = &cmdQueue[cmdCnt++];
+    pCmd->homeCode = homeCode;
+    pCmd->addrByte = addrByte;
+    pCmd->cmdByte = cmdByte;
+    pCmd->cmdPrio = cmdPrio;
+    pCmd->bDeferred = false;
+    pCmd->msAir = 0;
+    cmdFeed();
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Queue statistic: merged (superseded) and dropped commands
+//------------------------------------------------------------------------------
+void objFs20::GetQueueStats(U16 *cmdMerged, U16 *cmdDropped)
+{
+    *cmdMerged = statMerged;
+    *cmdDropped = statDropped;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Move command with highest priority to the transmitter
+// Only if the transmitter is free -> pending commands can be merged
+//------------------------------------------------------------------------------
+void objFs20::cmdFeed(void)
+{
+    if ((cmdCnt == 0) || txBusy || (pScene != NULL))
+        return;
+    
+    /* Oldest command is never blocked */
+    U8 cmdIndex = 0;
+    for (U8 i=1; i<cmdCnt; i++)
+    {
+        if ((cmdQueue[i].cmdPrio > cmdQueue[cmdIndex].cmdPrio) && !cmdBlocked(i))
+        {
+            cmdIndex = i;
+        }
+    }
+    fs20Cmd *pCmd = &cmdQueue[cmdIndex];
+    U8 dcResult = dcAdmit(pCmd);
+    if (dcResult == FS20_DC_DROP)
+    {
+        cmdRemove(cmdIndex);
+        return;
+    }
+    if (dcResult == FS20_DC_DEFER)
+    {
+        return;
+    }
+    if (txStartJob(pCmd->homeCode, pCmd->addrByte, pCmd->cmdByte))
+    {
+        dcCharge(pCmd->msAir);
+        cmdRemove(cmdIndex);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Duty cycle admission: send, defer or drop
+//------------------------------------------------------------------------------
+U8 objFs20::dcAdmit(fs20Cmd *pCmd)
+{
+    /* Air time rounded up to ms, calculated once per command */
+    if (pCmd->msAir == 0)
+    {
+        const fs20Telegram *pTg = GetTelegram(pCmd->homeCode, pCmd->addrByte, pCmd->cmdByte);
+        pCmd->msAir = (U16)((AirTime(pTg) + 999) / 1000);
+    }
+    U32 msUsed = GetAirTime() + pCmd->msAir;
+    
+    if ((pCmd->cmdPrio == FS20_PRIO_LOW) && (msUsed + FS20_DC_RESERVE > dcLimit))
+    {
+        statDcDropped++;
+        return FS20_DC_DROP;
+    }
+    if (msUsed > dcLimit)
+    {
+        /* Count every command only once */
+        if (!pCmd->bDeferred)
+        {
+            pCmd->bDeferred = true;
+            statDeferred++;
+        }
+        return FS20_DC_DEFER;
+    }
+    return FS20_DC_SEND;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Move ledger to the current slot, clear expired slots
+//------------------------------------------------------------------------------
+void objFs20::dcAdvance(void)
+{
+    U32 slotNum = millis() / FS20_DC_SLOT_MS;
+    U32 slotDiff = slotNum - dcSlotNum;
+    if (slotDiff == 0)
+        return;
+    
+    if (slotDiff > FS20_DC_SLOTS)
+    {
+        slotDiff = FS20_DC_SLOTS;
+    }
+    for (U8 i=0; i<(U8)slotDiff; i++)
+    {
+        dcIndex = (dcIndex + 1) % FS20_DC_SLOTS;
+        dcSlot[dcIndex] = 0;
+    }
+    dcSlotNum = slotNum;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Charge air time [ms] to the current slot
+//------------------------------------------------------------------------------
+void objFs20::dcCharge(U16 msAir)
+{
+    U32 slotAir = (U32)dcSlot[dcIndex] + msAir;
+    dcSlot[dcIndex] = (slotAir > 0xFFFF) ? 0xFFFF : (U16)slotAir;
+}
+
+//------------------------------------------------------------------------------
+// Duty cycle: air time of the last hour [ms]
+//------------------------------------------------------------------------------
+U32 objFs20::GetAirTime(void)
+{
+    dcAdvance();
+    U32 msUsed = 0;
+    for (U8 i=0; i<FS20_DC_SLOTS; i++)
+    {
+        msUsed += dcSlot[i];
+    }
+    return msUsed;
+}
+
+//------------------------------------------------------------------------------
+// Duty cycle statistic: deferred and dropped commands
+//------------------------------------------------------------------------------
+void objFs20::GetDutyStats(U16 *cmdDeferred, U16 *cmdDropped)
+{
+    *cmdDeferred = statDeferred;
+    *cmdDropped = statDcDropped;
+}
+
+//------------------------------------------------------------------------------
+// Air time of a telegram incl. repetitions [us] (HIGH phases, carrier on)
+//------------------------------------------------------------------------------
+U32 objFs20::AirTime(const fs20Telegram *pTg)
+{
+    U8 oneCnt = 0;
+    for (U8 i=0; i<FS20_TG_LEN; i++)
+    {
+        U8 val = pTg->tgBits[i];
+        while (val)
+        {
+            val &= (val - 1);
+            oneCnt++;
+        }
+    }
+    U32 usAir = (U32)oneCnt * FS20_ONE + (U32)(pTg->tgLen - oneCnt) * FS20_ZERO;
+    return usAir * FS20_REP_CNT;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Remove command from queue (keep order)
+//------------------------------------------------------------------------------
+void objFs20::cmdRemove(U8 cmdIndex)
+{
+    cmdCnt--;
+    for (U8 i=cmdIndex; i<cmdCnt; i++)
+    {
+        cmdQueue[i] = cmdQueue[i + 1];
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - TRUE if "addrMaster" includes "addrByte" (nibble F = all)
+//------------------------------------------------------------------------------
+bool objFs20::cmdCovers(U8 addrMaster, U8 addrByte)
+{
+    bool bGroup = ((addrMaster & 0xF0) == 0xF0) || 
+                  ((addrMaster & 0xF0) == (addrByte & 0xF0));
+    bool bUnder = ((addrMaster & 0x0F) == 0x0F) || 
+                  ((addrMaster & 0x0F) == (addrByte & 0x0F));
+    return (bGroup && bUnder);
+}
+
+//------------------------------------------------------------------------------
+// Internal - TRUE if an older command addresses the same actor
+// (one address covers the other -> must not be overtaken)
+//------------------------------------------------------------------------------
+bool objFs20::cmdBlocked(U8 cmdIndex)
+{
+    fs20Cmd *pCmd = &cmdQueue[cmdIndex];
+    for (U8 i=0; i<cmdIndex; i++)
+    {
+        if ((cmdQueue[i].homeCode == pCmd->homeCode) &&
+            (cmdCovers(cmdQueue[i].addrByte, pCmd->addrByte) ||
+             cmdCovers(pCmd->addrByte, cmdQueue[i].addrByte)))
+        {
+            return true;
+        }
+    }
     return false;
 }
 
 //------------------------------------------------------------------------------
-// Send FS20 Actor Data (with other homeCode, 3x telegram)
+// Internal - Encode telegram and start transmit engine, FALSE if busy
+//------------------------------------------------------------------------------
+bool objFs20::txStartJob(U16 homeCode, U8 addrByte, U8 cmdByte)
+{
+    if (txBusy)
+    {
+        return false; // ERROR
+    }
+    
+    /* Encode once, the engine repeats the same bits */
+    txJob.homeCode = homeCode;
+    txJob.addrByte = addrByte;
+    txJob.cmdByte = cmdByte;
+    txJob.telegram = *GetTelegram(homeCode, addrByte, cmdByte);
+    txBusy = true;
+    
+    if (!txActive)
+    {
+        tx868Start();
+    }
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Send scene in background (interleaved repetitions), FALSE if not possible
+//------------------------------------------------------------------------------
+bool objFs20::SendScene(fs20SceneItem *pItems, U8 *pItemCnt, const U16 *pGroups)
+{
+    if ((pScene != NULL) || (*pItemCnt == 0))
+    {
+        return false; // ERROR
+    }
+    
+    if (pGroups != NULL)
+    {
+        *pItemCnt = sceneGroup(pItems, *pItemCnt, pGroups);
+    }
+    
+    /* Telegrams from the cache in front, check duty cycle for the whole scene */
+    U32 msAir = 0;
+    for (U8 i=0; i<*pItemCnt; i++)
+    {
+        fs20SceneItem *pItem = &pItems[i];
+        pItem->telegram = *GetTelegram(pItem->homeCode, pItem->addrByte, pItem->cmdByte);
+        msAir += (AirTime(&pItem->telegram) + 999) / 1000;
+    }
+    if (GetAirTime() + msAir > dcLimit)
+    {
+        /* Not retried -> dropped */
+        statDcDropped++;
+        return false; // ERROR
+    }
+    dcCharge((msAir > 0xFFFF) ? 0xFFFF : (U16)msAir);
+    
+    noInterrupts();
+    sceneCnt = *pItemCnt;
+    pScene = pItems;
+    bool bStart = !txActive;
+    interrupts();
+    
+    if (bStart)
+    {
+        tx868Start();
+    }
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Internal - Replace complete groups with the same command by group master
+// (0xgF) and compact the array, return new number of items
+//------------------------------------------------------------------------------
+U8 objFs20::sceneGroup(fs20SceneItem *pItems, U8 itemCnt, const U16 *pGroups)
+{
+    U8 newCnt = 0;
+    for (U8 i=0; i<itemCnt; i++)
+    {
+        fs20SceneItem item = pItems[i];
+        U8 addrGroup = item.addrByte >> 4;
+        
+        /* Already sent by a group master? */
+        bool bDone = false;
+        for (U8 k=0; k<newCnt; k++)
+        {
+            if ((pItems[k].homeCode == item.homeCode) && 
+                (pItems[k].cmdByte == item.cmdByte) &&
+                ((pItems[k].addrByte & 0x0F) == 0x0F) && 
+                cmdCovers(pItems[k].addrByte, item.addrByte))
+            {
+                bDone = true;
+            }
+        }
+        if (bDone)
+            continue;
+        
+        /* Only members of declared groups, no function groups or masters */
+        bool bSame = (addrGroup < FS20_GROUP_CNT) && (pGroups[addrGroup] != 0) &&
+                     ((item.addrByte & 0x0F) != 0x0F);
+        
+        /* Group decided by an earlier member (sent single) -> single too */
+        for (U8 k=0; (k<newCnt) && bSame; k++)
+        {
+            if ((pItems[k].homeCode == item.homeCode) && 
+                ((pItems[k].addrByte & 0xF0) == (item.addrByte & 0xF0)))
+            {
+                bSame = false;
+            }
+        }
+        
+        /* First member: same command for all members (at least two)? */
+        /* (no earlier member -> the whole group is at i..itemCnt-1) */
+        U16 listMask = 0;
+        U8 memberCnt = 0;
+        for (U8 k=i; (k<itemCnt) && bSame; k++)
+        {
+            if ((pItems[k].homeCode == item.homeCode) && 
+                ((pItems[k].addrByte & 0xF0) == (item.addrByte & 0xF0)))
+            {
+                bSame = (pItems[k].cmdByte == item.cmdByte);
+                listMask |= (1 << (pItems[k].addrByte & 0x0F));
+                memberCnt++;
+            }
+        }
+        
+        /* Master only if no declared member is missing in the scene */
+        if (bSame && (memberCnt > 1) && 
+            ((listMask & pGroups[addrGroup]) == pGroups[addrGroup]))
+        {
+            item.addrByte |= 0x0F;
+        }
+        pItems[newCnt++] = item;
+    }
+    return newCnt;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Scene telegram done, select next item (round robin)
+// Return pause to the next telegram [us]
 //------------------------------------------------------------------------------
-void objFs20::Send(U16 homeCode, U8 addrByte, U8 cmdByte)
+U16 objFs20::sceneNext(void)
 {
-    for (U8 iLoop=0; iLoop<FS20_REP_CNT; iLoop++)
-    {        
-        SendEx(homeCode, addrByte, cmdByte);
-        delayMicroseconds(8000);
-    }       
+    fs20SceneItem *pItem = &pScene[sceneIdx];
+    if ((txRep + 1 >= FS20_REP_CNT) && (doneFunc != NULL))
+    {
+        doneFunc(pItem->homeCode, pItem->addrByte, pItem->cmdByte);
+    }
+    
+    sceneIdx++;
+    if (sceneIdx >= sceneCnt)
+    {
+        sceneIdx = 0;
+        txRep++;
+        if (txRep >= FS20_REP_CNT)
+        {
+            /* Scene complete */
+            txRep = 0;
+            txScene = false;
+            pScene = NULL;
+            return FS20_GAP;
+        }
+    }
+    
+    /* Repetitions of the same telegram need the long gap */
+    return (sceneCnt > 1) ? FS20_SCENE_GAP : FS20_GAP;
 }
 
 //------------------------------------------------------------------------------
 // Switch FS20 Actor ON or OFF
 //------------------------------------------------------------------------------
-void objFs20::Switch(U16 homeCode, U8 addrByte, bool swOn)
+bool objFs20::Switch(U16 homeCode, U8 addrByte, bool swOn)
 {
     U8 cmdByte = (swOn) ? FS20_SWITCH_ON : FS20_SWITCH_OFF;
-    Send(homeCode, addrByte, cmdByte);
+    return Send(homeCode, addrByte, cmdByte);
 }
 
 //------------------------------------------------------------------------------
 // Toggle FS20 Actor ON or OFF
 //------------------------------------------------------------------------------
-void objFs20::Switch(U16 homeCode, U8 addrByte)
+bool objFs20::Switch(U16 homeCode, U8 addrByte)
 {    
-    Send(homeCode, addrByte, FS20_SWITCH_TOGGLE);
+    return Send(homeCode, addrByte, FS20_SWITCH_TOGGLE);
 }
 
 //------------------------------------------------------------------------------
 // Dimm FS20 Actor (value between 0..16)
 //------------------------------------------------------------------------------
-void objFs20::Dimm(U16 homeCode, U8 addrByte, U8 dimmValue)
+bool objFs20::Dimm(U16 homeCode, U8 addrByte, U8 dimmValue)
 {    
-    U8 cmdByte = dimmValue;    
-    if (cmdByte <= FS20_SWITCH_ON)
+    /* Level 0..16 is the command byte (0x00 OFF .. 0x10 ON) */
+    if (dimmValue <= FS20_LEVEL_MAX)
+    {
+        return Send(homeCode, addrByte, dimmValue);
+    }
+    return false; // ERROR
+}
+
+//------------------------------------------------------------------------------
+// Dimm FS20 Actor one step up or down
+//------------------------------------------------------------------------------
+bool objFs20::DimmStep(U16 homeCode, U8 addrByte, bool bUp)
+{
+    return Send(homeCode, addrByte, bUp ? FS20_DIMM_UP : FS20_DIMM_DOWN);
+}
+
+//------------------------------------------------------------------------------
+// Dimm FS20 Actor from level to level within "msDuration"
+//------------------------------------------------------------------------------
+// Every level costs one telegram, also a single 0x13/0x14 step -> the
+// fewest telegrams are "stepCnt" absolute levels, evenly spaced in time:
+//   stepCnt = min(|toLevel - fromLevel|, msDuration / FS20_RAMP_STEP_MS)
+//------------------------------------------------------------------------------
+bool objFs20::DimmRamp(U16 homeCode, U8 addrByte, U8 fromLevel, U8 toLevel, U32 msDuration)
+{
+    if ((toLevel > FS20_LEVEL_MAX) || 
+        ((fromLevel > FS20_LEVEL_MAX) && (fromLevel != FS20_LEVEL_UNKNOWN)))
+    {
+        return false; // ERROR
+    }
+    
+    fs20Ramp *pRamp = rampFind(homeCode, addrByte);
+    U8 levelDiff = (toLevel > fromLevel) ? (toLevel - fromLevel) : (fromLevel - toLevel);
+    U32 maxSteps = msDuration / FS20_RAMP_STEP_MS;
+    U8 stepCnt = (maxSteps < levelDiff) ? (U8)maxSteps : levelDiff;
+    if ((fromLevel == FS20_LEVEL_UNKNOWN) || (stepCnt == 0))
+    {
+        /* Single step: target level at once, running ramp is replaced */
+        if (pRamp != NULL)
+        {
+            pRamp->stepCnt = 0;
+            rampCnt--;
+        }
+        return Dimm(homeCode, addrByte, toLevel);
+    }
+    
+    if (pRamp == NULL)
+    {
+        /* Free entry */
+        for (U8 i=0; (i<FS20_RAMP_CNT) && (pRamp == NULL); i++)
+        {
+            if (rampTable[i].stepCnt == 0)
+            {
+                pRamp = &rampTable[i];
+            }
+        }
+        if (pRamp == NULL)
+        {
+            return false; // ERROR
+        }
+        rampCnt++;
+    }
+    
+    pRamp->homeCode = homeCode;
+    pRamp->addrByte = addrByte;
+    pRamp->fromLevel = fromLevel;
+    pRamp->toLevel = toLevel;
+    pRamp->stepCnt = stepCnt;
+    pRamp->stepDone = 0;
+    pRamp->msStart = millis();
+    pRamp->msDuration = msDuration;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// TRUE while a ramp for the actor is running
+//------------------------------------------------------------------------------
+bool objFs20::DimmBusy(U16 homeCode, U8 addrByte)
+{
+    return (rampFind(homeCode, addrByte) != NULL);
+}
+
+//------------------------------------------------------------------------------
+// Internal - Find running ramp of actor (NULL = none)
+//------------------------------------------------------------------------------
+fs20Ramp *objFs20::rampFind(U16 homeCode, U8 addrByte)
+{
+    for (U8 i=0; i<FS20_RAMP_CNT; i++)
+    {
+        fs20Ramp *pRamp = &rampTable[i];
+        if ((pRamp->stepCnt > 0) && (pRamp->homeCode == homeCode) && 
+            (pRamp->addrByte == addrByte))
+        {
+            return pRamp;
+        }
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Send due ramp steps (absolute levels supersede each other)
+//------------------------------------------------------------------------------
+void objFs20::rampService(void)
+{
+    if (rampCnt == 0)
+        return;
+    
+    U32 msNow = millis();
+    for (U8 i=0; i<FS20_RAMP_CNT; i++)
     {
-        Send(homeCode, addrByte, FS20_SWITCH_TOGGLE);
+        fs20Ramp *pRamp = &rampTable[i];
+        if (pRamp->stepCnt == 0)
+            continue;
+        
+        /* Step k is due at k * duration / stepCnt */
+        U8 stepNext = pRamp->stepDone + 1;
+        U32 msDue = (pRamp->msDuration * stepNext) / pRamp->stepCnt;
+        if ((U32)(msNow - pRamp->msStart) < msDue)
+            continue;
+        
+        S16 levelDiff = (S16)pRamp->toLevel - pRamp->fromLevel;
+        U8 level = pRamp->fromLevel + (S8)((levelDiff * stepNext) / pRamp->stepCnt);
+        if (!Send(pRamp->homeCode, pRamp->addrByte, level))
+            continue; // Queue full -> retry
+        
+        pRamp->stepDone = stepNext;
+        if (stepNext >= pRamp->stepCnt)
+        {
+            pRamp->stepCnt = 0;
+            rampCnt--;
+        }
     }
 }
 
 //------------------------------------------------------------------------------
-// Internal - Send complete FS20 telegram (single telegram)
+// Service function: command queue, polled engine without FS20_TX_TIMER1
+//------------------------------------------------------------------------------
+void objFs20::Tick(void)
+{
+    rampService();
+    cmdFeed();
+#ifndef FS20_TX_TIMER1
+    if (!txActive)
+        return;
+    if ((U32)(micros() - txEdgeTime) < txWait)
+        return;
+    
+    /* Next edge relative to planned edge -> no accumulated drift */
+    txEdgeTime += txWait;
+    txWait = TxEdge();
+#endif
+}
+
+//------------------------------------------------------------------------------
+// Transmit engine: set next edge, return time to following edge [us]
+//------------------------------------------------------------------------------
+// Bit: HIGH for 400/600us, LOW for 400/600us; FS20_GAP after every telegram
 //------------------------------------------------------------------------------
-void objFs20::SendEx(U16 homeCode, U8 addrByte, U8 cmdByte)
+U16 objFs20::TxEdge(void)
+{
+    if (!txScene && !txBusy)
+    {
+        if (pScene == NULL)
+        {
+            /* Queue empty -> done */
+            FS20_PIN_WRITE(0);
+            txActive = false;
+            return 0;
+        }
+        
+        /* Start pending scene */
+        txScene = true;
+        sceneIdx = 0;
+        txBit = 0;
+        txRep = 0;
+    }
+    
+    fs20Job *pJob = &txJob;
+    const fs20Telegram *pTg = txScene ? &pScene[sceneIdx].telegram : &pJob->telegram;
+    
+    /* Telegram complete -> gap, next repetition or next job */
+    if (txBit >= pTg->tgLen)
+    {
+        txBit = 0;
+        if (txScene)
+        {
+            return sceneNext();
+        }
+        txRep++;
+        if (txRep >= FS20_REP_CNT)
+        {
+            txRep = 0;
+            if (doneFunc != NULL)
+            {
+                doneFunc(pJob->homeCode, pJob->addrByte, pJob->cmdByte);
+            }
+            txBusy = false;
+        }
+        return FS20_GAP;
+    }
+    
+    U16 usPulse = (pTg->tgBits[txBit >> 3] & (0x80 >> (txBit & 0x07))) ? 
+                  FS20_ONE : FS20_ZERO;
+    if (!txHigh)
+    {
+        FS20_PIN_WRITE(1);
+        txHigh = true;
+    }
+    else
+    {
+        FS20_PIN_WRITE(0);
+        txHigh = false;
+        txBit++;
+    }
+    return usPulse;
+}
+
+//------------------------------------------------------------------------------
+// Encode telegram (checksum, parity, sync) into packed bits
+//------------------------------------------------------------------------------
+void objFs20::Encode(U16 homeCode, U8 addrByte, U8 cmdByte, fs20Telegram *pTg)
 {    
     U8 hCodeH = homeCode / 0x100;
     U8 hCodeL = homeCode % 0x100;    
@@ -127,138 +833,146 @@ void objFs20::SendEx(U16 homeCode, U8 addrByte, U8 cmdByte)
     checkSum += cmdByte;
      
     /* Clear bit-buffer  */
-    tx868Clear();
-    
-    /* Synchronisation */
-    for (U8 i=0; i<FS20_MAX_SYNC; i++)
+    for (U8 i=0; i<FS20_TG_LEN; i++)
     {
-        tx868AddBit(0);
+        pTg->tgBits[i] = 0;
     }
-    /* Start Bit */
-    tx868AddBit(1);
+    pTg->tgLen = 0;
+    
+    /* Synchronisation and start bit */
+    tx868AddBits(pTg, 0x0001, FS20_MAX_SYNC + 1);
     
     /* Home code */
-    tx868AddByte(hCodeH);
-    tx868AddByte(hCodeL);
+    tx868AddByte(pTg, hCodeH);
+    tx868AddByte(pTg, hCodeL);
     
     /* address, command and checksum byte */
-    tx868AddByte(addrByte);
-    tx868AddByte(cmdByte);
-    tx868AddByte(checkSum);
+    tx868AddByte(pTg, addrByte);
+    tx868AddByte(pTg, cmdByte);
+    tx868AddByte(pTg, checkSum);
     
     /* End Bit */
-    tx868AddBit(0);
-    
-    /* End of list */  
-    tx868AddBit(0xF);
-
-    /* Send bit telegram */
-    tx868Send(); 
+    tx868AddBits(pTg, 0, 1);
 }
 
 //------------------------------------------------------------------------------
-// TX868 - Clear bit-buffer
+// Get encoded telegram from cache (encode on miss)
+// Pointer is valid until the next call!
 //------------------------------------------------------------------------------
-void objFs20::tx868Clear()
+const fs20Telegram *objFs20::GetTelegram(U16 homeCode, U8 addrByte, U8 cmdByte)
 {
-    for (U16 i=0; i<FS20_BUFFER_LEN; i++)
+#if FS20_CACHE_LEN > 0
+    for (U8 i=0; i<cacheCnt; i++)
+    {
+        fs20Cache *pEntry = &tgCache[i];
+        if ((pEntry->homeCode == homeCode) && (pEntry->addrByte == addrByte) &&
+            (pEntry->cmdByte == cmdByte))
+        {
+            /* Move to front (most recently used) */
+            fs20Cache hit = *pEntry;
+            for (U8 k=i; k>0; k--)
+            {
+                tgCache[k] = tgCache[k - 1];
+            }
+            tgCache[0] = hit;
+            statHit++;
+            return &tgCache[0].telegram;
+        }
+    }
+    
+    /* Miss -> insert in front, least recently used drops out */
+    statMiss++;
+    if (cacheCnt < FS20_CACHE_LEN)
+    {
+        cacheCnt++;
+    }
+    for (U8 k=cacheCnt-1; k>0; k--)
     {
-        fs20Buffer[i] = 0;
+        tgCache[k] = tgCache[k - 1];
     }
-    fs20Index = 0;
+    tgCache[0].homeCode = homeCode;
+    tgCache[0].addrByte = addrByte;
+    tgCache[0].cmdByte = cmdByte;
+    Encode(homeCode, addrByte, cmdByte, &tgCache[0].telegram);
+    return &tgCache[0].telegram;
+#else
+    statMiss++;
+    Encode(homeCode, addrByte, cmdByte, &txTelegram);
+    return &txTelegram;
+#endif
 }
 
 //------------------------------------------------------------------------------
-// TX868 - Add bit to bit-buffer
+// Cache statistic: hits and misses
 //------------------------------------------------------------------------------
-void objFs20::tx868AddBit(U8 aBit)
+void objFs20::GetCacheStats(U16 *cacheHit, U16 *cacheMiss)
 {
-    /* Check overflow */
-    if (fs20Index >= FS20_BUFFER_LEN) 
-        return;
-    
-    fs20Buffer[fs20Index++] = aBit;
+    *cacheHit = statHit;
+    *cacheMiss = statMiss;
 }
 
 //------------------------------------------------------------------------------
-// TX868 - Add byte with parity bit to bit-buffer
+// TX868 - Add "bitCnt" low bits of "bits" to telegram (MSB first)
 //------------------------------------------------------------------------------
-void objFs20::tx868AddByte(U8 aByte)
+void objFs20::tx868AddBits(fs20Telegram *pTg, U16 bits, U8 bitCnt)
 {
-    U8 parity = checkParity(aByte); 
-    U8 bit = 0;
-    
-    for (U8 i=0; i<8; i++)
-    {
-        if ((aByte & (1 << (7 - i))) > 0) 
-            bit=1; 
-        else 
-            bit=0;
-        tx868AddBit(bit);
-    }                        
-    tx868AddBit(parity);
-}    
-
-
-//------------------------------------------------------------------------------
-// TX868 - Send data-Buffer to TX-868 modul
-//------------------------------------------------------------------------------
-void objFs20::tx868Send(void)
-{  
-    /* Buffer empty */
-    if (fs20Index == 0) 
-        return;
-    
-    for (U16 i=0; i<FS20_BUFFER_LEN; i++)
+    for (U8 i=bitCnt; i>0; i--)
     {
-        switch (fs20Buffer[i])
+        /* Check overflow */
+        if (pTg->tgLen >= FS20_TG_LEN * 8) 
+            return;
+        
+        if (bits & ((U16)1 << (i - 1)))
         {
-            case 1:
-                digitalWrite(fs20DataPin, 1);
-                delayMicroseconds(FS20_ONE);
-                digitalWrite(fs20DataPin, 0);
-                delayMicroseconds(FS20_ONE);
-                break;
-
-            case 0:
-                digitalWrite(fs20DataPin, 1);
-                delayMicroseconds(FS20_ZERO);
-                digitalWrite(fs20DataPin, 0);
-                delayMicroseconds(FS20_ZERO);                
-                break;
-
-            case 0xF:                
-                return;
+            pTg->tgBits[pTg->tgLen >> 3] |= (0x80 >> (pTg->tgLen & 0x07));
         }
+        pTg->tgLen++;
     }
 }
 
 //------------------------------------------------------------------------------
-// Internal - Count all HI bits
-//------------------------------------------------------------------------------ 
-U8 objFs20::countBit(U8 val)
-{    
-    U8 cnt=0;
-    for (U8 i=0; i<8; i++)
-    {
-        if (val & (1 << (7 - i))) 
-        {
-            cnt++;
-        }
-    }    
-    return cnt;
+// TX868 - Add byte with parity bit to telegram
+//------------------------------------------------------------------------------
+void objFs20::tx868AddByte(fs20Telegram *pTg, U8 aByte)
+{
+    tx868AddBits(pTg, ((U16)aByte << 1) | checkParity(aByte), 9);
+}    
+
+//------------------------------------------------------------------------------
+// TX868 - Start transmit engine (first edge after a short delay)
+//------------------------------------------------------------------------------
+void objFs20::tx868Start(void)
+{  
+    noInterrupts();
+    txActive = true;
+    txBit = 0;
+    txRep = 0;
+    txHigh = false;
+#ifdef FS20_TX_TIMER1
+    /* Timer1: CTC mode, prescaler 8 */
+    txOwner = this;
+    TCCR1A = 0;
+    TCCR1B = (1 << WGM12) | (1 << CS11);
+    TCNT1 = 0;
+    OCR1A = FS20_TIMER_TICKS(20, F_CPU) - 1;
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+#else
+    txEdgeTime = micros();
+    txWait = 0;
+#endif
+    interrupts();
 }
 
 //------------------------------------------------------------------------------
-// Internal - Check Parity Bit
+// Internal - Parity bit (1 = odd number of HI bits)
 //------------------------------------------------------------------------------
 U8 objFs20::checkParity(U8 val)
 {
-    U8 c = countBit(val);  
-    if (!(c%2)) 
-        return 0; 
-    else 
-        return 1;
+    val ^= (val >> 4);
+    val ^= (val >> 2);
+    val ^= (val >> 1);
+    return (val & 0x01);
 }
 
 //------------------------------------------------------------------------------
@@ -6,6 +6,8 @@
 #ifndef _CPP_OBJFS20
 #define _CPP_OBJFS20
 
+#include "defGpio.h"
+
 //------------------------------------------------------------------------------
 /* TX Modul (ELV/eQ-3) with FS20 (ST-3) protocol:
  *      ------------+
@@ -55,8 +57,158 @@
  */
 //------------------------------------------------------------------------------
 
-/* Internal bit buffer */
-#define FS20_BUFFER_LEN  96
+/* Packed telegram: 12 sync + start + 5x (8 data + parity) + end = 59 bit */
+#define FS20_TG_BITS     59
+#define FS20_TG_LEN      ((FS20_TG_BITS + 7) / 8)
+
+/* Encoded telegram cache (0 = off) */
+#define FS20_CACHE_LEN    4
+
+/* Encoded telegram (bits MSB first, sent left to right) */
+typedef struct
+{
+    U8 tgBits[FS20_TG_LEN];
+    U8 tgLen;                 // Number of bits
+} fs20Telegram;
+
+/* Transmit engine:
+ *   FS20_TX_TIMER1 (default on AVR) -> Timer1 compare interrupt clocks out
+ *                  the bits (one objFs20 owns the timer, no Servo library,
+ *                  no analogWrite() on the Timer1 pins)
+ *   FS20_TX_POLL   -> "Tick()" in loop() polls micros() (other platforms)
+ * Polled: the receiver accepts about +-100us per half-bit, every call of
+ * "Tick()" during a transmission must follow within 100us. A longer loop()
+ * (e.g. an I2C transaction: 0.5..1 ms) stretches one half-bit and the
+ * telegram is lost.
+ */
+//#define FS20_TX_POLL
+
+#if defined(__AVR__) && !defined(FS20_TX_POLL)
+  #define FS20_TX_TIMER1
+#endif
+
+/* Timer1 ticks of "usTime" (prescaler 8, any clock: 12 MHz -> 1.5 per us) */
+#define FS20_TIMER_TICKS(usTime, hzCpu)  (((U32)(usTime) * ((hzCpu) / 1000UL)) / 8000UL)
+
+/* Data pin bound at compile time (AVR), "Init()" ignores its pin number:
+ *   #define FS20_DATA_PIN  gpioAvr<GPIO_PORTD, 3>     // Uno pin 3 = PD3
+ * not defined -> pin number of "Init()" resolved once to register/mask
+ */
+//#define FS20_DATA_PIN  gpioAvr<GPIO_PORTD, 3>
+
+#if defined(FS20_DATA_PIN) && !defined(__AVR__)
+  #pragma message ("+++WARNING: FS20_DATA_PIN only on AVR, pin of Init()!+++")
+  #undef FS20_DATA_PIN
+#endif
+
+/* Command queue in front of the transmitter (one job on air):
+ *   - an absolute command (0x00..0x11) replaces pending commands of the
+ *     same homeCode whose address it covers (same address, or nibble F:
+ *     0xFF = all, 0x1F = group 1, 0xF3 = under address 3 of all groups)
+ *   - relative commands (toggle, dimm up/down, ..) are never merged
+ *   - overlapping addresses (one covers the other) are sent in FIFO order,
+ *     highest priority first only among commands for other actors
+ */
+#define FS20_CMDQ_LEN     8
+
+/* Command priority (OFF is sent with FS20_PRIO_HIGH by "Send()") */
+#define FS20_PRIO_LOW     0
+#define FS20_PRIO_NORMAL  1
+#define FS20_PRIO_HIGH    2
+
+/* Duty cycle ledger (SRD 868 MHz: max. 1% = 36 s air time per hour):
+ *   sliding hour in FS20_DC_SLOTS slots, charged with the air time of all
+ *   repetitions when a command is transmitted (OOK: carrier only in the
+ *   HIGH phases -> sum of the HIGH pulses, LOW phases and gaps are free)
+ *   - FS20_PRIO_LOW commands are dropped if less than FS20_DC_RESERVE
+ *     remains, they would only delay newer commands
+ *   - all other commands wait in the command queue until the budget allows
+ */
+#define FS20_DC_LIMIT     36000     // [ms] per hour
+#define FS20_DC_RESERVE    3600     // [ms] kept for normal / high priority
+#define FS20_DC_SLOTS        12     // 12 x 5 min
+
+/* Completion callback -> called after the last repetition of a telegram */
+/* (FS20_TX_TIMER1: called in interrupt context!) */
+typedef void (*fs20Callback)(U16 homeCode, U8 addrByte, U8 cmdByte);
+
+/* Transmit job */
+typedef struct
+{
+    U16 homeCode;
+    U8  addrByte;
+    U8  cmdByte;
+    fs20Telegram telegram;
+} fs20Job;
+
+/* Pending command */
+typedef struct
+{
+    U16 homeCode;
+    U8  addrByte;
+    U8  cmdByte;
+    U8  cmdPrio;      // FS20_PRIO_xxx
+    bool bDeferred;   // Waiting for duty cycle budget
+    U16 msAir;        // Air time incl. repetitions (0 = not calculated)
+} fs20Cmd;
+
+/* Scene item, telegram is set by "SendScene()" (from the cache) */
+typedef struct
+{
+    U16 homeCode;
+    U8  addrByte;
+    U8  cmdByte;
+    fs20Telegram telegram;
+} fs20SceneItem;
+
+/* Scene transmission:
+ *   all telegrams are encoded in front, the repetitions are interleaved
+ *   (A1 B1 C1 A2 B2 C2 A3 B3 C3) with the short FS20_SCENE_GAP between
+ *   different telegrams -> every actor switches within the first round
+ */
+#define FS20_SCENE_GAP    2000     // [us]
+
+/* Scene grouping: the group master 0xgF reaches every actor of group g,
+ * also those not in the scene -> the caller declares the members of each
+ * group 0..E (bit n = sub-address n, 0 = never grouped), a group is only
+ * sent to its master if the scene contains all of its members
+ * (function groups 0xFn and the masters themselves are never grouped)
+ */
+#define FS20_GROUP_CNT      15
+#define FS20_GROUP_ALL      0x7FFF   // Sub-addresses 0..E
+
+/* Dimm ramp engine (non-blocking, "Tick()"):
+ *   level 0 = OFF, 1..15 = 6.25% steps, 16 = ON
+ *   a ramp sends absolute levels (one telegram each, a pending level is
+ *   superseded by the next one), the number of steps is limited by the
+ *   duration: one step per FS20_RAMP_STEP_MS (air time of one command)
+ */
+#define FS20_RAMP_CNT        2
+#define FS20_RAMP_STEP_MS  250     // [ms] min. time between steps
+#define FS20_LEVEL_MAX      16
+#define FS20_LEVEL_UNKNOWN  0xFF
+
+/* Active dimm ramp */
+typedef struct
+{
+    U16 homeCode;
+    U8  addrByte;
+    U8  fromLevel;
+    U8  toLevel;
+    U8  stepCnt;      // 0 = ramp not active
+    U8  stepDone;
+    U32 msStart;
+    U32 msDuration;
+} fs20Ramp;
+
+/* Cache entry (most recently used first) */
+typedef struct
+{
+    U16 homeCode;
+    U8  addrByte;
+    U8  cmdByte;
+    fs20Telegram telegram;
+} fs20Cache;
 
 //==============================================================================
 // OBJECT CLASS: objFs20 - FS20 ELV Tx868 Modul
@@ -67,32 +219,149 @@ class objFs20
         /* Class constructor */
         objFs20(void);
 
-        /* Initialize FS20 ELV Tx868 Modul */ 
+        /* Initialize FS20 ELV Tx868 Modul, FALSE if no valid pin */
         bool Init(U8 dataPin);
                 
-        /* Send FS20 Actor Data */
-        void Send(U16 homeCode, U8 addrByte, U8 cmdByte);
+        /* Send FS20 Actor Data in background, FALSE if queue full */
+        bool Send(U16 homeCode, U8 addrByte, U8 cmdByte);
+        
+        /* Send with priority (FS20_PRIO_xxx), a full queue drops the */
+        /* newest command with lower priority, FALSE if not queued */
+        bool SendPrio(U16 homeCode, U8 addrByte, U8 cmdByte, U8 cmdPrio);
 
+        /* Send scene in background, "pItems" must stay valid until done */
+        /* pGroups: NULL or FS20_GROUP_CNT member masks (see above) -> all */
+        /* members of a group with the same command are sent once to the */
+        /* group master (0xgF), the array is compacted (new number of items */
+        /* in "pItemCnt") */
+        /* FALSE if a scene is pending or the duty cycle budget is exceeded */
+        /* (not retried, counted as dropped in "GetDutyStats()") */
+        bool SendScene(fs20SceneItem *pItems, U8 *pItemCnt, const U16 *pGroups);
+        
         /* Switch FS20 Actor ON or OFF */
-        void Switch(U16 homeCode, U8 addrByte, bool swOn);
+        bool Switch(U16 homeCode, U8 addrByte, bool swOn);
         
         /* Toggle FS20 Actor ON or OFF */
-        void Switch(U16 homeCode, U8 addrByte);
+        bool Switch(U16 homeCode, U8 addrByte);
 
         /* Dimm FS20 Actor (value between 0..16) */
-        void Dimm(U16 homeCode, U8 addrByte, U8 dimmValue);
+        bool Dimm(U16 homeCode, U8 addrByte, U8 dimmValue);
+        
+        /* Dimm FS20 Actor one step up or down */
+        bool DimmStep(U16 homeCode, U8 addrByte, bool bUp);
+        
+        /* Dimm FS20 Actor from level to level (0..16) within "msDuration" */
+        /* (fromLevel FS20_LEVEL_UNKNOWN or no full step -> target level */
+        /* at once), */
+        /* replaces a running ramp of the actor, FALSE if no ramp free */
+        bool DimmRamp(U16 homeCode, U8 addrByte, U8 fromLevel, U8 toLevel, U32 msDuration);
+        
+        /* TRUE while a ramp for the actor is running */
+        bool DimmBusy(U16 homeCode, U8 addrByte);
+        
+        /* Service function: command queue and transmit engine (call in loop) */
+        void Tick(void);
+        
+        /* TRUE while commands are queued or transmitted */
+        bool Busy(void) { return (txActive || txBusy || (cmdCnt > 0) || (pScene != NULL) || (rampCnt > 0)); }
+        
+        /* Queue statistic: merged (superseded) and dropped commands */
+        void GetQueueStats(U16 *cmdMerged, U16 *cmdDropped);
+        
+        /* Duty cycle: air time of the last hour [ms] */
+        U32 GetAirTime(void);
+        
+        /* Duty cycle: set limit per hour [ms] (default FS20_DC_LIMIT) */
+        void SetAirLimit(U32 msLimit) { dcLimit = msLimit; }
+        
+        /* Duty cycle statistic: deferred and dropped commands */
+        void GetDutyStats(U16 *cmdDeferred, U16 *cmdDropped);
+        
+        /* Air time (HIGH phases) of a telegram incl. repetitions [us] */
+        static U32 AirTime(const fs20Telegram *pTg);
+        
+        /* Set completion callback (NULL = none) */
+        void SetCallback(fs20Callback pCallback) { doneFunc = pCallback; }
+        
+        /* Transmit engine: set next edge, return time to following edge */
+        /* [us] (0 = done) - called by timer interrupt or "Tick()" */
+        U16 TxEdge(void);
+        
+        /* Encode telegram (checksum, parity, sync) into packed bits */
+        static void Encode(U16 homeCode, U8 addrByte, U8 cmdByte, fs20Telegram *pTg);
+        
+        /* Get encoded telegram from cache (encode on miss) */
+        const fs20Telegram *GetTelegram(U16 homeCode, U8 addrByte, U8 cmdByte);
+        
+        /* Cache statistic: hits and misses */
+        void GetCacheStats(U16 *cacheHit, U16 *cacheMiss);
    
     private:        
-        U8 fs20Buffer[FS20_BUFFER_LEN];        
-        U8 fs20DataPin;        
-        U16 fs20Index;        
-        void SendEx(U16 homeCode, U8 addrByte, U8 cmdByte);
-        void tx868Clear(void);
-        void tx868AddBit(U8 aBit);
-        void tx868AddByte(U8 aByte);
-        void tx868Send(void);
-        U8 countBit(U8 val);
-        U8 checkParity(U8 val);
+#ifndef FS20_DATA_PIN
+        gpioPin fs20DataPin;
+#endif
+#if FS20_CACHE_LEN > 0
+        fs20Cache tgCache[FS20_CACHE_LEN];
+        U8 cacheCnt;
+#else
+        fs20Telegram txTelegram;
+#endif
+        U16 statHit;
+        U16 statMiss;
+        
+        /* Command queue (insertion order) */
+        fs20Cmd cmdQueue[FS20_CMDQ_LEN];
+        U8 cmdCnt;
+        U16 statMerged;
+        U16 statDropped;
+        
+        /* Dimm ramps */
+        fs20Ramp rampTable[FS20_RAMP_CNT];
+        U8 rampCnt;
+        
+        /* Duty cycle ledger [ms] per slot */
+        U16 dcSlot[FS20_DC_SLOTS];
+        U8 dcIndex;
+        U32 dcSlotNum;
+        U32 dcLimit;
+        U16 statDeferred;
+        U16 statDcDropped;
+        
+        /* Transmit job (set by Tick if free, released by TxEdge) and state */
+        fs20Job txJob;
+        volatile bool txBusy;
+        volatile bool txActive;
+        U8 txBit;
+        U8 txRep;
+        bool txHigh;
+        fs20Callback doneFunc;
+        
+        /* Scene (transmitted when no job is on air) */
+        fs20SceneItem *volatile pScene;
+        U8 sceneCnt;
+        U8 sceneIdx;
+        bool txScene;
+#ifndef FS20_TX_TIMER1
+        U32 txEdgeTime;
+        U16 txWait;
+#endif
+        
+        static void tx868AddBits(fs20Telegram *pTg, U16 bits, U8 bitCnt);
+        static void tx868AddByte(fs20Telegram *pTg, U8 aByte);
+        void tx868Start(void);
+        bool txStartJob(U16 homeCode, U8 addrByte, U8 cmdByte);
+        void cmdFeed(void);
+        void cmdRemove(U8 cmdIndex);
+        bool cmdBlocked(U8 cmdIndex);
+        static bool cmdCovers(U8 addrMaster, U8 addrByte);
+        U8 dcAdmit(fs20Cmd *pCmd);
+        void dcAdvance(void);
+        void dcCharge(U16 msAir);
+        static U8 sceneGroup(fs20SceneItem *pItems, U8 itemCnt, const U16 *pGroups);
+        U16 sceneNext(void);
+        fs20Ramp *rampFind(U16 homeCode, U8 addrByte);
+        void rampService(void);
+        static U8 checkParity(U8 val);
 
 };
  
@@ -0,0 +1,371 @@
+//------------------------------------------------------------------------------
+// File...: objFs20Rx.cpp
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objFs20Rx - FS20/FHT receive decoder (RX868 Modul)
+//------------------------------------------------------------------------------
+#include "classEnable.h"
+#ifdef CE_OBJ_FS20RX
+#include <Arduino.h>
+#include "objFs20Rx.h"
+
+//------------------------------------------------------------------------------
+// Internal defines
+//------------------------------------------------------------------------------
+/* Bit period windows [us] */
+#define FS20RX_ZERO_MIN    600
+#define FS20RX_ZERO_MAX   1000
+#define FS20RX_ONE_MAX    1450
+
+/* Single phase window [us] (HIGH and LOW nearly equal) */
+#define FS20RX_PHASE_MIN   250
+#define FS20RX_PHASE_MAX   800
+
+/* Phase flag in edge ring */
+#define FS20RX_HIGH     0x8000
+
+/* Checksum offset */
+#define FS20RX_CHK_FS20   0x06
+#define FS20RX_CHK_FHT    0x0C
+
+/* State machine */
+#define FS20RX_ST_SYNC       0   // Count zero bits, wait for start bit
+#define FS20RX_ST_DATA       1   // Collect bytes with parity
+
+//------------------------------------------------------------------------------
+// Pin change interrupt
+//------------------------------------------------------------------------------
+static objFs20Rx *rxOwner = NULL;
+static gpioPin rxPin;
+
+static void rxIsr(void)
+{
+    rxOwner->Capture(micros(), rxPin.Read());
+}
+
+//------------------------------------------------------------------------------
+// Class constructor
+//------------------------------------------------------------------------------
+objFs20Rx::objFs20Rx(void)
+{
+    edgeHead = 0;
+    edgeTail = 0;
+    edgeLast = 0;
+    tgHead = 0;
+    tgTail = 0;
+    tgLast.rxType = 0;
+    tgLastTime = 0;
+    statDecoded = 0;
+    statRepeat = 0;
+    statError = 0;
+    statLost = 0;
+    rxHigh = 0;
+    bPend = false;
+    resetState(false);
+}
+
+//------------------------------------------------------------------------------
+// Initialize RX868 data pin with pin change interrupt
+//------------------------------------------------------------------------------
+bool objFs20Rx::Init(U8 dataPin)
+{
+    if (dataPin == 0xFF)
+    {
+        return true; // OK
+    }
+    
+    int irq = digitalPinToInterrupt(dataPin);
+    if (irq == NOT_AN_INTERRUPT)
+    {
+        return false; // ERROR
+    }
+    rxPin.Bind(dataPin, INPUT);
+    rxOwner = this;
+    edgeLast = micros();
+    attachInterrupt(irq, rxIsr, CHANGE);
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Store edge (time [us], new pin level), called by interrupt
+//------------------------------------------------------------------------------
+void objFs20Rx::Capture(U32 usTime, bool bLevel)
+{
+    U32 phase = usTime - edgeLast;
+    edgeLast = usTime;
+    
+    U8 next = (edgeHead + 1) & (FS20RX_EDGE_LEN - 1);
+    if (next == edgeTail)
+    {
+        statLost++;
+        return;
+    }
+    
+    /* Ended phase has the opposite level */
+    if (phase > 0x7FFF)
+    {
+        phase = 0x7FFF;
+    }
+    edgeRing[edgeHead] = (U16)phase | (bLevel ? 0 : FS20RX_HIGH);
+    edgeHead = next;
+}
+
+//------------------------------------------------------------------------------
+// Decode max. "maxEdges" from edge buffer, return decoded telegrams
+//------------------------------------------------------------------------------
+U8 objFs20Rx::Decode(U8 maxEdges)
+{
+    U16 decoded = statDecoded;
+    for (U8 i=0; (i<maxEdges) && (edgeTail != edgeHead); i++)
+    {
+        decodePhase(edgeRing[edgeTail]);
+        edgeTail = (edgeTail + 1) & (FS20RX_EDGE_LEN - 1);
+    }
+    
+    /* Held FS20 telegram: phase in progress too long -> no 6th byte */
+    if (bPend && (edgeTail == edgeHead))
+    {
+        noInterrupts();
+        U32 usIdle = micros() - edgeLast;
+        interrupts();
+        if (usIdle > FS20RX_PHASE_MAX)
+        {
+            resetState(false);
+        }
+    }
+    return (U8)(statDecoded - decoded);
+}
+
+//------------------------------------------------------------------------------
+// Get next decoded telegram, FALSE if none
+//------------------------------------------------------------------------------
+bool objFs20Rx::Read(fs20RxTelegram *pTg)
+{
+    if (tgTail == tgHead)
+    {
+        return false; // EMPTY
+    }
+    *pTg = tgRing[tgTail];
+    tgTail = (tgTail + 1) & (FS20RX_TG_LEN - 1);
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Statistic
+//------------------------------------------------------------------------------
+void objFs20Rx::GetStats(U16 *rxDecoded, U16 *rxRepeat, U16 *rxError, U16 *rxLost)
+{
+    *rxDecoded = statDecoded;
+    *rxRepeat = statRepeat;
+    *rxError = statError;
+    *rxLost = statLost;
+}
+
+//------------------------------------------------------------------------------
+// Internal - HIGH phase is stored, the following LOW phase completes a bit
+//------------------------------------------------------------------------------
+void objFs20Rx::decodePhase(U16 phase)
+{
+    U16 usLen = phase & (~FS20RX_HIGH);
+    bool bValid = (usLen >= FS20RX_PHASE_MIN) && (usLen <= FS20RX_PHASE_MAX);
+    
+    if (phase & FS20RX_HIGH)
+    {
+        rxHigh = bValid ? usLen : 0;
+        if (!bValid)
+        {
+            resetState(rxState == FS20RX_ST_DATA);
+        }
+        return;
+    }
+    
+    /* LOW phase without valid HIGH phase (noise, gap) */
+    if ((rxHigh == 0) || !bValid)
+    {
+        rxHigh = 0;
+        resetState(rxState == FS20RX_ST_DATA);
+        return;
+    }
+    
+    U16 period = rxHigh + usLen;
+    rxHigh = 0;
+    if ((period >= FS20RX_ZERO_MIN) && (period < FS20RX_ZERO_MAX))
+    {
+        decodeBit(0);
+    }
+    else if ((period >= FS20RX_ZERO_MAX) && (period <= FS20RX_ONE_MAX))
+    {
+        decodeBit(1);
+    }
+    else
+    {
+        resetState(rxState == FS20RX_ST_DATA);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Telegram state machine
+//------------------------------------------------------------------------------
+void objFs20Rx::decodeBit(U8 aBit)
+{
+    if (rxState == FS20RX_ST_SYNC)
+    {
+        if (aBit == 0)
+        {
+            if (rxSync < 0xFF)
+                rxSync++;
+        }
+        else if (rxSync >= FS20RX_SYNC_MIN)
+        {
+            /* Start bit */
+            rxState = FS20RX_ST_DATA;
+            rxShift = 0;
+            rxBitCnt = 0;
+            rxByteCnt = 0;
+        }
+        else
+        {
+            rxSync = 0;
+        }
+        return;
+    }
+    
+    /* 8 data bits (MSB first) + parity */
+    rxShift = (rxShift << 1) | aBit;
+    if (++rxBitCnt < 9)
+        return;
+    
+    U8 data = (U8)(rxShift >> 1);
+    U8 parity = data ^ (data >> 4);
+    parity ^= (parity >> 2);
+    parity ^= (parity >> 1);
+    if ((parity & 0x01) != (rxShift & 0x01))
+    {
+        resetState(true);
+        return;
+    }
+    rxData[rxByteCnt++] = data;
+    rxShift = 0;
+    rxBitCnt = 0;
+    
+    if (rxByteCnt >= 5)
+    {
+        if (checkTelegram() || (rxByteCnt >= 6))
+        {
+            /* Done or invalid -> next telegram needs new sync */
+            resetState(false);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Validate checksum, TRUE if telegram complete (also if invalid)
+//------------------------------------------------------------------------------
+bool objFs20Rx::checkTelegram(void)
+{
+    U8 dataLen = rxByteCnt - 1;
+    U8 sum = 0;
+    for (U8 i=0; i<dataLen; i++)
+    {
+        sum += rxData[i];
+    }
+    U8 chk = rxData[dataLen];
+    
+    fs20RxTelegram tg;
+    tg.homeCode = ((U16)rxData[0] << 8) | rxData[1];
+    tg.addrByte = rxData[2];
+    tg.cmdByte = rxData[3];
+    tg.extByte = (dataLen > 4) ? rxData[4] : 0;
+    tg.rxLen = dataLen;
+    
+    /* FS20 without extension: 5 bytes */
+    if (dataLen == 4)
+    {
+        if (((rxData[3] & 0x20) == 0) && ((U8)(sum + FS20RX_CHK_FS20) == chk))
+        {
+            /* Or start of FHT -> held until 6th byte or end of telegram */
+            tg.rxType = FS20RX_TYPE_FS20;
+            tgPend = tg;
+            bPend = true;
+        }
+        /* FS20 extension or FHT -> wait for 6th byte */
+        return false;
+    }
+    
+    if ((U8)(sum + FS20RX_CHK_FHT) == chk)
+    {
+        bPend = false;
+        tg.rxType = FS20RX_TYPE_FHT;
+    }
+    else if (bPend)
+    {
+        /* FS20 (cmd bit 5 clear -> no extension), reported by reset */
+        return true;
+    }
+    else if ((U8)(sum + FS20RX_CHK_FS20) == chk)
+    {
+        tg.rxType = FS20RX_TYPE_FS20;
+    }
+    else
+    {
+        statError++;
+        return true;
+    }
+    addTelegram(&tg);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Add decoded telegram, suppress repetitions
+//------------------------------------------------------------------------------
+void objFs20Rx::addTelegram(fs20RxTelegram *pTg)
+{
+    U32 msNow = millis();
+    if ((pTg->rxType == tgLast.rxType) && (pTg->homeCode == tgLast.homeCode) &&
+        (pTg->addrByte == tgLast.addrByte) && (pTg->cmdByte == tgLast.cmdByte) &&
+        (pTg->extByte == tgLast.extByte) && 
+        ((U32)(msNow - tgLastTime) < FS20RX_REP_TIME))
+    {
+        tgLastTime = msNow;
+        statRepeat++;
+        return;
+    }
+    tgLast = *pTg;
+    tgLastTime = msNow;
+    statDecoded++;
+    
+    U8 next = (tgHead + 1) & (FS20RX_TG_LEN - 1);
+    if (next == tgTail)
+    {
+        /* Oldest telegram is overwritten */
+        tgTail = (tgTail + 1) & (FS20RX_TG_LEN - 1);
+    }
+    tgRing[tgHead] = *pTg;
+    tgHead = next;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Back to sync (bError -> count broken telegram)
+//------------------------------------------------------------------------------
+void objFs20Rx::resetState(bool bError)
+{
+    if (bPend)
+    {
+        /* End of held FS20 telegram is no error */
+        bPend = false;
+        addTelegram(&tgPend);
+    }
+    else if (bError)
+    {
+        statError++;
+    }
+    rxState = FS20RX_ST_SYNC;
+    rxSync = 0;
+    rxShift = 0;
+    rxBitCnt = 0;
+    rxByteCnt = 0;
+}
+
+#endif // CE_OBJ_FS20RX
+// END OF objFs20Rx.cpp
@@ -0,0 +1,124 @@
+//------------------------------------------------------------------------------
+// File...: objFs20Rx.h
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objFs20Rx - FS20/FHT receive decoder (RX868 Modul)
+//------------------------------------------------------------------------------
+#ifndef _CPP_OBJFS20RX
+#define _CPP_OBJFS20RX
+
+#include "defGpio.h"
+
+//------------------------------------------------------------------------------
+/* Receive path (see objFs20.h for the protocol):
+ *
+ *   Pin change interrupt -> "Capture()" -> edge ring buffer
+ *   loop() -> "Decode()" -> bit classification -> telegram state machine
+ *          -> "Read()"
+ *
+ * Bit: HIGH + LOW phase, period 600..1000 us = 0; 1000..1450 us = 1
+ * Telegram: >= FS20RX_SYNC_MIN zero bits, start bit 1, bytes with parity,
+ *   FS20 : HC1 HC2 ADR CMD [EXT] CHK   CHK = 0x06 + sum of bytes
+ *   FHT  : HC1 HC2 FNC STA PAR   CHK   CHK = 0x0C + sum of bytes
+ * Repetitions (same telegram within FS20RX_REP_TIME) are suppressed.
+ *
+ * 5 bytes with cmd bit 5 clear and FS20 checksum may also be the start of
+ * an FHT telegram (1 of 256 FHT telegrams): the telegram is held until the
+ * 6th byte (FHT checksum -> FHT) or the end of the transmission (-> FS20).
+ * An FHT telegram with a broken 6th byte is then reported as FS20.
+ */
+//------------------------------------------------------------------------------
+
+/* Edge ring buffer (power of two) */
+#define FS20RX_EDGE_LEN     64
+
+/* Decoded telegram ring buffer (power of two) */
+#define FS20RX_TG_LEN        4
+
+/* Min. number of sync bits (transmitter sends 12) */
+#define FS20RX_SYNC_MIN      6
+
+/* Suppress repetition within [ms] */
+#define FS20RX_REP_TIME    250
+
+/* Telegram type */
+#define FS20RX_TYPE_FS20     1
+#define FS20RX_TYPE_FHT      2
+
+/* Decoded telegram */
+typedef struct
+{
+    U8  rxType;       // FS20RX_TYPE_xxx
+    U16 homeCode;
+    U8  addrByte;     // FHT: function
+    U8  cmdByte;      // FHT: status
+    U8  extByte;      // FS20 extension (cmd bit 5) / FHT parameter
+    U8  rxLen;        // Number of data bytes without checksum (4 or 5)
+} fs20RxTelegram;
+
+//==============================================================================
+// OBJECT CLASS: objFs20Rx - FS20/FHT receive decoder
+//==============================================================================
+class objFs20Rx
+{
+    public:
+        /* Class constructor */
+        objFs20Rx(void);
+        
+        /* Initialize RX868 data pin with pin change interrupt */
+        /* (dataPin=0xFF -> no interrupt, feed "Capture()" with micros()) */
+        bool Init(U8 dataPin);
+        
+        /* Store edge (time [us], new pin level), called by interrupt */
+        void Capture(U32 usTime, bool bLevel);
+        
+        /* Decode max. "maxEdges" from edge buffer, return decoded telegrams */
+        U8 Decode(U8 maxEdges);
+        
+        /* Get next decoded telegram, FALSE if none */
+        bool Read(fs20RxTelegram *pTg);
+        
+        /* Statistic: decoded telegrams, suppressed repetitions, */
+        /* rejected (parity, checksum, timing) and lost edges */
+        void GetStats(U16 *rxDecoded, U16 *rxRepeat, U16 *rxError, U16 *rxLost);
+        
+    private:
+        /* Edge ring buffer: phase length [us], bit 15 = HIGH phase */
+        U16 edgeRing[FS20RX_EDGE_LEN];
+        volatile U8 edgeHead;
+        volatile U8 edgeTail;
+        U32 edgeLast;
+        
+        /* Telegram state machine */
+        U8 rxState;
+        U16 rxHigh;
+        U8 rxSync;
+        U16 rxShift;
+        U8 rxBitCnt;
+        U8 rxData[6];
+        U8 rxByteCnt;
+        fs20RxTelegram tgPend;   // FS20 or start of FHT (see above)
+        bool bPend;
+        
+        /* Decoded telegrams and last telegram (repetition) */
+        fs20RxTelegram tgRing[FS20RX_TG_LEN];
+        U8 tgHead;
+        U8 tgTail;
+        fs20RxTelegram tgLast;
+        U32 tgLastTime;
+        
+        /* Statistic */
+        U16 statDecoded;
+        U16 statRepeat;
+        U16 statError;
+        volatile U16 statLost;
+        
+        void decodePhase(U16 phase);
+        void decodeBit(U8 aBit);
+        bool checkTelegram(void);
+        void addTelegram(fs20RxTelegram *pTg);
+        void resetState(bool bError);
+};
+
+#endif // _CPP_OBJFS20RX
@@ -0,0 +1,205 @@
+//------------------------------------------------------------------------------
+// File...: objIccBus.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objIccBus - Scheduler for several I2C devices and buses
+//------------------------------------------------------------------------------
+#include "classEnable.h"
+#ifdef CE_OBJ_ICCBUS
+#include <Arduino.h>
+#include "objIccBus.h"
+
+//------------------------------------------------------------------------------
+// Class constructor
+//------------------------------------------------------------------------------
+objIccBus::objIccBus(void)
+{
+    devCnt = 0;
+    rrNext = 0;
+    ClearStats();
+}
+
+//------------------------------------------------------------------------------
+// Insert device with service function, FALSE if full
+//------------------------------------------------------------------------------
+bool objIccBus::Insert(void *pDevice, iccService pService, iccBus *pBus, U8 prio)
+{
+    return insertSlot(pDevice, pService, NULL, pBus, prio);
+}
+
+//------------------------------------------------------------------------------
+// Internal - Insert device, bus by "pGetBus" (NULL -> fixed "pBus")
+//------------------------------------------------------------------------------
+bool objIccBus::insertSlot(void *pDevice, iccService pService, iccBusFunc pGetBus,
+                           iccBus *pBus, U8 prio)
+{
+    if ((devCnt >= ICC_DEV_MAX) || (pService == NULL))
+    {
+        return false; // ERROR
+    }
+    
+    iccSlot *pSlot = &devSlot[devCnt];
+    pSlot->pDev = pDevice;
+    pSlot->pService = pService;
+    pSlot->pGetBus = pGetBus;
+    pSlot->pBus = pBus;
+    pSlot->devTrans = 0;
+    devCnt++;
+    return SetPriority(pDevice, prio);
+}
+
+//------------------------------------------------------------------------------
+// Change priority of device (1..15), FALSE if not inserted
+//------------------------------------------------------------------------------
+bool objIccBus::SetPriority(void *pDevice, U8 prio)
+{
+    iccSlot *pSlot = findSlot(pDevice);
+    if (pSlot == NULL)
+    {
+        return false; // ERROR
+    }
+    
+    if (prio < ICC_PRIO_MIN)
+        prio = ICC_PRIO_MIN;
+    G_LIMIT(prio, ICC_PRIO_MAX);
+    pSlot->devPrio = prio;
+    pSlot->devCredit = prio;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Service function: max. one transaction per bus, return count
+//------------------------------------------------------------------------------
+U8 objIccBus::Tick(void)
+{
+    iccBus *busUsed[ICC_BUS_MAX];
+    U8 busCnt = 0;
+    U8 trCnt = 0;
+    U8 rrStart = rrNext;
+    
+    /* Bus may be changed by "SetBus()" after "Insert()" */
+    for (U8 i=0; i<devCnt; i++)
+    {
+        if (devSlot[i].pGetBus != NULL)
+        {
+            devSlot[i].pBus = devSlot[i].pGetBus(devSlot[i].pDev);
+        }
+    }
+    
+    for (U8 n=0; n<devCnt; n++)
+    {
+        U8 idx = (rrStart + n) % devCnt;
+        iccSlot *pSlot = &devSlot[idx];
+        if ((pSlot->devCredit == 0) || isBusUsed(pSlot->pBus, busUsed, busCnt))
+            continue;
+        
+        if (pSlot->pService(pSlot->pDev))
+        {
+            pSlot->devCredit--;
+            pSlot->devTrans++;
+            trCnt++;
+            if (busCnt < ICC_BUS_MAX)
+            {
+                busUsed[busCnt++] = pSlot->pBus;
+            }
+            
+            /* Next tick starts behind the last served device */
+            rrNext = (idx + 1) % devCnt;
+        }
+    }
+    
+    /* Round of a bus complete: credits used up or remaining devices idle */
+    bool bRefill[ICC_DEV_MAX];
+    for (U8 i=0; i<devCnt; i++)
+    {
+        iccBus *pBus = devSlot[i].pBus;
+        bool bCredit = false;
+        for (U8 k=0; k<devCnt; k++)
+        {
+            if ((devSlot[k].pBus == pBus) && (devSlot[k].devCredit > 0))
+            {
+                bCredit = true;
+                break;
+            }
+        }
+        bRefill[i] = (!bCredit || !isBusUsed(pBus, busUsed, busCnt));
+    }
+    for (U8 i=0; i<devCnt; i++)
+    {
+        if (bRefill[i])
+        {
+            devSlot[i].devCredit = devSlot[i].devPrio;
+        }
+    }
+    statTrans += trCnt;
+    return trCnt;
+}
+
+//------------------------------------------------------------------------------
+// Transactions of device since last clear
+//------------------------------------------------------------------------------
+U32 objIccBus::GetTrans(void *pDevice)
+{
+    iccSlot *pSlot = findSlot(pDevice);
+    return (pSlot != NULL) ? pSlot->devTrans : 0;
+}
+
+//------------------------------------------------------------------------------
+// Transactions per second (all devices) since last clear
+//------------------------------------------------------------------------------
+U32 objIccBus::GetThroughput(void)
+{
+    U32 msTime = millis() - statStart;
+    if (msTime == 0)
+    {
+        return 0;
+    }
+    return (statTrans * 1000) / msTime;
+}
+
+//------------------------------------------------------------------------------
+// Clear statistic
+//------------------------------------------------------------------------------
+void objIccBus::ClearStats(void)
+{
+    statTrans = 0;
+    statStart = millis();
+    for (U8 i=0; i<devCnt; i++)
+    {
+        devSlot[i].devTrans = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - TRUE if bus is in list of used buses
+//------------------------------------------------------------------------------
+bool objIccBus::isBusUsed(iccBus *pBus, iccBus **busList, U8 busCnt)
+{
+    for (U8 i=0; i<busCnt; i++)
+    {
+        if (busList[i] == pBus)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Find slot of device
+//------------------------------------------------------------------------------
+iccSlot *objIccBus::findSlot(void *pDevice)
+{
+    for (U8 i=0; i<devCnt; i++)
+    {
+        if (devSlot[i].pDev == pDevice)
+        {
+            return &devSlot[i];
+        }
+    }
+    return NULL;
+}
+
+#endif // CE_OBJ_ICCBUS
+// END OF objIccBus.cpp
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// File...: objIccBus.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objIccBus - Scheduler for several I2C devices and buses
+//------------------------------------------------------------------------------
+#ifndef _CPP_OBJICCBUS
+#define _CPP_OBJICCBUS
+
+//------------------------------------------------------------------------------
+/* Every device queues its own transactions (e.g. objRadio) and executes max.
+ * one per service call. objIccBus calls the devices round-robin, max. one
+ * transaction per bus and "Tick()", devices on different buses run in the
+ * same tick. Priority = transactions per round (1..15):
+ *
+ *   objIccBus busMgr;
+ *   busMgr.Insert(&radio1, 4);      // radio on "Wire", 4 per round
+ *   busMgr.Insert(&radio2, 1);      // radio2.SetBus(&wire1Bus)
+ *   loop() { busMgr.Tick(); }
+ */
+//------------------------------------------------------------------------------
+
+/* I2C bus interface */
+#include "defIccBus.h"
+
+/* Number of devices and buses */
+#define ICC_DEV_MAX        8
+#define ICC_BUS_MAX        4
+
+/* Priority range */
+#define ICC_PRIO_MIN       1
+#define ICC_PRIO_MAX      15
+
+/* Service function: max. one transaction, TRUE if the bus was used */
+typedef bool (*iccService)(void *pDevice);
+
+/* Current bus of device (NULL -> bus of "Insert()") */
+typedef iccBus *(*iccBusFunc)(void *pDevice);
+
+/* Device slot */
+typedef struct
+{
+    void *pDev;
+    iccService pService;
+    iccBusFunc pGetBus;
+    iccBus *pBus;
+    U8 devPrio;       // Transactions per round
+    U8 devCredit;     // Transactions left in this round
+    U32 devTrans;     // Executed transactions since "ClearStats()"
+} iccSlot;
+
+//==============================================================================
+// OBJECT CLASS: objIccBus - I2C device scheduler
+//==============================================================================
+class objIccBus
+{
+    public:
+        /* Class constructor */
+        objIccBus(void);
+        
+        /* Insert device with service function, FALSE if full */
+        bool Insert(void *pDevice, iccService pService, iccBus *pBus, U8 prio);
+        
+        /* Insert device with "bool Tick()" and "iccBus *GetBus()" */
+        /* (objRadio, ...), FALSE if full; bus is read in every "Tick()" */
+        template <class DEV>
+        bool Insert(DEV *pDevice, U8 prio)
+        {
+            return insertSlot(pDevice, &serviceTick<DEV>, &busOf<DEV>, 
+                              pDevice->GetBus(), prio);
+        }
+        
+        /* Change priority of device (1..15), FALSE if not inserted */
+        bool SetPriority(void *pDevice, U8 prio);
+        
+        /* Service function: max. one transaction per bus, return count */
+        U8 Tick(void);
+        
+        /* Transactions of device since last clear */
+        U32 GetTrans(void *pDevice);
+        
+        /* Transactions per second (all devices) since last clear */
+        U32 GetThroughput(void);
+        
+        /* Clear statistic */
+        void ClearStats(void);
+        
+    private:
+        iccSlot devSlot[ICC_DEV_MAX];
+        U8 devCnt;
+        U8 rrNext;
+        U32 statTrans;
+        U32 statStart;
+        
+        bool insertSlot(void *pDevice, iccService pService, iccBusFunc pGetBus,
+                        iccBus *pBus, U8 prio);
+        iccSlot *findSlot(void *pDevice);
+        bool isBusUsed(iccBus *pBus, iccBus **busList, U8 busCnt);
+        
+        template <class DEV>
+        static bool serviceTick(void *pDevice) { return ((DEV *)pDevice)->Tick(); }
+        
+        template <class DEV>
+        static iccBus *busOf(void *pDevice) { return ((DEV *)pDevice)->GetBus(); }
+};
+
+#endif // _CPP_OBJICCBUS
@@ -10,6 +10,20 @@
 #include <Arduino.h>
 #include "objKey.h"
 
+//------------------------------------------------------------------------------
+// Times in ticks
+//------------------------------------------------------------------------------
+#define KEY_DEBOUNCE_TICKS  (KEY_DEBOUNCE_MS / KEY_TICK_MS)
+
+#define KEY_BIT(bitPos)     ((keyMask)1 << (bitPos))
+
+/* Gesture state */
+#define KEY_GS_DOWN         0x01
+#define KEY_GS_LONG         0x02  // Long press sent (no click)
+#define KEY_GS_CLICK        0x04  // Released, waiting for second click
+#define KEY_GS_SECOND       0x08  // Second press within double click time
+#define KEY_GS_CHORD        0x10  // Part of a chord (no further gestures)
+
 //------------------------------------------------------------------------------
 // Class constructor 
 //------------------------------------------------------------------------------
@@ -18,7 +32,58 @@ objKey::objKey(void)
     keyCnt = 0;
     for (int i=0; i<KEY_CNT_MAX; i++)
     {        
-        keyPin[i] = 0;
+        keyBit[i] = 0;
+    }
+#ifdef __AVR__
+    portCnt = 0;
+#endif
+    keyState = 0;
+    vcCnt0 = (keyMask)~0;
+    vcCnt1 = (keyMask)~0;
+    keyLatch = 0;
+    tickLast = 0;
+#if KEY_MATRIX_CNT > 0
+    rowCnt = 0;
+    colCnt = 0;
+    rowScan = 0;
+    for (U8 r=0; r<KEY_MATRIX_ROWS; r++)
+    {
+        rowRaw[r] = 0;
+        rowState[r] = 0;
+        rowCnt0[r] = 0xFF;
+        rowCnt1[r] = 0xFF;
+        rowLatch[r] = 0;
+    }
+    mxTickLast = 0;
+    statGhost = 0;
+#endif
+    evHead = 0;
+    evTail = 0;
+    statLost = 0;
+    
+    /* Gestures: all keys use the default profile 0 */
+    for (U8 p=0; p<KEY_PROFILE_CNT; p++)
+    {
+        profTable[p].msLong = KEY_LONG_MS;
+        profTable[p].msDouble = KEY_DOUBLE_MS;
+        profTable[p].msRepeat = KEY_REPEAT_MS;
+        profTable[p].msRepeatMin = KEY_REPEAT_MIN_MS;
+        profTable[p].repeatAccel = KEY_REPEAT_ACCEL;
+    }
+    for (U8 i=0; i<(KEY_CNT_MAX + KEY_MATRIX_CNT); i++)
+    {
+        keyProfileIdx[i] = 0;
+    }
+    for (U8 a=0; a<KEY_ACTIVE_MAX; a++)
+    {
+        actTable[a].keyIndex = 0;
+    }
+    for (U8 c=0; c<KEY_CHORD_MAX; c++)
+    {
+        for (U8 k=0; k<KEY_CHORD_KEYS; k++)
+        {
+            chordKeys[c][k] = 0;
+        }
     }
 }
 
@@ -27,30 +92,495 @@ objKey::objKey(void)
 //------------------------------------------------------------------------------
 bool objKey::Insert(U8 pinNumber)
 {
-    if (keyCnt < KEY_CNT_MAX)
-    {         
-        keyPin[keyCnt] = pinNumber;        
-        pinMode(pinNumber, INPUT_PULLUP);        
-        keyCnt++;
-        return true; // OK
+    if (keyCnt >= KEY_CNT_MAX)
+    {
+        return false; // ERROR
+    }
+    if (!keyPin[keyCnt].Bind(pinNumber, INPUT_PULLUP))
+    {
+        return false; // ERROR
+    }
+    
+#ifdef __AVR__
+    /* Bit in keyMask = 8 * port slot + bit in port */
+    volatile U8 *pIn = keyPin[keyCnt].InPort();
+    U8 pinMask = keyPin[keyCnt].Mask();
+    U8 slot = 0;
+    while ((slot < portCnt) && (portIn[slot] != pIn))
+    {
+        slot++;
+    }
+    if (slot >= KEY_PORT_MAX)
+    {
+        return false; // ERROR
     }
-    return false; // ERROR
+    if (slot == portCnt)
+    {
+        portIn[slot] = pIn;
+        portMask[slot] = 0;
+        portCnt++;
+    }
+    if (portMask[slot] & pinMask)
+    {
+        return false; // ERROR
+    }
+    portMask[slot] |= pinMask;
+    U8 bitPos = 0;
+    while ((pinMask >> bitPos) > 1)
+    {
+        bitPos++;
+    }
+    keyBit[keyCnt] = (8 * slot) + bitPos;
+#else
+    keyBit[keyCnt] = keyCnt;
+#endif
+    keyCnt++;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Internal - Read all keys, bit = 1 if pressed (pull-up: LOW = pressed)
+//------------------------------------------------------------------------------
+keyMask objKey::readKeys(void)
+{
+    keyMask rawDown = 0;
+#ifdef __AVR__
+    for (U8 slot=0; slot<portCnt; slot++)
+    {
+        rawDown |= (keyMask)((U8)~(*portIn[slot]) & portMask[slot]) << (8 * slot);
+    }
+#else
+    for (U8 i=0; i<keyCnt; i++)
+    {
+        if (!keyPin[i].Read())
+        {
+            rawDown |= KEY_BIT(keyBit[i]);
+        }
+    }
+#endif
+    return rawDown;
 }
 
 //------------------------------------------------------------------------------
-// return TRUE if KEY "keyIndex" pressed and wait until release
+// Sample and debounce all keys every KEY_TICK_MS
+//------------------------------------------------------------------------------
+void objKey::Tick(void)
+{
+    U16 msNow = (U16)millis();
+#if KEY_MATRIX_CNT > 0
+    if ((rowCnt > 0) && ((U16)(msNow - mxTickLast) >= KEY_MATRIX_TICK_MS))
+    {
+        mxTickLast = msNow;
+        scanRow(msNow);
+    }
+#endif
+    if ((U16)(msNow - tickLast) < KEY_TICK_MS)
+        return;
+    tickLast = msNow;
+    gestUpdate(msNow);
+    
+    /* Vertical counter: count down while a key differs from its state, */
+    /* reset on equal sample, toggle state after 4 differing samples */
+    keyMask keyDiff = readKeys() ^ keyState;
+    vcCnt0 = ~(vcCnt0 & keyDiff);
+    vcCnt1 = vcCnt0 ^ (vcCnt1 & keyDiff);
+    keyMask keyToggle = keyDiff & vcCnt0 & vcCnt1;
+    keyState ^= keyToggle;
+    
+    if (keyToggle == 0)
+        return;
+    
+    /* Last edge was KEY_DEBOUNCE_TICKS - 1 samples ago */
+    U16 msEdge = msNow - ((KEY_DEBOUNCE_TICKS - 1) * KEY_TICK_MS);
+    for (U8 i=0; i<keyCnt; i++)
+    {
+        keyMask bitMask = KEY_BIT(keyBit[i]);
+        if (keyToggle & bitMask)
+        {
+            if (!(keyState & bitMask))
+            {
+                keyLatch |= bitMask;
+            }
+            KeyEdge(i + 1, (keyState & bitMask) != 0, msEdge);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Gesture profile 0..KEY_PROFILE_CNT-1, FALSE if invalid
+//------------------------------------------------------------------------------
+bool objKey::SetProfile(U8 profile, const keyProfile *pProfile)
+{
+    if ((profile >= KEY_PROFILE_CNT) || 
+        ((pProfile->msRepeat != 0) && (pProfile->msRepeat < pProfile->msRepeatMin)))
+    {
+        return false; // ERROR
+    }
+    profTable[profile] = *pProfile;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Use profile for KEY "keyIndex", FALSE if invalid
+//------------------------------------------------------------------------------
+bool objKey::SetGesture(U8 keyIndex, U8 profile)
+{
+    if ((keyIndex < 1) || (keyIndex > (KEY_CNT_MAX + KEY_MATRIX_CNT)) ||
+        (profile >= KEY_PROFILE_CNT))
+    {
+        return false; // ERROR
+    }
+    keyProfileIdx[keyIndex - 1] = profile;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Chord 1..KEY_CHORD_MAX of 2..KEY_CHORD_KEYS keys (keyNum 0 = clear)
+//------------------------------------------------------------------------------
+bool objKey::SetChord(U8 chordIndex, const U8 *pKeys, U8 keyNum)
+{
+    if ((chordIndex < 1) || (chordIndex > KEY_CHORD_MAX) || 
+        (keyNum == 1) || (keyNum > KEY_CHORD_KEYS))
+    {
+        return false; // ERROR
+    }
+    for (U8 k=0; k<KEY_CHORD_KEYS; k++)
+    {
+        chordKeys[chordIndex - 1][k] = (k < keyNum) ? pKeys[k] : 0;
+    }
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Debounced edge of a key (sampling or synthetic input)
+//------------------------------------------------------------------------------
+void objKey::KeyEdge(U8 keyIndex, bool bDown, U16 msTime)
+{
+    putEvent(keyIndex, bDown ? KEY_EV_PRESS : KEY_EV_RELEASE, msTime);
+    if ((keyIndex < 1) || (keyIndex > (KEY_CNT_MAX + KEY_MATRIX_CNT)))
+        return;
+    
+    const keyProfile *pProf = &profTable[keyProfileIdx[keyIndex - 1]];
+    keyActive *pAct = gestFind(keyIndex);
+    if (bDown)
+    {
+        if (pAct == NULL)
+        {
+            /* New key, no gestures if all entries are used */
+            pAct = gestFind(0);
+            if (pAct == NULL)
+                return;
+            pAct->keyIndex = keyIndex;
+            pAct->gestState = 0;
+        }
+        
+        /* Second press while waiting for double click */
+        pAct->gestState = (pAct->gestState & KEY_GS_CLICK) ? KEY_GS_SECOND : 0;
+        pAct->gestState |= KEY_GS_DOWN;
+        pAct->msTime = msTime;
+        pAct->msNext = pProf->msLong;
+        pAct->msInterval = pProf->msRepeat;
+        gestChord(keyIndex, msTime);
+        return;
+    }
+    
+    if (pAct == NULL)
+        return;
+    
+    U8 gestState = pAct->gestState;
+    pAct->gestState = 0;
+    pAct->keyIndex = 0;
+    if (gestState & (KEY_GS_LONG | KEY_GS_CHORD))
+        return;
+    
+    if (gestState & KEY_GS_SECOND)
+    {
+        putEvent(keyIndex, KEY_EV_DOUBLE, msTime);
+    }
+    else if (pProf->msDouble == 0)
+    {
+        putEvent(keyIndex, KEY_EV_CLICK, msTime);
+    }
+    else
+    {
+        /* Wait for second click */
+        pAct->keyIndex = keyIndex;
+        pAct->gestState = KEY_GS_CLICK;
+        pAct->msTime = msTime;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Active entry of key (keyIndex 0 = free entry), NULL = none
+//------------------------------------------------------------------------------
+keyActive *objKey::gestFind(U8 keyIndex)
+{
+    for (U8 a=0; a<KEY_ACTIVE_MAX; a++)
+    {
+        if (actTable[a].keyIndex == keyIndex)
+        {
+            return &actTable[a];
+        }
+    }
+    return NULL;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Chord complete with this key pressed?
+//------------------------------------------------------------------------------
+void objKey::gestChord(U8 keyIndex, U16 msTime)
+{
+    for (U8 c=0; c<KEY_CHORD_MAX; c++)
+    {
+        bool bMember = false;
+        bool bChord = (chordKeys[c][0] != 0);
+        for (U8 k=0; (k<KEY_CHORD_KEYS) && bChord; k++)
+        {
+            U8 chordKey = chordKeys[c][k];
+            if (chordKey == 0)
+                break;
+            bMember |= (chordKey == keyIndex);
+            
+            /* Pressed within KEY_CHORD_MS, not used by another chord */
+            keyActive *pAct = gestFind(chordKey);
+            bChord = (pAct != NULL) && 
+                     ((pAct->gestState & (KEY_GS_DOWN | KEY_GS_CHORD)) == KEY_GS_DOWN) &&
+                     ((U16)(msTime - pAct->msTime) <= KEY_CHORD_MS);
+        }
+        if (!bMember || !bChord)
+            continue;
+        
+        for (U8 k=0; (k<KEY_CHORD_KEYS) && (chordKeys[c][k] != 0); k++)
+        {
+            gestFind(chordKeys[c][k])->gestState |= KEY_GS_CHORD;
+        }
+        putEvent(c + 1, KEY_EV_CHORD, msTime);
+        return;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Time based gestures: long, repeat, click timeout
+//------------------------------------------------------------------------------
+void objKey::gestUpdate(U16 msNow)
+{
+    for (U8 a=0; a<KEY_ACTIVE_MAX; a++)
+    {
+        keyActive *pAct = &actTable[a];
+        if (pAct->keyIndex == 0)
+            continue;
+        const keyProfile *pProf = &profTable[keyProfileIdx[pAct->keyIndex - 1]];
+        U16 msDiff = msNow - pAct->msTime;
+        
+        if (pAct->gestState & KEY_GS_CLICK)
+        {
+            /* No second click -> single click */
+            if (msDiff > pProf->msDouble)
+            {
+                putEvent(pAct->keyIndex, KEY_EV_CLICK, pAct->msTime);
+                pAct->keyIndex = 0;
+            }
+            continue;
+        }
+        if ((pAct->gestState & KEY_GS_CHORD) || (pProf->msLong == 0) || 
+            (msDiff < pAct->msNext))
+            continue;
+        
+        /* No repeat: nothing after the long press (also not after wrap) */
+        if ((pAct->gestState & KEY_GS_LONG) && (pAct->msInterval == 0))
+            continue;
+        
+        if (!(pAct->gestState & KEY_GS_LONG))
+        {
+            pAct->gestState |= KEY_GS_LONG;
+            putEvent(pAct->keyIndex, KEY_EV_LONG, msNow);
+        }
+        else
+        {
+            putEvent(pAct->keyIndex, KEY_EV_REPEAT, msNow);
+            
+            /* Accelerate */
+            U16 msShort = ((U32)pAct->msInterval * pProf->repeatAccel) >> 8;
+            pAct->msInterval -= msShort;
+            if (pAct->msInterval < pProf->msRepeatMin)
+            {
+                pAct->msInterval = pProf->msRepeatMin;
+            }
+        }
+        
+        if (pAct->msInterval == 0)
+        {
+            /* No repeat -> stop after long press */
+            pAct->msNext = 0xFFFF;
+        }
+        else
+        {
+            pAct->msNext += pAct->msInterval;
+            
+            /* Keep hold time in range of U16 (long repeat) */
+            if (pAct->msNext > 0x8000)
+            {
+                pAct->msTime += 0x4000;
+                pAct->msNext -= 0x4000;
+            }
+        }
+    }
+}
+
+#if KEY_MATRIX_CNT > 0
+//------------------------------------------------------------------------------
+// Insert key matrix: row pins (driven) and column pins (read)
+//------------------------------------------------------------------------------
+bool objKey::InsertMatrix(const U8 *pRowPins, U8 rowNum, const U8 *pColPins, U8 colNum)
+{
+    if ((rowCnt > 0) || (rowNum == 0) || (rowNum > KEY_MATRIX_ROWS) ||
+        (colNum == 0) || (colNum > KEY_MATRIX_COLS))
+    {
+        return false; // ERROR
+    }
+    
+    /* Rows open (high impedance), columns with pull-up */
+    for (U8 r=0; r<rowNum; r++)
+    {
+        rowPin[r].Bind(pRowPins[r], INPUT);
+    }
+    for (U8 c=0; c<colNum; c++)
+    {
+        colPin[c].Bind(pColPins[c], INPUT_PULLUP);
+    }
+    rowCnt = rowNum;
+    colCnt = colNum;
+    
+    /* Drive first row, read at the next tick */
+    rowScan = 0;
+    pinMode(rowPin[0].Number(), OUTPUT);
+    rowPin[0].Low();
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Internal - Read columns of the driven row, drive next row, debounce
+//------------------------------------------------------------------------------
+void objKey::scanRow(U16 msNow)
+{
+    U8 row = rowScan;
+    U8 rawCols = 0;
+    for (U8 c=0; c<colCnt; c++)
+    {
+        if (!colPin[c].Read())
+        {
+            rawCols |= (1 << c);
+        }
+    }
+    
+    /* Release row, next row settles until the next tick */
+    pinMode(rowPin[row].Number(), INPUT);
+    rowScan = ((row + 1) < rowCnt) ? (row + 1) : 0;
+    pinMode(rowPin[rowScan].Number(), OUTPUT);
+    rowPin[rowScan].Low();
+    
+    /* Ghost keys: two or more common columns with another row */
+    U8 ghostCols = 0;
+    for (U8 r=0; r<rowCnt; r++)
+    {
+        U8 common = rawCols & rowRaw[r];
+        if ((r != row) && (common & (common - 1)))
+        {
+            ghostCols |= common;
+        }
+    }
+    rowRaw[row] = rawCols;
+    if (ghostCols)
+    {
+        statGhost++;
+        rawCols = (rawCols & ~ghostCols) | (rowState[row] & ghostCols);
+    }
+    
+    /* Vertical counter of this row */
+    U8 colDiff = rawCols ^ rowState[row];
+    rowCnt0[row] = ~(rowCnt0[row] & colDiff);
+    rowCnt1[row] = rowCnt0[row] ^ (rowCnt1[row] & colDiff);
+    U8 colToggle = colDiff & rowCnt0[row] & rowCnt1[row];
+    rowState[row] ^= colToggle;
+    
+    if (colToggle == 0)
+        return;
+    
+    /* Every row is read once per scan, last edge 3 scans ago */
+    U16 msScan = rowCnt * KEY_MATRIX_TICK_MS;
+    U16 msEdge = msNow - (3 * msScan);
+    for (U8 c=0; c<colCnt; c++)
+    {
+        U8 bitMask = (1 << c);
+        if (colToggle & bitMask)
+        {
+            if (!(rowState[row] & bitMask))
+            {
+                rowLatch[row] |= bitMask;
+            }
+            KeyEdge(MatrixKey(row, c), (rowState[row] & bitMask) != 0, msEdge);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - TRUE if "keyIndex" is a matrix key (row and column)
+//------------------------------------------------------------------------------
+bool objKey::isMatrixKey(U8 keyIndex, U8 *pRow, U8 *pCol)
+{
+    if (keyIndex <= KEY_CNT_MAX)
+    {
+        return false;
+    }
+    U8 mxIndex = keyIndex - KEY_CNT_MAX - 1;
+    *pRow = mxIndex / KEY_MATRIX_COLS;
+    *pCol = mxIndex % KEY_MATRIX_COLS;
+    return ((*pRow < rowCnt) && (*pCol < colCnt));
+}
+#endif
+
+//------------------------------------------------------------------------------
+// Get next key event, FALSE if none
+//------------------------------------------------------------------------------
+bool objKey::GetEvent(keyEvent *pEvent)
+{
+    U8 tail = evTail;
+    if (tail == evHead)
+    {
+        return false; // EMPTY
+    }
+    *pEvent = evRing[tail];
+    evTail = (tail + 1) & (KEY_EVENT_LEN - 1);
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// return TRUE once if KEY "keyIndex" was pressed and released
 //------------------------------------------------------------------------------
 bool objKey::KeyPressed(U8 keyIndex)
 {
+#if KEY_MATRIX_CNT > 0
+    U8 row, col;
+    if (isMatrixKey(keyIndex, &row, &col))
+    {
+        if (rowLatch[row] & (1 << col))
+        {
+            noInterrupts();
+            rowLatch[row] &= ~(1 << col);
+            interrupts();
+            return true; // KEY PRESSED
+        }
+        return false; // NO KEY PRESSED
+    }
+#endif
      if (isKeyRange(keyIndex))
      {
-        keyIndex--;
-        if (digitalRead(keyPin[keyIndex]) == LOW)
+        keyMask bitMask = KEY_BIT(keyBit[keyIndex - 1]);
+        if (keyLatch & bitMask)
         {
-            while (digitalRead(keyPin[keyIndex]) == LOW)
-            {
-                delay(100);
-            }          
+            noInterrupts();
+            keyLatch &= ~bitMask;
+            interrupts();
             return true; // KEY PRESSED
         }       
     }
@@ -58,14 +588,20 @@ bool objKey::KeyPressed(U8 keyIndex)
 }
 
 //------------------------------------------------------------------------------
-// return TRUE if KEY "keyIndex" pressed
+// return TRUE if KEY "keyIndex" pressed (debounced)
 //------------------------------------------------------------------------------
 bool objKey::KeyDown(U8 keyIndex)
 {
+#if KEY_MATRIX_CNT > 0
+    U8 row, col;
+    if (isMatrixKey(keyIndex, &row, &col))
+    {
+        return ((rowState[row] & (1 << col)) != 0);
+    }
+#endif
      if (isKeyRange(keyIndex))
      {
-        keyIndex--;
-        if (digitalRead(keyPin[keyIndex]) == LOW)
+        if (keyState & KEY_BIT(keyBit[keyIndex - 1]))
         {
             return true; // KEY PRESSED
         }       
@@ -74,21 +610,30 @@ bool objKey::KeyDown(U8 keyIndex)
 }
 
 //------------------------------------------------------------------------------
-// Check if KEY "keyIndex" pressed and wait until release
+// return TRUE while KEY "keyIndex" is still pressed
 //------------------------------------------------------------------------------
-void objKey::KeyWait(U8 keyIndex)
+bool objKey::KeyWait(U8 keyIndex)
 {
-     if (isKeyRange(keyIndex))
-     {
-        keyIndex--;                    
-        while (digitalRead(keyPin[keyIndex]) == LOW)
-        {
-            delay(100);
-        }          
-        return ;
-    }    
+    return KeyDown(keyIndex);
 }
 
+//------------------------------------------------------------------------------
+// Internal - Put event into ring (single producer)
+//------------------------------------------------------------------------------
+void objKey::putEvent(U8 keyIndex, U8 evType, U16 keyTime)
+{
+    U8 head = evHead;
+    U8 next = (head + 1) & (KEY_EVENT_LEN - 1);
+    if (next == evTail)
+    {
+        statLost++;
+        return;
+    }
+    evRing[head].keyIndex = keyIndex;
+    evRing[head].keyEvent = evType;
+    evRing[head].keyTime = keyTime;
+    evHead = next;
+}
 
 //------------------------------------------------------------------------------
 bool objKey::isKeyRange(U8 keyIndex)
@@ -100,4 +645,4 @@ bool objKey::isKeyRange(U8 keyIndex)
     return false;
 }
 #endif // CE_OBJ_KEY
-// END OF objKeycpp                 
\ No newline at end of file
+// END OF objKeycpp
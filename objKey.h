@@ -6,8 +6,134 @@
 #ifndef _CPP_OBJKEY
 #define _CPP_OBJKEY
 
+#include "defGpio.h"
+
+//------------------------------------------------------------------------------
+/* Key sampling (no function blocks):
+ *
+ *   loop() or timer interrupt -> "Tick()" -> read the key ports every
+ *   KEY_TICK_MS -> vertical counter debounce -> event ring -> "GetEvent()"
+ *
+ * AVR: every key is a bit of "keyMask" (8 bits per port), one read per
+ * port and a few bit operations debounce all keys at once. Other cores
+ * read the keys one by one into the same mask.
+ *
+ * Vertical counter: two bit planes count 4 equal samples per key, a key
+ * changes state after KEY_DEBOUNCE_MS of stable level. The event is in
+ * the ring at most one tick later, "keyTime" is the (estimated) time of
+ * the last edge -> latency = (U16)millis() - keyTime
+ */
+//------------------------------------------------------------------------------
+
+/* Number of 8 bit ports for keys (1, 2 or 4) */
+#define KEY_PORT_MAX 2
+
 /* Define number of KEY elements */
-#define KEY_CNT_MAX 8
+#define KEY_CNT_MAX (8 * KEY_PORT_MAX)
+
+#if KEY_PORT_MAX == 1
+  typedef U8 keyMask;
+#elif KEY_PORT_MAX == 2
+  typedef U16 keyMask;
+#elif KEY_PORT_MAX == 4
+  typedef U32 keyMask;
+#else
+  #error "KEY_PORT_MAX: 1, 2 or 4"
+#endif
+
+/* Key matrix (0 = none), max. 8 x 8, size also by compiler flags:
+ *   one row per KEY_MATRIX_TICK_MS is driven LOW (other rows open),
+ *   the columns are read with pull-up, every row has its own vertical
+ *   counter (debounce = 4 scans of all rows)
+ *   key index = KEY_CNT_MAX + 1 + row * KEY_MATRIX_COLS + col
+ * Ghost keys: if two rows share two or more pressed columns, a key of
+ * the rectangle may be a ghost -> these columns keep their state
+ */
+#ifndef KEY_MATRIX_ROWS
+  #define KEY_MATRIX_ROWS   0
+#endif
+#ifndef KEY_MATRIX_COLS
+  #define KEY_MATRIX_COLS   0
+#endif
+#define KEY_MATRIX_TICK_MS  1
+#define KEY_MATRIX_CNT      (KEY_MATRIX_ROWS * KEY_MATRIX_COLS)
+
+#if (KEY_MATRIX_ROWS > 8) || (KEY_MATRIX_COLS > 8)
+  #error "KEY_MATRIX_ROWS, KEY_MATRIX_COLS: max. 8 (column mask U8 per row)"
+#endif
+#if (KEY_MATRIX_ROWS == 0) != (KEY_MATRIX_COLS == 0)
+  #error "KEY_MATRIX_ROWS, KEY_MATRIX_COLS: both 0 or both 1..8"
+#endif
+
+/* Sample period and debounce (4 samples) [ms] */
+#define KEY_TICK_MS         5
+#define KEY_DEBOUNCE_MS    (4 * KEY_TICK_MS)
+
+/* Event ring buffer (power of two) */
+#define KEY_EVENT_LEN      16
+
+/* Event type */
+#define KEY_EV_PRESS        1
+#define KEY_EV_RELEASE      2
+#define KEY_EV_LONG         3     // Held for "msLong"
+#define KEY_EV_REPEAT       4     // Held after long press, accelerated
+#define KEY_EV_CLICK        5     // Released before long (no double click)
+#define KEY_EV_DOUBLE       6     // Second click within "msDouble"
+#define KEY_EV_CHORD        7     // keyIndex = chord number 1..KEY_CHORD_MAX
+
+/* Key event */
+typedef struct
+{
+    U8  keyIndex;     // 1..KEY_CNT_MAX, matrix keys behind
+    U8  keyEvent;     // KEY_EV_xxx
+    U16 keyTime;      // millis() of the last edge (low 16 bit)
+} keyEvent;
+
+//------------------------------------------------------------------------------
+/* Gestures (fed by the debounced edges, "KeyEdge()"):
+ *   every key uses one of KEY_PROFILE_CNT profiles (default 0), the state
+ *   is kept only for the max. KEY_ACTIVE_MAX keys pressed or waiting for
+ *   a double click -> fixed memory independent of the number of keys
+ *   - LONG after "msLong", then REPEAT starting with "msRepeat", every
+ *     repeat shortens the interval by repeatAccel/256 down to "msRepeatMin"
+ *   - CLICK on release before long press, with "msDouble" > 0 delayed
+ *     until no second click follows (then DOUBLE)
+ *   - CHORD if all keys of a chord are pressed within KEY_CHORD_MS, its
+ *     keys give no further gestures until released
+ */
+//------------------------------------------------------------------------------
+#define KEY_PROFILE_CNT     4
+#define KEY_ACTIVE_MAX      8
+#define KEY_CHORD_MAX       4
+#define KEY_CHORD_KEYS      3
+#define KEY_CHORD_MS      150
+
+/* Default profile 0 [ms] */
+#define KEY_LONG_MS       800     // 0 = no long press and repeat
+#define KEY_DOUBLE_MS       0     // 0 = no double click, CLICK at once
+#define KEY_REPEAT_MS     200     // 0 = no repeat after long press
+#define KEY_REPEAT_MIN_MS  50
+#define KEY_REPEAT_ACCEL   32     // [1/256] shorter per repeat
+
+/* Gesture profile */
+typedef struct
+{
+    U16 msLong;
+    U16 msDouble;
+    U16 msRepeat;
+    U16 msRepeatMin;
+    U8  repeatAccel;
+} keyProfile;
+
+/* Key in gesture processing */
+typedef struct
+{
+    U8  keyIndex;     // 0 = free
+    U8  gestState;    // KEY_GS_xxx
+    U16 msTime;       // Press time, release time while waiting for double
+    U16 msNext;       // Hold time of the next long / repeat event
+    U16 msInterval;   // Current repeat interval
+} keyActive;
 
 //==============================================================================
 // OBJECT CLASS: objKey - Multi Key Manager (Taster- Entprellung)
@@ -21,20 +147,101 @@ class objKey
         /* Insert new KEY and connect with GPIO "pinNumber" */
         bool Insert(U8 pinNumber);
         
-        /* return TRUE if KEY "keyIndex" pressed and wait until release */
+#if KEY_MATRIX_CNT > 0
+        /* Insert key matrix: row pins (driven) and column pins (read) */
+        bool InsertMatrix(const U8 *pRowPins, U8 rowNum, const U8 *pColPins, U8 colNum);
+        
+        /* Key index of matrix key */
+        static U8 MatrixKey(U8 row, U8 col) { return (KEY_CNT_MAX + 1 + (row * KEY_MATRIX_COLS) + col); }
+        
+        /* Scans with suppressed ghost keys */
+        U16 GetGhosts(void) { return statGhost; }
+#endif
+        
+        /* Sample and debounce all keys (call in loop or timer interrupt) */
+        void Tick(void);
+        
+        /* Gesture profile 0..KEY_PROFILE_CNT-1, FALSE if invalid */
+        bool SetProfile(U8 profile, const keyProfile *pProfile);
+        
+        /* Use profile for KEY "keyIndex", FALSE if invalid */
+        bool SetGesture(U8 keyIndex, U8 profile);
+        
+        /* Chord 1..KEY_CHORD_MAX of 2..KEY_CHORD_KEYS keys (keyNum 0 = clear) */
+        bool SetChord(U8 chordIndex, const U8 *pKeys, U8 keyNum);
+        
+        /* Debounced edge of a key (sampling or synthetic input) */
+        void KeyEdge(U8 keyIndex, bool bDown, U16 msTime);
+        
+        /* Get next key event, FALSE if none */
+        bool GetEvent(keyEvent *pEvent);
+        
+        /* return TRUE once if KEY "keyIndex" was pressed and released */
         bool KeyPressed(U8 keyIndex);
         
-        /* return TRUE if KEY "keyIndex" pressed */
+        /* return TRUE if KEY "keyIndex" pressed (debounced) */
         bool KeyDown(U8 keyIndex);        
         
-         /* Check if KEY "keyIndex" pressed and wait until release */
-        void KeyWait(U8 keyIndex);        
+        /* return TRUE while KEY "keyIndex" is still pressed */
+        bool KeyWait(U8 keyIndex);        
+        
+        /* Lost events (ring buffer full) */
+        U16 GetLostEvents(void) { return statLost; }
 
     private:        
-        U8 keyPin[KEY_CNT_MAX];        
+        gpioPin keyPin[KEY_CNT_MAX];        
         U8 keyCnt=0;
+        U8 keyBit[KEY_CNT_MAX];       // Bit of key in keyMask
+#ifdef __AVR__
+        volatile U8 *portIn[KEY_PORT_MAX];
+        U8 portMask[KEY_PORT_MAX];
+        U8 portCnt;
+#endif
+        
+        /* Debounced state, vertical counter, released keys */
+        keyMask keyState;
+        keyMask vcCnt0;
+        keyMask vcCnt1;
+        volatile keyMask keyLatch;
+        U16 tickLast;
+        
+        /* Gestures */
+        keyProfile profTable[KEY_PROFILE_CNT];
+        U8 keyProfileIdx[KEY_CNT_MAX + KEY_MATRIX_CNT];
+        keyActive actTable[KEY_ACTIVE_MAX];
+        U8 chordKeys[KEY_CHORD_MAX][KEY_CHORD_KEYS];
+        
+#if KEY_MATRIX_CNT > 0
+        /* Key matrix: state, vertical counter and latch per row */
+        gpioPin rowPin[KEY_MATRIX_ROWS];
+        gpioPin colPin[KEY_MATRIX_COLS];
+        U8 rowCnt;
+        U8 colCnt;
+        U8 rowScan;
+        U8 rowRaw[KEY_MATRIX_ROWS];
+        U8 rowState[KEY_MATRIX_ROWS];
+        U8 rowCnt0[KEY_MATRIX_ROWS];
+        U8 rowCnt1[KEY_MATRIX_ROWS];
+        volatile U8 rowLatch[KEY_MATRIX_ROWS];
+        U16 mxTickLast;
+        U16 statGhost;
+        
+        void scanRow(U16 msNow);
+        bool isMatrixKey(U8 keyIndex, U8 *pRow, U8 *pCol);
+#endif
+        
+        /* Event ring (producer: Tick, consumer: GetEvent) */
+        keyEvent evRing[KEY_EVENT_LEN];
+        volatile U8 evHead;
+        volatile U8 evTail;
+        U16 statLost;
+        
         bool isKeyRange(U8 keyIndex);
+        keyMask readKeys(void);
+        void putEvent(U8 keyIndex, U8 evType, U16 keyTime);
+        keyActive *gestFind(U8 keyIndex);
+        void gestChord(U8 keyIndex, U16 msTime);
+        void gestUpdate(U16 msNow);
 };            
 
 #endif // _CPP_OBJKEY
-
@@ -19,7 +19,6 @@ objLed::objLed(void)
     for (int i=0; i<LED_CNT_MAX; i++)
     {
         ledOn[i] = 0;
-        ledPin[i] = 0;
     }
 }
 
@@ -28,12 +27,10 @@ objLed::objLed(void)
 //------------------------------------------------------------------------------
 bool objLed::Insert(U8 pinNumber)
 {
-    if (ledCnt < LED_CNT_MAX)
+    if ((ledCnt < LED_CNT_MAX) && ledPin[ledCnt].Bind(pinNumber, OUTPUT))
     {
          ledOn[ledCnt] = 0;
-         ledPin[ledCnt] = pinNumber;
-         pinMode(pinNumber, OUTPUT);
-         digitalWrite(pinNumber, 0);
+         ledPin[ledCnt].Low();
          ledCnt++;
          return true; // OK
     }
@@ -49,7 +46,7 @@ bool objLed::SwitchPower(U8 ledIndex, U8 ledPower)
     {
         ledIndex--;
         ledOn[ledIndex] = (ledPower == 1) ? 1 : 0;
-        digitalWrite(ledPin[ledIndex], ledOn[ledIndex]);
+        ledPin[ledIndex].Write(ledOn[ledIndex]);
         return true; // OK
     }
     return false; // ERROR
@@ -64,7 +61,7 @@ bool objLed::SwitchToggle(U8 ledIndex)
     {
         ledIndex--;
         ledOn[ledIndex] = (ledOn[ledIndex] == 1) ? 0 : 1;
-        digitalWrite(ledPin[ledIndex], ledOn[ledIndex]);
+        ledPin[ledIndex].Write(ledOn[ledIndex]);
         return true; // OK
     }
     return false; // ERROR
@@ -9,7 +9,8 @@
 #define _CPP_OBJRADIO
 
 //------------------------------------------------------------------------------
-// Select your "Radio Tuner Chip"
+// Select your "Radio Tuner Chip" for "objRadio"
+// (other chips in the same firmware -> objRadioT<radioTea5767, RADIO_BAND>)
 //------------------------------------------------------------------------------
 //#define RADIO_TEA_5767  // I2C Chip ID = 0x60
 #define RADIO_RDA_5807M  // I2C Chip ID = 0x10
@@ -36,15 +37,13 @@
 //#define RADIO_DEBUG_MODE
 
 //------------------------------------------------------------------------------
-/* Change datatyp for radio register */
+/* Chip policy for "objRadio" (see defRadioChip.h) */
 #ifdef RADIO_TEA_5767
-  #define RADIO_DAT       U8
-  #define RADIO_BUF_SIZE  10
+  #define RADIO_CHIP      radioTea5767
   #define RADIO_ICC_ADDR  0x60  
 #else
 #ifdef RADIO_RDA_5807M
-  #define RADIO_DAT       U8
-  #define RADIO_BUF_SIZE  22
+  #define RADIO_CHIP      radioRda5807m
   #define RADIO_ICC_ADDR  0x10  
 #else
 #ifdef RADIO_SI4705
@@ -56,7 +55,19 @@
 #endif
 
 //------------------------------------------------------------------------------
-/* Frequence range on FM band */
+/* Band and channel spacing for "objRadio" (see defRadioChip.h):
+ *   radioBandEu (87-108 MHz), radioBandJp (76-91 MHz),
+ *   radioBandWorld (76-108 MHz), radioBandEast (65-76 MHz, only RDA5807M)
+ * All of them are built, objRadioT<CHIP, radioBandJp> can run beside objRadio.
+ * Other spacing (25/50/200 kHz) -> set RADIO_BAND_USER, it is built as well:
+ *   #define RADIO_BAND_USER radioBand<8700, 10800, 50, 0, 0>
+ *   #define RADIO_BAND      RADIO_BAND_USER */
+#define RADIO_BAND radioBandEu
+
+/* Default frequence after power-up (lower band limit if not in band) */
+#define RADIO_FDEF 10360
+
+/* Frequence range on FM band (radioBandEu, for "RADIO_TUNE_UP/DN") */
 #define RADIO_FMIN  8700
 #define RADIO_FMAX 10800
 
@@ -68,20 +79,179 @@
 #define RADIO_TUNE_UP(fq,st) if((fq)<RADIO_FMAX) (fq)+=(st);else (fq)=RADIO_FMIN
 #define RADIO_TUNE_DN(fq,st) if((fq)>RADIO_FMIN) (fq)-=(st);else (fq)=RADIO_FMAX
 
+//------------------------------------------------------------------------------
+/* Number of pending I2C transactions (see "Tick()") */
+#define RADIO_QUEUE_LEN    8
+
+/* Transaction types */
+#define RADIO_TR_REGISTER  1   // Write single register -> trArg = register
+#define RADIO_TR_MESSAGE   2   // Write regBuffer       -> trArg = length
+#define RADIO_TR_RECEIVE   3   // Read status registers -> trArg = length
+#define RADIO_TR_COMMIT    4   // Write all dirty registers (one burst)
+
+/* Flush dirty registers automatically in "Tick()" */
+#define RADIO_AUTO_COMMIT
+
+/* Radio state (power-up sequence) */
+#define RADIO_STATE_IDLE   0   // Init() not called
+#define RADIO_STATE_POWER  1   // Wait for power-up, then reset / configure
+#define RADIO_STATE_ENABLE 2   // (only RDA5807M) enable chip
+#define RADIO_STATE_TUNE   3   // (only RDA5807M) tune default channel
+#define RADIO_STATE_READY  4   // Transaction queue running
+
+/* (only RDA5807M) Poll period for RDS status registers [ms] */
+#define RADIO_RDS_POLL    40
+
+/* Seek / scan: status poll period [ms], max wait for RDS PI code [ms] */
+#define RADIO_SEEK_POLL   20
+#define RADIO_SCAN_PI  1500
+
+/* Number of entries in station table (see "ScanBand()") */
+#define RADIO_STATION_MAX 16
+
+/* Seek state */
+#define RADIO_SEEK_IDLE    0
+#define RADIO_SEEK_RUN     1   // Seek in progress
+#define RADIO_SEEK_DONE    2   // Station found -> "GetFrequence()"
+#define RADIO_SEEK_FAIL    3   // No station (band limit)
+
+/* Scan state */
+#define RADIO_SCAN_IDLE    0
+#define RADIO_SCAN_RUN     1   // Seek to next station
+#define RADIO_SCAN_RDS     2   // Wait for RDS PI code of found station
+#define RADIO_SCAN_PAUSE   3   // Time budget used -> resume with "ScanBand()"
+#define RADIO_SCAN_DONE    4   // Whole band scanned
+
+/* Setter without register (function not supported by chip) */
+#define RADIO_REG_NONE  0xFF
+
+/* Station flags */
+#define RADIO_ST_STEREO 0x01
+
+/* Signal quality: windows for "RADIO_SIG_MAX" frequences, */
+/* "RADIO_SIG_WIN" samples each (power of two) */
+#define RADIO_SIG_MAX      4
+#define RADIO_SIG_WIN     16
+
+/* Signal flags of last sample */
+#define RADIO_SG_TUNED  0x01   // Seek/tune complete (RDA STC; TEA RF)
+#define RADIO_SG_STATION 0x02  // Channel is a station (RDA FM_TRUE; TEA IF)
+#define RADIO_SG_READY  0x04   // Receiver ready (RDA FM_READY; TEA RF)
+
+/* Signal quality snapshot (see "GetSignal()") */
+typedef struct
+{
+    U16 sgFreq;    // Frequence (87,6 MHz -> 8760)
+    U8  sgCount;   // Samples in window (1..RADIO_SIG_WIN)
+    U8  sgMin;     // RSSI min, max and mean in window
+    U8  sgMax;
+    U8  sgMean;
+    U8  sgStereo;  // Stereo samples in window [%]
+    U8  sgFlags;   // RADIO_SG_xxx of last sample
+    U16 sgTune;    // Last tune-complete latency [ms] (0 = unknown)
+} radioSignal;
+
+/* Signal window per frequence (internal) */
+typedef struct
+{
+    U16 sqFreq;               // Frequence (0 = free)
+    U8  sqWin[RADIO_SIG_WIN]; // RSSI [6:0], stereo [7]
+    U8  sqPos;
+    U8  sqCount;
+    U16 sqSum;                // RSSI sum of window
+    U8  sqStereo;             // Stereo samples in window
+    U8  sqFlags;
+    U16 sqTune;
+    U32 sqLast;               // Time of last sample (replace oldest)
+} radioQuality;
+
+/* Station table entry */
+typedef struct
+{
+    U16 stFreq;   // Frequence (87,6 MHz -> 8760)
+    U8  stRssi;   // Signal level (RDA5807M 0..127; TEA5767 0..15)
+    U8  stFlags;  // RADIO_ST_xxx
+    U16 stPI;     // RDS program identification (0 = unknown)
+} radioStation;
+
+/* Completion callback -> called after every finished transaction */
+typedef void (*radioCallback)(U8 trType, U8 trArg);
+
+/* Queued I2C transaction */
+typedef struct
+{
+    U8  trType;   // RADIO_TR_xxx
+    U8  trArg;    // Register or length
+    U16 trWait;   // Bus idle time after transaction [ms]
+} radioTrans;
+
+/* RDS decoder (objRds.h) */
+class objRds;
+
+/* Chip policies */
+#include "defRadioChip.h"
+
+/* I2C bus interface */
+#include "defIccBus.h"
+
 //==============================================================================
-// OBJECT CLASS: objRadio - TEA5767, RDA5807M, ... 
+// OBJECT CLASS: objRadioT<CHIP, BAND> - TEA5767, RDA5807M, ... 
 //==============================================================================
-class objRadio
+template <class CHIP, class BAND = radioBandEu>
+class objRadioT
 {
     public:
-        objRadio(void);
+        objRadioT(void);
         
         /* Initialize radio chip (TEA5767, RDA5807M, .. ) */
         /* Use I2C address define -> deviceAddress=RADIO_ICC_ADDRC */
+        /* Power-up runs in background -> call "Tick()" in loop() */
         void Init(U8 deviceAddress);                       
         
-        /* Set FM frequence (87,6 MHz -> iFrequence=8760) */
-        void SetFrequence(U16 iFrequence);
+        /* Service function: power-up sequence and transaction queue */
+        /* Max. one bus transaction, TRUE if the bus was used */
+        bool Tick(void);
+        
+        /* Use other I2C bus (default: shared iccWire on "Wire"), call before Init */
+        void SetBus(iccBus *pIccBus) { pBus = pIccBus; }
+        
+        /* Get I2C bus (see objIccBus) */
+        iccBus *GetBus(void) { return pBus; }
+        
+        /* Queue I2C transaction (RADIO_TR_xxx), FALSE if queue full */
+        bool Submit(U8 trType, U8 trArg, U16 trWait);
+        
+        /* TRUE while power-up is running or transactions are pending */
+        bool IsBusy(void);
+        
+        /* Get radio state (RADIO_STATE_xxx) */
+        U8 GetState(void) { return radioState; }
+        
+        /* Set completion callback (NULL = none) */
+        void SetCallback(radioCallback pCallback) { doneFunc = pCallback; }
+        
+        /* Duration of last I2C transaction [us] */
+        U16 GetBusTime(void) { return busTime; }
+        
+        /* Write all changed registers in one bus transaction */
+        bool Commit(void) { return Submit(RADIO_TR_COMMIT, 0, 0); }
+        
+        /* Get number of I2C transactions and bytes since last clear */
+        void GetBusStats(U32 *busTrans, U32 *busBytes);
+        void ClearBusStats(void) { statTrans = 0; statBytes = 0; }
+        
+        /* Setter change regBuffer only -> written by "Commit()" or "Tick()" */
+        
+        /* Set FM frequence (87,6 MHz -> iFrequence=8760), FALSE if not in band */
+        /* Rounded to nearest channel of BAND */
+        bool SetFrequence(U16 iFrequence);
+        
+        /* Set channel of BAND (0..BAND::CHAN_CNT-1), FALSE if not in band */
+        /* Table lookup only, use BAND::Channel(8760) for constant stations */
+        bool SetChannel(U16 iChannel);
+        
+        /* Tune next channel up or down (UP->bUp=true), wrap at band limit */
+        void TuneStep(bool bUp);
         
         /* (only RDA5807M) Set volume (100% -> iVolume=15) */
         void SetVolume(U8 iVolume);
@@ -95,27 +265,132 @@ class objRadio
         /* (only RDA5807M) Activate Mono (ON->bBass=true; OFF->bBass=false) */        
         void SetMono(bool bMono);
         
-        /* (only TEA5767) Get signal level */
+        /* (only RDA5807M) Enable radio data system (ON->bRds=true) */
+        void SetRds(bool bRds);
+        
+        /* (only RDA5807M) Feed RDS groups to decoder in "Tick()" (NULL = off) */
+        void AttachRds(objRds *pRds) { rdsDec = pRds; }
+        
+        /* Get tuned frequence (87,6 MHz -> 8760) */
+        U16 GetFrequence(void) { return tuneFreq; }
+        
+        /* Get tuned channel of BAND */
+        U16 GetChannel(void) { return tuneChan; }
+        
+        /* Start hardware seek (UP->bUp=true), FALSE if scan running */
+        bool Seek(bool bUp);
+        
+        /* Get seek state (RADIO_SEEK_xxx) */
+        U8 GetSeekState(void) { return seekState; }
+        
+        /* Scan whole band in background, pause after "msBudget" (0=never) */
+        /* Call again to resume a paused scan, new scan if idle or done */
+        bool ScanBand(U16 msBudget);
+        
+        /* Get scan state (RADIO_SCAN_xxx) */
+        U8 GetScanState(void) { return scanState; }
+        
+        /* Get station table (sorted by frequence) and number of stations */
+        const radioStation *GetStations(U8 *stCnt);
+        
+        /* Load saved station table, FALSE if too many stations */
+        bool SetStations(const radioStation *pList, U8 stCnt);
+        
+        /* Tune station "stIndex" from table (0..stCnt-1) */
+        bool SelectStation(U8 stIndex);
+        
+        /* Get signal level and stereo flag (blocking read) */
+        /* TRUE if station (RDA5807M FM_TRUE) resp. data read (TEA5767) */
         U8 GetSignalLevel(U8 *sigLevel, U8 *bStereo);
         
+        /* Sample signal quality every "msPeriod" in "Tick()" (0 = off) */
+        /* Shares the status read of the RDS poll if a decoder is attached */
+        void SetSignalPoll(U16 msPeriod) { sigPeriod = msPeriod; }
+        
+        /* Get signal window of frequence (0 = tuned), FALSE if no samples */
+        bool GetSignal(U16 iFrequence, radioSignal *pSignal);
+        
+        /* Frequence with best mean RSSI from list (0 = none sampled) */
+        U16 GetBestSignal(const U16 *pList, U8 listCnt);
+        
+        /* Clear all signal windows */
+        void ClearSignal(void);
+        
         /* Print internal regBuffer (ONLY Serial Debug) */
         void DumpBuffer(void);
 
     private:                     
-        /* Internal I2C device address */
+        /* Internal I2C bus and device address */
+        iccBus *pBus;
         U8 devAddr;
         
-        /* Internal register buffer */
-        RADIO_DAT regBuffer[RADIO_BUF_SIZE];
+        /* Internal register buffer (size by chip policy) */
+        U8 regBuffer[CHIP::BUF_SIZE];
         
-        /* Internal frequence as backup */
-        U16 intFreq;
+        /* Power-up state and wait time */
+        U8 radioState;
+        U32 waitStart;
+        U16 waitTime;
+        
+        /* Transaction queue (ring buffer) */
+        radioTrans trQueue[RADIO_QUEUE_LEN];
+        U8 trHead;
+        U8 trCount;
+        radioCallback doneFunc;
+        U16 busTime;
+        
+        /* Changed registers in regBuffer (Bit 0 = first register) */
+        U8 dirtyMask;
+        
+        /* Seek and scan */
+        U16 tuneFreq;
+        U16 tuneChan;
+        U8 seekState;
+        U8 scanState;
+        U32 seekPoll;
+        U32 scanStart;
+        U16 scanBudget;
+        radioStation scanEntry;
+        radioStation stTable[RADIO_STATION_MAX];
+        U8 stCount;
+        
+        /* Signal quality windows, poll and tune latency */
+        radioQuality sigTable[RADIO_SIG_MAX];
+        U16 sigPeriod;
+        U32 sigPoll;
+        U8 tuneState;
+        U32 tuneStart;
+        
+        /* RDS decoder and last poll */
+        objRds *rdsDec;
+        U32 rdsPoll;
+        
+        /* Bus statistic */
+        U32 statTrans;
+        U32 statBytes;
         
         /* Internal communication functions */
         void SendRegister(U8 iRegister);        
         void SendMessage(U8 msgLen);        
         void ReceiveMessage(U8 recLen);
+        void runTransaction(radioTrans *pTrans);
+        void setWait(U16 msWait);
+        void setDirty(U8 iRegister);
+        void commitDirty(void);
+        void pollRds(void);
+        void pollSignal(void);
+        void addSignal(void);
+        radioQuality *findSignal(U16 iFrequence, bool bNew);
+        void startSeek(bool bUp, bool bWrap);
+        void pollSeek(void);
+        void serviceScan(void);
+        void addStation(radioStation *pStation);
 };            
 
+#ifdef RADIO_CHIP
+/* Radio object for selected chip and band */
+typedef objRadioT<RADIO_CHIP, RADIO_BAND> objRadio;
+#endif
+
 #endif // _CPP_OBJRADIO
 
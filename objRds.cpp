@@ -0,0 +1,373 @@
+//------------------------------------------------------------------------------
+// File...: objRds.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objRds - RDS/RBDS group decoder (PI, PTY, PS, RT, CT, AF)
+//------------------------------------------------------------------------------
+#include "classEnable.h"
+#ifdef CE_OBJ_RDS
+#include <Arduino.h>
+#include "objRds.h"
+
+//------------------------------------------------------------------------------
+// Internal defines
+//------------------------------------------------------------------------------
+#define RDS_BLK_A          0
+#define RDS_BLK_B          1
+#define RDS_BLK_C          2
+#define RDS_BLK_D          3
+
+/* Group types (Block B [15:12]) */
+#define RDS_GROUP_PS       0
+#define RDS_GROUP_RT       2
+#define RDS_GROUP_CT       4
+
+/* AF codes */
+#define RDS_AF_FM_MIN      1     // 87,6 MHz
+#define RDS_AF_FM_MAX    204     // 107,9 MHz
+
+/* RadioText end of text */
+#define RDS_RT_END      0x0D
+
+//------------------------------------------------------------------------------
+// Class constructor
+//------------------------------------------------------------------------------
+objRds::objRds(void)
+{
+    ringHead = 0;
+    ringTail = 0;
+    rdsErrMax = RDS_ERR_MAX;
+    statRecv = 0;
+    statError = 0;
+    statLost = 0;
+    Clear();
+}
+
+//------------------------------------------------------------------------------
+// Clear all decoded data (e.g. after frequence change)
+//------------------------------------------------------------------------------
+void objRds::Clear(void)
+{
+    rdsPI = 0;
+    rdsPTY = 0;
+    psMask = 0;
+    rtMask = 0;
+    rtLen = RDS_RT_LEN;
+    rtFlag = 0xFF;
+    ctValid = false;
+    afCnt = 0;
+    for (U8 i=0; i<RDS_PS_LEN; i++)
+    {
+        psBuf[i] = ' ';
+    }
+    psName[0] = 0;
+    for (U8 i=0; i<RDS_RT_LEN; i++)
+    {
+        rtBuf[i] = ' ';
+    }
+    rtText[0] = 0;
+}
+
+//------------------------------------------------------------------------------
+// Insert raw group into ring buffer, FALSE if buffer full
+//------------------------------------------------------------------------------
+bool objRds::Push(U16 blockA, U16 blockB, U16 blockC, U16 blockD, U8 blkErr)
+{
+    U8 next = (ringHead + 1) & (RDS_RING_LEN - 1);
+    if (next == ringTail)
+    {
+        statLost++;
+        return false; // ERROR
+    }
+
+    rdsGroup *pGroup = &rdsRing[ringHead];
+    pGroup->rdsBlock[RDS_BLK_A] = blockA;
+    pGroup->rdsBlock[RDS_BLK_B] = blockB;
+    pGroup->rdsBlock[RDS_BLK_C] = blockC;
+    pGroup->rdsBlock[RDS_BLK_D] = blockD;
+    pGroup->rdsErr = blkErr;
+    ringHead = next;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Decode max. "maxGroups" from ring buffer, return decoded groups
+//------------------------------------------------------------------------------
+U8 objRds::Decode(U8 maxGroups)
+{
+    U8 cnt = 0;
+    while ((cnt < maxGroups) && (ringTail != ringHead))
+    {
+        decodeGroup(&rdsRing[ringTail]);
+        ringTail = (ringTail + 1) & (RDS_RING_LEN - 1);
+        cnt++;
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// Get PS name (8 chars + 0), FALSE if not complete
+//------------------------------------------------------------------------------
+bool objRds::GetPS(char *pName)
+{
+    U8 i = 0;
+    do
+    {
+        pName[i] = psName[i];
+    } while (psName[i++] != 0);
+    return (psName[0] != 0);
+}
+
+//------------------------------------------------------------------------------
+// Get RadioText (max. 64 chars + 0), FALSE if not complete
+//------------------------------------------------------------------------------
+bool objRds::GetRT(char *pText)
+{
+    U8 i = 0;
+    do
+    {
+        pText[i] = rtText[i];
+    } while (rtText[i++] != 0);
+    return (rtText[0] != 0);
+}
+
+//------------------------------------------------------------------------------
+// Get clock time, FALSE if not received
+//------------------------------------------------------------------------------
+bool objRds::GetCT(rdsTime *pTime)
+{
+    if (ctValid)
+    {
+        *pTime = ctTime;
+    }
+    return ctValid;
+}
+
+//------------------------------------------------------------------------------
+// Get AF list (frequence 8760 = 87,6 MHz), return count
+//------------------------------------------------------------------------------
+U8 objRds::GetAF(U16 *pList, U8 afMax)
+{
+    U8 cnt = (afCnt < afMax) ? afCnt : afMax;
+    for (U8 i=0; i<cnt; i++)
+    {
+        pList[i] = afList[i];
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+// Statistic: received, rejected (error level) and lost groups
+//------------------------------------------------------------------------------
+void objRds::GetStats(U16 *grpRecv, U16 *grpError, U16 *grpLost)
+{
+    *grpRecv = statRecv;
+    *grpError = statError;
+    *grpLost = statLost;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Decode single group
+//------------------------------------------------------------------------------
+void objRds::decodeGroup(rdsGroup *pGroup)
+{
+    U8 errA = (pGroup->rdsErr >> 2) & 0x03;
+    U8 errB = pGroup->rdsErr & 0x03;
+    U16 blockB = pGroup->rdsBlock[RDS_BLK_B];
+
+    statRecv++;
+
+    /* Block B carries group type and segment address -> required */
+    if (errB > rdsErrMax)
+    {
+        statError++;
+        return;
+    }
+
+    /* New program -> forget everything from the old one */
+    if (errA <= rdsErrMax)
+    {
+        if ((rdsPI != 0) && (rdsPI != pGroup->rdsBlock[RDS_BLK_A]))
+        {
+            Clear();
+        }
+        rdsPI = pGroup->rdsBlock[RDS_BLK_A];
+    }
+    rdsPTY = (blockB >> 5) & 0x1F;
+
+    U8 grpType = (blockB >> 12) & 0x0F;
+    bool bVerB = (blockB & 0x0800) ? true : false;
+    switch (grpType)
+    {
+        case RDS_GROUP_PS:
+            decodePS(blockB & 0x03, pGroup->rdsBlock[RDS_BLK_D]);
+            if (!bVerB)
+            {
+                addAF(pGroup->rdsBlock[RDS_BLK_C] >> 8);
+                addAF(pGroup->rdsBlock[RDS_BLK_C] & 0xFF);
+            }
+            break;
+
+        case RDS_GROUP_RT:
+            /* Text A/B flag changed -> new RadioText */
+            if (((blockB >> 4) & 0x01) != rtFlag)
+            {
+                rtFlag = (blockB >> 4) & 0x01;
+                rtMask = 0;
+                rtLen = RDS_RT_LEN;
+                for (U8 i=0; i<RDS_RT_LEN; i++)
+                {
+                    rtBuf[i] = ' ';
+                }
+            }
+            decodeRT(blockB & 0x0F, bVerB, pGroup->rdsBlock[RDS_BLK_C],
+                     pGroup->rdsBlock[RDS_BLK_D]);
+            break;
+
+        case RDS_GROUP_CT:
+            if (!bVerB)
+            {
+                decodeCT(blockB, pGroup->rdsBlock[RDS_BLK_C],
+                         pGroup->rdsBlock[RDS_BLK_D]);
+            }
+            break;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - PS name: 4 segments with 2 chars
+//------------------------------------------------------------------------------
+void objRds::decodePS(U8 segAddr, U16 blockD)
+{
+    psBuf[segAddr * 2] = (char)(blockD >> 8);
+    psBuf[segAddr * 2 + 1] = (char)(blockD & 0xFF);
+    psMask |= (1 << segAddr);
+
+    /* All segments received -> publish name */
+    if (psMask == 0x0F)
+    {
+        for (U8 i=0; i<RDS_PS_LEN; i++)
+        {
+            psName[i] = psBuf[i];
+        }
+        psName[RDS_PS_LEN] = 0;
+        psMask = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - RadioText: 16 segments with 4 chars (2A) or 2 chars (2B)
+//------------------------------------------------------------------------------
+void objRds::decodeRT(U8 segAddr, bool bVerB, U16 blockC, U16 blockD)
+{
+    U8 segLen = (bVerB) ? 2 : 4;
+    U8 pos = segAddr * segLen;
+
+    if (!bVerB)
+    {
+        setRTChar(pos++, blockC >> 8);
+        setRTChar(pos++, blockC & 0xFF);
+    }
+    setRTChar(pos++, blockD >> 8);
+    setRTChar(pos++, blockD & 0xFF);
+    rtMask |= (1 << segAddr);
+
+    /* Required segments: up to end marker or complete text */
+    U8 maxLen = segLen * 16;
+    if (rtLen > maxLen)
+    {
+        rtLen = maxLen;
+    }
+    U8 segCnt = (rtLen + segLen - 1) / segLen;
+    U16 segNeed = (segCnt >= 16) ? 0xFFFF : ((1 << segCnt) - 1);
+
+    if ((rtMask & segNeed) == segNeed)
+    {
+        U8 len = rtLen;
+        /* Remove trailing spaces */
+        while ((len > 0) && (rtBuf[len - 1] == ' '))
+        {
+            len--;
+        }
+        for (U8 i=0; i<len; i++)
+        {
+            rtText[i] = rtBuf[i];
+        }
+        rtText[len] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Store RadioText char, end marker limits text length
+//------------------------------------------------------------------------------
+void objRds::setRTChar(U8 pos, U8 ch)
+{
+    if (pos >= RDS_RT_LEN)
+        return;
+
+    if (ch == RDS_RT_END)
+    {
+        rtLen = pos;
+        ch = ' ';
+    }
+    rtBuf[pos] = (char)ch;
+}
+
+//------------------------------------------------------------------------------
+// Internal - CT clock time: MJD [17 bit], hour, minute, local offset
+//------------------------------------------------------------------------------
+void objRds::decodeCT(U16 blockB, U16 blockC, U16 blockD)
+{
+    U32 mjd = ((U32)(blockB & 0x03) << 15) | (blockC >> 1);
+    U8 hour = ((blockC & 0x01) << 4) | (blockD >> 12);
+    U8 minute = (blockD >> 6) & 0x3F;
+
+    /* MJD 40587 = 01.01.1970 */
+    if ((hour > 23) || (minute > 59) || (mjd < 40587))
+        return;
+
+    /* Days to civil date (proleptic gregorian calendar) */
+    U32 z = mjd - 40587 + 719468;
+    U32 era = z / 146097;
+    U32 doe = z - era * 146097;
+    U32 yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    U32 doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    U32 mp = (5 * doy + 2) / 153;
+    U8 month = (mp < 10) ? mp + 3 : mp - 9;
+
+    ctTime.year = yoe + era * 400 + ((month <= 2) ? 1 : 0);
+    ctTime.month = month;
+    ctTime.day = doy - (153 * mp + 2) / 5 + 1;
+    ctTime.hour = hour;
+    ctTime.minute = minute;
+    ctTime.offset = blockD & 0x1F;
+    if (blockD & 0x20)
+    {
+        ctTime.offset = -ctTime.offset;
+    }
+    ctValid = true;
+}
+
+//------------------------------------------------------------------------------
+// Internal - Insert AF code into AF list (only FM band, no duplicates)
+//------------------------------------------------------------------------------
+void objRds::addAF(U8 afCode)
+{
+    if ((afCode < RDS_AF_FM_MIN) || (afCode > RDS_AF_FM_MAX))
+        return;
+
+    U16 freq = 8750 + (U16)afCode * 10;
+    for (U8 i=0; i<afCnt; i++)
+    {
+        if (afList[i] == freq)
+            return;
+    }
+    if (afCnt < RDS_AF_MAX)
+    {
+        afList[afCnt++] = freq;
+    }
+}
+
+#endif // CE_OBJ_RDS
+// END OF objRds.cpp
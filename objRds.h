@@ -0,0 +1,136 @@
+//------------------------------------------------------------------------------
+// File...: objRds.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objRds - RDS/RBDS group decoder (PI, PTY, PS, RT, CT, AF)
+//------------------------------------------------------------------------------
+#ifndef _CPP_OBJRDS
+#define _CPP_OBJRDS
+
+//------------------------------------------------------------------------------
+/* RDS group (4 blocks with 16 bit, ~11.4 groups per second):
+ *
+ *   Block A: PI code (program identification)
+ *   Block B: Group type [15:12], Version [11], TP [10], PTY [9:5], Data [4:0]
+ *   Block C: Data (Version B: PI code)
+ *   Block D: Data
+ *
+ * Supported group types:
+ *   0A/0B : PS name (8 chars, 4 segments), AF list (only 0A)
+ *   2A/2B : RadioText (64/32 chars, 16 segments)
+ *   4A    : CT clock time (MJD, UTC hour/minute, local offset)
+ *
+ * Block error level BLERA/BLERB (RDA5807M status register 0x0B):
+ *   0 = no errors; 1 = 1..2 errors; 2 = 3..5 errors; 3 = 6+ (uncorrectable)
+ */
+//------------------------------------------------------------------------------
+
+/* Raw group ring buffer (power of two) */
+#define RDS_RING_LEN       8
+
+/* Max accepted error level for block A and B (see "SetMaxError()") */
+#define RDS_ERR_MAX        1
+
+/* Text and list length */
+#define RDS_PS_LEN         8
+#define RDS_RT_LEN        64
+#define RDS_AF_MAX        12
+
+/* Raw RDS group */
+typedef struct
+{
+    U16 rdsBlock[4];  // Block A, B, C, D
+    U8  rdsErr;       // BLERA [3:2], BLERB [1:0]
+} rdsGroup;
+
+/* CT clock time (UTC) */
+typedef struct
+{
+    U16 year;
+    U8  month;
+    U8  day;
+    U8  hour;
+    U8  minute;
+    S8  offset;       // Local time offset [30 min]
+} rdsTime;
+
+//==============================================================================
+// OBJECT CLASS: objRds - RDS/RBDS group decoder
+//==============================================================================
+class objRds
+{
+    public:
+        /* Class constructor */
+        objRds(void);
+
+        /* Clear all decoded data (e.g. after frequence change) */
+        void Clear(void);
+
+        /* Insert raw group into ring buffer, FALSE if buffer full */
+        bool Push(U16 blockA, U16 blockB, U16 blockC, U16 blockD, U8 blkErr);
+
+        /* Decode max. "maxGroups" from ring buffer, return decoded groups */
+        U8 Decode(U8 maxGroups);
+
+        /* Set max accepted error level for block A and B (0..3) */
+        void SetMaxError(U8 errMax) { rdsErrMax = errMax; }
+
+        /* Get program identification (0 = unknown) */
+        U16 GetPI(void) { return rdsPI; }
+
+        /* Get program type (0..31) */
+        U8 GetPTY(void) { return rdsPTY; }
+
+        /* Get PS name (8 chars + 0), FALSE if not complete */
+        bool GetPS(char *psName);
+
+        /* Get RadioText (max. 64 chars + 0), FALSE if not complete */
+        bool GetRT(char *rtText);
+
+        /* Get clock time, FALSE if not received */
+        bool GetCT(rdsTime *ctTime);
+
+        /* Get AF list (frequence 8760 = 87,6 MHz), return count */
+        U8 GetAF(U16 *afList, U8 afMax);
+
+        /* Statistic: received, rejected (error level) and lost groups */
+        void GetStats(U16 *grpRecv, U16 *grpError, U16 *grpLost);
+
+    private:
+        /* Raw group ring buffer (written by Push, read by Decode) */
+        rdsGroup rdsRing[RDS_RING_LEN];
+        volatile U8 ringHead;
+        volatile U8 ringTail;
+
+        /* Decoded data */
+        U8 rdsErrMax;
+        U16 rdsPI;
+        U8 rdsPTY;
+        char psBuf[RDS_PS_LEN];
+        char psName[RDS_PS_LEN + 1];
+        U8 psMask;
+        char rtBuf[RDS_RT_LEN];
+        char rtText[RDS_RT_LEN + 1];
+        U16 rtMask;
+        U8 rtLen;
+        U8 rtFlag;
+        rdsTime ctTime;
+        bool ctValid;
+        U16 afList[RDS_AF_MAX];
+        U8 afCnt;
+
+        /* Statistic */
+        U16 statRecv;
+        U16 statError;
+        U16 statLost;
+
+        void decodeGroup(rdsGroup *pGroup);
+        void decodePS(U8 segAddr, U16 blockD);
+        void decodeRT(U8 segAddr, bool bVerB, U16 blockC, U16 blockD);
+        void decodeCT(U16 blockB, U16 blockC, U16 blockD);
+        void addAF(U8 afCode);
+        void setRTChar(U8 pos, U8 ch);
+};
+
+#endif // _CPP_OBJRDS
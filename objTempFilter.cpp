@@ -0,0 +1,210 @@
+//------------------------------------------------------------------------------
+// File...: objTempFilter.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objTempFilter - Streaming filter for sensor readings
+//------------------------------------------------------------------------------
+#include "classEnable.h"
+#ifdef CE_OBJ_TEMPFILTER
+#include <Arduino.h>
+#include "objTempFilter.h"
+
+//------------------------------------------------------------------------------
+// Internal defines
+//------------------------------------------------------------------------------
+#if (TEMPF_MEDIAN_N % 2) == 0
+  #error "TEMPF_MEDIAN_N must be odd"
+#endif
+
+/* Bucket length [ms] per window level */
+static const U32 winBucketMs[TEMPF_WIN_CNT] =
+{
+    60000UL / TEMPF_BUCKETS,
+    3600000UL / TEMPF_BUCKETS,
+    86400000UL / TEMPF_BUCKETS
+};
+
+//------------------------------------------------------------------------------
+// Class constructor
+//------------------------------------------------------------------------------
+objTempFilter::objTempFilter(void)
+{
+    Clear();
+}
+
+//------------------------------------------------------------------------------
+// Clear all values
+//------------------------------------------------------------------------------
+void objTempFilter::Clear(void)
+{
+    medIndex = 0;
+    lastMedian = 0;
+    emaAcc = 0;
+    valueCnt = 0;
+    for (U8 w=0; w<TEMPF_WIN_CNT; w++)
+    {
+        for (U8 b=0; b<TEMPF_BUCKETS; b++)
+        {
+            bucketClear(&winBucket[w][b]);
+        }
+        winIndex[w] = 0;
+        winStart[w] = 0;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Insert new reading with time [ms]
+//------------------------------------------------------------------------------
+void objTempFilter::Insert(S16 value, U32 msTime)
+{
+    /* First value fills median and EMA */
+    if (valueCnt == 0)
+    {
+        for (U8 i=0; i<TEMPF_MEDIAN_N; i++)
+        {
+            medRing[i] = value;
+        }
+        emaAcc = (S32)value << TEMPF_EMA_SHIFT;
+        for (U8 w=0; w<TEMPF_WIN_CNT; w++)
+        {
+            winStart[w] = msTime;
+        }
+    }
+    valueCnt++;
+    
+    medRing[medIndex] = value;
+    medIndex = (medIndex + 1) % TEMPF_MEDIAN_N;
+    lastMedian = median();
+    
+    /* acc = acc - acc/2^k + x  ->  acc/2^k = EMA (acc/2^k rounded, a */
+    /* truncated shift would settle one step above negative values) */
+    emaAcc += lastMedian - ((emaAcc + (1 << (TEMPF_EMA_SHIFT - 1))) >> TEMPF_EMA_SHIFT);
+    
+    for (U8 w=0; w<TEMPF_WIN_CNT; w++)
+    {
+        windowAdd(w, lastMedian, msTime);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Exponential moving average of the median values (rounded)
+//------------------------------------------------------------------------------
+S16 objTempFilter::Average(void)
+{
+    return (S16)((emaAcc + (1 << (TEMPF_EMA_SHIFT - 1))) >> TEMPF_EMA_SHIFT);
+}
+
+//------------------------------------------------------------------------------
+// Min/max/mean over window TEMPF_WIN_xxx, FALSE if empty
+//------------------------------------------------------------------------------
+bool objTempFilter::GetWindow(U8 winLevel, tempfWindow *pWindow)
+{
+    if (winLevel >= TEMPF_WIN_CNT)
+    {
+        return false; // ERROR
+    }
+    
+    S32 winSum = 0;
+    U32 winCnt = 0;
+    S16 winMin = 0x7FFF;
+    S16 winMax = -0x7FFF;
+    for (U8 b=0; b<TEMPF_BUCKETS; b++)
+    {
+        tempfBucket *pBucket = &winBucket[winLevel][b];
+        if (pBucket->bCnt == 0)
+            continue;
+        winSum += pBucket->bSum;
+        winCnt += pBucket->bCnt;
+        if (pBucket->bMin < winMin)
+            winMin = pBucket->bMin;
+        if (pBucket->bMax > winMax)
+            winMax = pBucket->bMax;
+    }
+    if (winCnt == 0)
+    {
+        return false; // EMPTY
+    }
+    
+    /* Mean rounded to nearest */
+    S32 winHalf = (winSum >= 0) ? (S32)(winCnt / 2) : -(S32)(winCnt / 2);
+    pWindow->winMin = winMin;
+    pWindow->winMax = winMax;
+    pWindow->winMean = (S16)((winSum + winHalf) / (S32)winCnt);
+    pWindow->winCnt = winCnt;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Internal - Median of the ring (insertion sort of a copy, N is small)
+//------------------------------------------------------------------------------
+S16 objTempFilter::median(void)
+{
+    S16 sorted[TEMPF_MEDIAN_N];
+    for (U8 i=0; i<TEMPF_MEDIAN_N; i++)
+    {
+        S16 value = medRing[i];
+        U8 k = i;
+        while ((k > 0) && (sorted[k - 1] > value))
+        {
+            sorted[k] = sorted[k - 1];
+            k--;
+        }
+        sorted[k] = value;
+    }
+    return sorted[TEMPF_MEDIAN_N / 2];
+}
+
+//------------------------------------------------------------------------------
+// Internal - Move window to the bucket of "msTime" and add value
+//------------------------------------------------------------------------------
+void objTempFilter::windowAdd(U8 winLevel, S16 value, U32 msTime)
+{
+    U32 bucketMs = winBucketMs[winLevel];
+    U32 msDiff = msTime - winStart[winLevel];
+    if (msDiff >= bucketMs)
+    {
+        /* Next bucket(s), a gap longer than the window clears all */
+        U32 steps = msDiff / bucketMs;
+        U8 clearCnt = (steps > TEMPF_BUCKETS) ? TEMPF_BUCKETS : (U8)steps;
+        for (U8 i=0; i<clearCnt; i++)
+        {
+            winIndex[winLevel] = (winIndex[winLevel] + 1) % TEMPF_BUCKETS;
+            bucketClear(&winBucket[winLevel][winIndex[winLevel]]);
+        }
+        winStart[winLevel] += steps * bucketMs;
+    }
+    
+    tempfBucket *pBucket = &winBucket[winLevel][winIndex[winLevel]];
+    if (pBucket->bCnt == 0)
+    {
+        pBucket->bMin = value;
+        pBucket->bMax = value;
+    }
+    else
+    {
+        if (value < pBucket->bMin)
+            pBucket->bMin = value;
+        if (value > pBucket->bMax)
+            pBucket->bMax = value;
+    }
+    if (pBucket->bCnt < 0xFFFF)
+    {
+        pBucket->bSum += value;
+        pBucket->bCnt++;
+    }
+}
+
+//------------------------------------------------------------------------------
+// Internal - Clear bucket
+//------------------------------------------------------------------------------
+void objTempFilter::bucketClear(tempfBucket *pBucket)
+{
+    pBucket->bMin = 0;
+    pBucket->bMax = 0;
+    pBucket->bSum = 0;
+    pBucket->bCnt = 0;
+}
+
+#endif // CE_OBJ_TEMPFILTER
+// END OF objTempFilter.cpp
@@ -0,0 +1,108 @@
+//------------------------------------------------------------------------------
+// File...: objTempFilter.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objTempFilter - Streaming filter for sensor readings
+//------------------------------------------------------------------------------
+#ifndef _CPP_OBJTEMPFILTER
+#define _CPP_OBJTEMPFILTER
+
+//------------------------------------------------------------------------------
+/* One channel (e.g. temperature 0.1°C or humidity 0.1%), fed with every
+ * new reading, integer arithmetic only, fixed memory:
+ *
+ *   Insert() -> median of the last TEMPF_MEDIAN_N values (spike rejection)
+ *            -> EMA (alpha = 1 / 2^TEMPF_EMA_SHIFT)
+ *            -> rolling min/max/mean windows 1 min, 1 h, 24 h
+ *
+ *   objTempFilter tempFilt;
+ *   if (temp.ReadData()) tempFilt.Insert(temp.Temperatur(), millis());
+ *
+ * Window: TEMPF_BUCKETS buckets (min, max, sum, count), a new value only
+ * updates the current bucket (O(1)); a bucket older than the window is
+ * removed when time moves on, the window is exact to one bucket length
+ */
+//------------------------------------------------------------------------------
+
+/* Median length (odd, 1 = off) */
+#define TEMPF_MEDIAN_N        5
+
+/* EMA weight of a new value: 1 / 2^TEMPF_EMA_SHIFT */
+#define TEMPF_EMA_SHIFT       3
+
+/* Buckets per window */
+#define TEMPF_BUCKETS         6
+
+/* Window level */
+#define TEMPF_WIN_MIN         0     //  1 min
+#define TEMPF_WIN_HOUR        1     //  1 h
+#define TEMPF_WIN_DAY         2     // 24 h
+#define TEMPF_WIN_CNT         3
+
+/* Window bucket */
+typedef struct
+{
+    S16 bMin;
+    S16 bMax;
+    S32 bSum;
+    U16 bCnt;
+} tempfBucket;
+
+/* Window result */
+typedef struct
+{
+    S16 winMin;
+    S16 winMax;
+    S16 winMean;
+    U32 winCnt;       // Number of values in window (buckets of U16)
+} tempfWindow;
+
+//==============================================================================
+// OBJECT CLASS: objTempFilter - Streaming filter for sensor readings
+//==============================================================================
+class objTempFilter
+{
+    public:
+        /* Class constructor */
+        objTempFilter(void);
+        
+        /* Clear all values */
+        void Clear(void);
+        
+        /* Insert new reading with time [ms] */
+        void Insert(S16 value, U32 msTime);
+        
+        /* Median of the last values (spike free) */
+        S16 Median(void) { return lastMedian; }
+        
+        /* Exponential moving average of the median values */
+        S16 Average(void);
+        
+        /* Min/max/mean over window TEMPF_WIN_xxx, FALSE if empty */
+        bool GetWindow(U8 winLevel, tempfWindow *pWindow);
+        
+        /* Number of values since "Clear()" */
+        U32 GetCount(void) { return valueCnt; }
+        
+    private:
+        /* Median */
+        S16 medRing[TEMPF_MEDIAN_N];
+        U8 medIndex;
+        S16 lastMedian;
+        
+        /* EMA (value << TEMPF_EMA_SHIFT) */
+        S32 emaAcc;
+        U32 valueCnt;
+        
+        /* Windows */
+        tempfBucket winBucket[TEMPF_WIN_CNT][TEMPF_BUCKETS];
+        U8 winIndex[TEMPF_WIN_CNT];
+        U32 winStart[TEMPF_WIN_CNT];
+        
+        S16 median(void);
+        void windowAdd(U8 winLevel, S16 value, U32 msTime);
+        static void bucketClear(tempfBucket *pBucket);
+};
+
+#endif // _CPP_OBJTEMPFILTER
@@ -20,12 +20,72 @@
 #define TEMP_REG_TEMP_L      3
 #define TEMP_REG_CHECKSUM    4
 
+/* Sampler state */
+#define TEMP_ST_IDLE         0
+#define TEMP_ST_CONV         1
+
+/* Saturation vapour pressure over water [0.1 Pa], Magnus
+ * es = 611.2 Pa * exp(17.62 * T / (243.12°C + T)), -40..80°C in 2°C steps
+ */
+#define TEMP_ES_MIN       (-400)
+#define TEMP_ES_MAX        800
+#define TEMP_ES_STEP        20
+#define TEMP_ES_CNT         61
+
+static const U32 tempEsTable[TEMP_ES_CNT] PROGMEM =
+{
+       190UL,    234UL,    286UL,    348UL,    423UL,    512UL,    617UL,    741UL,
+       887UL,   1059UL,   1260UL,   1494UL,   1766UL,   2083UL,   2448UL,   2870UL,
+      3356UL,   3913UL,   4552UL,   5281UL,   6112UL,   7057UL,   8129UL,   9343UL,
+     10714UL,  12260UL,  14000UL,  15953UL,  18142UL,  20591UL,  23326UL,  26374UL,
+     29766UL,  33533UL,  37711UL,  42337UL,  47450UL,  53094UL,  59313UL,  66156UL,
+     73675UL,  81924UL,  90963UL, 100852UL, 111659UL, 123452UL, 136304UL, 150294UL,
+    165504UL, 182020UL, 199933UL, 219338UL, 240337UL, 263035UL, 287543UL, 313977UL,
+    342458UL, 373114UL, 406077UL, 441487UL, 479489UL
+};
+
+/* Heat index [0.1°C], NWS Rothfusz regression, 26..50°C x 40..100% */
+#define TEMP_HI_T_MIN      260
+#define TEMP_HI_T_MAX      500
+#define TEMP_HI_T_STEP      20
+#define TEMP_HI_T_CNT       13
+#define TEMP_HI_H_MIN      400
+#define TEMP_HI_H_STEP      50
+#define TEMP_HI_H_CNT       13
+
+static const S16 tempHiTable[TEMP_HI_H_CNT][TEMP_HI_T_CNT] PROGMEM =
+{
+    {  262,  277,  297,  323,  354,  391,  434,  483,  537,  596,  662,  733,  809 },   // 40%
+    {  264,  280,  303,  332,  368,  410,  459,  513,  575,  642,  716,  797,  884 },   // 45%
+    {  266,  284,  310,  344,  384,  431,  486,  548,  617,  693,  776,  866,  964 },   // 50%
+    {  267,  289,  319,  356,  402,  455,  516,  585,  662,  747,  840,  940, 1049 },   // 55%
+    {  269,  294,  328,  371,  422,  481,  550,  626,  712,  806,  909, 1020, 1140 },   // 60%
+    {  271,  300,  339,  387,  444,  510,  586,  671,  765,  869,  982, 1104, 1236 },   // 65%
+    {  273,  307,  350,  404,  468,  542,  625,  719,  823,  936, 1060, 1194, 1337 },   // 70%
+    {  275,  314,  363,  423,  494,  575,  667,  770,  884, 1008, 1143, 1288, 1444 },   // 75%
+    {  277,  321,  377,  444,  522,  612,  713,  825,  949, 1084, 1230, 1388, 1557 },   // 80%
+    {  279,  329,  391,  466,  552,  651,  761,  883, 1018, 1164, 1322, 1493, 1675 },   // 85%
+    {  280,  337,  407,  490,  584,  692,  812,  945, 1090, 1249, 1419, 1602, 1798 },   // 90%
+    {  282,  347,  424,  515,  619,  736,  866, 1010, 1167, 1337, 1521, 1717, 1927 },   // 95%
+    {  284,  356,  442,  542,  655,  782,  924, 1079, 1248, 1430, 1627, 1837, 2062 }    // 100%
+};
+
 //------------------------------------------------------------------------------        
 // Class constructor 
 //------------------------------------------------------------------------------        
 objTempera::objTempera(void)
 {     
+    pBus = iccWire::Default();
     tempAddr = TEMP_I2C_ADDR;
+    memset(&tempValue, 0, sizeof(tempValue));
+    tempTime = 0;
+    bValid = false;
+    bNew = false;
+    bSampler = false;
+    tempState = TEMP_ST_IDLE;
+    tempPeriod = TEMP_PERIOD_DEF;
+    tempTrigger = 0;
+    statError = 0;
 }
 
 //------------------------------------------------------------------------------        
@@ -38,10 +98,9 @@ bool objTempera::Init(U8 bTempAddr)
         tempAddr = bTempAddr;
     }  
 #ifdef TEMP_OPEN_WIRE 
-    Wire.begin();
+    pBus->Begin();
 #endif 
-    Wire.beginTransmission(tempAddr);
-    if (Wire.endTransmission() != 0) 
+    if (pBus->Write(tempAddr, NULL, 0) != 0) 
     {
         return false; // ERROR 
     }     
@@ -49,82 +108,432 @@ bool objTempera::Init(U8 bTempAddr)
 }
 
 //------------------------------------------------------------------------------        
-// Read temperatur and humidity data from i2c bus
+// Service function: trigger or collect, TRUE if the bus was used
 //------------------------------------------------------------------------------        
-bool objTempera::ReadData(void)
-{    
-    Wire.beginTransmission(tempAddr);
-    Wire.write(0);
-    Wire.endTransmission();
-    delay(50);
-    Wire.requestFrom((int)tempAddr, (int)TEMP_TXBUF_SIZE);
-    for (U8 i=0; i<TEMP_TXBUF_SIZE; i++)
-    {
-        tempBuffer[i] = Wire.read();
-    };
-    delay(100);    
-    Wire.endTransmission();
+bool objTempera::Tick(void)
+{
+    U32 msNow = millis();
+    bSampler = true;
+    if (tempState == TEMP_ST_IDLE)
+    {
+        /* First sample at once, then every "tempPeriod" */
+        if ((tempTrigger != 0) && ((U32)(msNow - tempTrigger) < tempPeriod))
+            return false;
+        
+        tempTrigger = (msNow == 0) ? 1 : msNow;
+        if (Trigger())
+        {
+            tempState = TEMP_ST_CONV;
+        }
+        return true;
+    }
     
+    /* Collect after conversion time */
+    if ((U32)(msNow - tempTrigger) < TEMP_CONV_MS)
+        return false;
+    tempState = TEMP_ST_IDLE;
+    Collect();
+    return true;
+}
+
+//------------------------------------------------------------------------------        
+// Start conversion (register pointer), FALSE on bus error
+//------------------------------------------------------------------------------        
+bool objTempera::Trigger(void)
+{
+    bSampler = true;
+    U8 regAddr = TEMP_REG_HUMI_H;
+    if (pBus->Write(tempAddr, &regAddr, 1) != 0)
+    {
+        statError++;
+        return false; // ERROR
+    }
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------        
+// Read result and check checksum, FALSE on error
+//------------------------------------------------------------------------------        
+bool objTempera::Collect(void)
+{
+    U8 rxBuffer[TEMP_TXBUF_SIZE];
+    U8 rxLen = pBus->Read(tempAddr, rxBuffer, TEMP_TXBUF_SIZE);
+    
+#ifdef TEMP_DEBUG
     Serial.print("Buffer: ");
-    for (U8 i=0; i<TEMP_TXBUF_SIZE; i++)
+    for (U8 i=0; i<rxLen; i++)
     {        
-        Serial.print(tempBuffer[i], DEC);
+        Serial.print(rxBuffer[i], DEC);
         Serial.print(", ");
     }     
     Serial.println(" ");
-        
-    if (tempBuffer[TEMP_REG_CHECKSUM] == checkSum()) 
+#endif
+    
+    tempReading rxValue;
+    if ((rxLen != TEMP_TXBUF_SIZE) || 
+        (rxBuffer[TEMP_REG_CHECKSUM] != checkSum(rxBuffer)) ||
+        !Decode(rxBuffer, &rxValue))
     {
+        statError++; // CKSUM ERROR
+        return false;
+    }
+    tempValue = rxValue;
+    tempTime = millis();
+    bValid = true;
+    bNew = true;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------        
+// TRUE once after a new valid reading (no bus access)
+// Without "Tick()" or group: blocking read as before, TRUE if OK
+//------------------------------------------------------------------------------        
+bool objTempera::ReadData(void)
+{    
+    if (!bSampler)
+    {
+        bool bOk = Trigger();
+        if (bOk)
+        {
+            delay(TEMP_CONV_MS);
+            bOk = Collect();
+        }
+        bSampler = false;
+        bNew = false;
+        return bOk;
+    }
+    if (bNew)
+    {
+        bNew = false;
         return true; // OK
     }       
-    return false;// CKSUM ERROR
+    return false; // NO NEW DATA
 }
 
 //------------------------------------------------------------------------------
-// Get temperatur from buffer <-1000..+1000> [215 = 21,5°C] 
+// Decode 5 received bytes, FALSE if invalid
 //------------------------------------------------------------------------------
 // Temperature:00011010 (Binary) => 26 (Decimal)00000110(Binary) => 6 (Decimal)
-// =>Temperature = 26.6 degrees
+// =>Temperature = 26.6 degrees, bit 7 of the decimal byte = negative
+// Humidity:00111000 (Binary) => 56 (Decimal)00001000(Binary) => 8 (Decimal)
+// =>Humidity = 56.8 % RH
 //------------------------------------------------------------------------------
-S16 objTempera::Temperatur(void)
+bool objTempera::Decode(const U8 *pBuffer, tempReading *pValue)
 {
-    S16 temp = 0;
-    U8 sign = tempBuffer[TEMP_REG_TEMP_L] & 0x80;
-    temp += (S16)tempBuffer[TEMP_REG_TEMP_H] * 10;
-    temp += (S16)tempBuffer[TEMP_REG_TEMP_L] & 0x0F;
-    if (sign)
+    U8 tempFrac = pBuffer[TEMP_REG_TEMP_L] & 0x7F;
+    U8 humiFrac = pBuffer[TEMP_REG_HUMI_L];
+    if ((tempFrac > 9) || (humiFrac > 9))
+    {
+        return false; // ERROR
+    }
+    
+    /* Sign applies to integer and decimal part: (x ^ -1) + 1 = -x */
+    S16 sign = -(S16)(pBuffer[TEMP_REG_TEMP_L] >> 7);
+    S16 temp = ((S16)pBuffer[TEMP_REG_TEMP_H] * 10) + tempFrac;
+    pValue->temp = (temp ^ sign) - sign;
+    pValue->humi = ((U16)pBuffer[TEMP_REG_HUMI_H] * 10) + humiFrac;
+    
+    /* Derived values with temperature and humidity in table range */
+    S16 tc = pValue->temp;
+    if (tc < TEMP_ES_MIN) tc = TEMP_ES_MIN;
+    if (tc > TEMP_ES_MAX) tc = TEMP_ES_MAX;
+    U16 rh = (pValue->humi > 1000) ? 1000 : pValue->humi;
+    
+    /* Vapour pressure [0.1 Pa] */
+    U32 vapour = (satPressure(tc) * rh) / 1000;
+    pValue->dewPoint = dewPoint(vapour);
+    
+    /* Absolute humidity = e * Mw / (R * T) = 2.1667 g*K/J * e / T */
+    pValue->absHumi = (U16)((vapour * 2167UL) / ((U32)(tc + 2732) * 10));
+    
+    if ((pValue->temp < TEMP_HI_T_MIN) || (pValue->temp > TEMP_HI_T_MAX) || 
+        (rh < TEMP_HI_H_MIN))
+    {
+        pValue->heatIndex = pValue->temp;
+    }
+    else
     {
-        temp = -temp;
+        pValue->heatIndex = heatIndex(tc, rh);
     }
-    return temp;
+    return true; // OK
 }
 
 //------------------------------------------------------------------------------        
-// Get humidity from buffer <0..1000> [908 = 90,8%]
+// PRIVATE: Saturation vapour pressure [0.1 Pa], "temp" in table range
 //------------------------------------------------------------------------------        
-// Humidity:00111000 (Binary) => 56 (Decimal)00001000(Binary) => 8 (Decimal)
-// =>Humidity = 56.8 % RH
+U32 objTempera::satPressure(S16 temp)
+{
+    U16 pos = (U16)(temp - TEMP_ES_MIN);
+    U8 idx = pos / TEMP_ES_STEP;
+    U8 frac = pos % TEMP_ES_STEP;
+    U32 esLo = pgm_read_dword(&tempEsTable[idx]);
+    if (frac == 0)
+    {
+        return esLo;
+    }
+    U32 esHi = pgm_read_dword(&tempEsTable[idx + 1]);
+    return esLo + (((esHi - esLo) * frac) + (TEMP_ES_STEP / 2)) / TEMP_ES_STEP;
+}
+
+//------------------------------------------------------------------------------        
+// PRIVATE: Dew point [0.1°C] of vapour pressure (inverse table lookup)
+//------------------------------------------------------------------------------        
+S16 objTempera::dewPoint(U32 vapour)
+{
+    if (vapour <= pgm_read_dword(&tempEsTable[0]))
+    {
+        return TEMP_ES_MIN;
+    }
+    
+    /* Last entry <= vapour */
+    U8 lo = 0;
+    U8 hi = TEMP_ES_CNT - 1;
+    while (lo < hi)
+    {
+        U8 mid = (lo + hi + 1) / 2;
+        if (pgm_read_dword(&tempEsTable[mid]) <= vapour)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    if (lo >= (TEMP_ES_CNT - 1))
+    {
+        return TEMP_ES_MAX;
+    }
+    
+    U32 esLo = pgm_read_dword(&tempEsTable[lo]);
+    U32 esDiff = pgm_read_dword(&tempEsTable[lo + 1]) - esLo;
+    U16 frac = (U16)((((vapour - esLo) * TEMP_ES_STEP) + (esDiff / 2)) / esDiff);
+    return TEMP_ES_MIN + ((S16)lo * TEMP_ES_STEP) + (S16)frac;
+}
+
+//------------------------------------------------------------------------------        
+// PRIVATE: Heat index [0.1°C] (bilinear table interpolation)
 //------------------------------------------------------------------------------        
-U16 objTempera::Humidity(void)
+S16 objTempera::heatIndex(S16 temp, U16 humi)
 {
-    U16 humi = 0;
-    humi += (U16)tempBuffer[TEMP_REG_HUMI_H] * 10;
-    humi += (U16)tempBuffer[TEMP_REG_HUMI_L];
-    return humi;
+    if (temp > TEMP_HI_T_MAX) temp = TEMP_HI_T_MAX;
+    
+    U16 tPos = (U16)(temp - TEMP_HI_T_MIN);
+    U8 ti = tPos / TEMP_HI_T_STEP;
+    U8 tf = tPos % TEMP_HI_T_STEP;
+    if (ti >= (TEMP_HI_T_CNT - 1))
+    {
+        ti = TEMP_HI_T_CNT - 2;
+        tf = TEMP_HI_T_STEP;
+    }
+    
+    U16 hPos = humi - TEMP_HI_H_MIN;
+    U8 hi = hPos / TEMP_HI_H_STEP;
+    U8 hf = hPos % TEMP_HI_H_STEP;
+    if (hi >= (TEMP_HI_H_CNT - 1))
+    {
+        hi = TEMP_HI_H_CNT - 2;
+        hf = TEMP_HI_H_STEP;
+    }
+    
+    S32 v00 = (S16)pgm_read_word(&tempHiTable[hi][ti]);
+    S32 v01 = (S16)pgm_read_word(&tempHiTable[hi][ti + 1]);
+    S32 v10 = (S16)pgm_read_word(&tempHiTable[hi + 1][ti]);
+    S32 v11 = (S16)pgm_read_word(&tempHiTable[hi + 1][ti + 1]);
+    S32 row0 = (v00 * (TEMP_HI_T_STEP - tf)) + (v01 * tf);
+    S32 row1 = (v10 * (TEMP_HI_T_STEP - tf)) + (v11 * tf);
+    S32 div = (S32)TEMP_HI_T_STEP * TEMP_HI_H_STEP;
+    return (S16)(((row0 * (TEMP_HI_H_STEP - hf)) + (row1 * hf) + (div / 2)) / div);
 }
 
 //------------------------------------------------------------------------------        
 // PRIVATE: Calculate checksum
 //------------------------------------------------------------------------------        
-U8 objTempera::checkSum()
+U8 objTempera::checkSum(const U8 *pBuffer)
 {
     U8 ckSum = 0;
     for (U8 i=0; i<TEMP_REG_CHECKSUM; i++)
     {
-        ckSum += (U8)tempBuffer[i];
+        ckSum += pBuffer[i];
     }        
     return ckSum;
 }
 
+//==============================================================================
+// OBJECT CLASS: objTempGroup - Pipelined polling of several objTempera
+//==============================================================================
+#if TEMPG_SENSOR_MAX > 8
+  #error "TEMPG_SENSOR_MAX max. 8 (trigMask, pendMask)"
+#endif
+
+//------------------------------------------------------------------------------        
+// Class constructor 
+//------------------------------------------------------------------------------        
+objTempGroup::objTempGroup(void)
+{
+    sensorCnt = 0;
+    for (U8 i=0; i<TEMPG_SENSOR_MAX; i++)
+    {
+        pSensor[i] = NULL;
+        failCnt[i] = 0;
+        skipCnt[i] = 0;
+        convStart[i] = 0;
+    }
+    trigMask = 0;
+    pendMask = 0;
+    grpState = TEMP_ST_IDLE;
+    grpPeriod = TEMP_PERIOD_DEF;
+    grpTrigger = 0;
+    bRound = false;
+}
+
+//------------------------------------------------------------------------------        
+// Insert sensor, FALSE if full
+//------------------------------------------------------------------------------        
+bool objTempGroup::Insert(objTempera *pSensor)
+{
+    if ((pSensor == NULL) || (sensorCnt >= TEMPG_SENSOR_MAX))
+    {
+        return false; // ERROR
+    }
+    this->pSensor[sensorCnt++] = pSensor;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------        
+// Service function: trigger or collect one sensor, TRUE if a bus was used
+//------------------------------------------------------------------------------        
+bool objTempGroup::Tick(void)
+{
+    U32 msNow = millis();
+    if (grpState == TEMP_ST_IDLE)
+    {
+        /* First round at once, then every "grpPeriod" */
+        if ((sensorCnt == 0) ||
+            ((grpTrigger != 0) && ((U32)(msNow - grpTrigger) < grpPeriod)))
+            return false;
+        
+        grpTrigger = (msNow == 0) ? 1 : msNow;
+        trigMask = 0;
+        for (U8 i=0; i<sensorCnt; i++)
+        {
+            if (skipCnt[i] > 0)
+            {
+                skipCnt[i]--;   // Backoff
+                continue;
+            }
+            trigMask |= (U8)(1 << i);
+        }
+        if (trigMask == 0)
+        {
+            bRound = true;
+            return false;
+        }
+        grpState = TEMP_ST_CONV;
+    }
+    
+    /* Triggers first (same sensor as "GetBus()"), then collect in order */
+    U8 i = nextSensor();
+    U8 bit = (U8)(1 << i);
+    if (trigMask & bit)
+    {
+        trigMask &= (U8)~bit;
+        if (pSensor[i]->Trigger())
+        {
+            pendMask |= bit;
+            convStart[i] = (U16)millis();
+        }
+        else
+        {
+            sensorFail(i);
+        }
+    }
+    else
+    {
+        if ((U16)((U16)msNow - convStart[i]) < TEMP_CONV_MS)
+            return false;
+        
+        pendMask &= (U8)~bit;
+        if (pSensor[i]->Collect())
+        {
+            failCnt[i] = 0;
+        }
+        else
+        {
+            sensorFail(i);
+        }
+    }
+    
+    if ((trigMask | pendMask) == 0)
+    {
+        grpState = TEMP_ST_IDLE;
+        bRound = true;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------        
+// TRUE once after a completed round
+//------------------------------------------------------------------------------        
+bool objTempGroup::RoundDone(void)
+{
+    if (bRound)
+    {
+        bRound = false;
+        return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------        
+// TRUE if no reading or older than TEMPG_STALE_CNT periods
+//------------------------------------------------------------------------------        
+bool objTempGroup::Stale(U8 sensorIdx)
+{
+    if (sensorIdx >= sensorCnt)
+    {
+        return true;
+    }
+    objTempera *pTemp = pSensor[sensorIdx];
+    return (!pTemp->Valid() || (pTemp->GetAge() > ((U32)grpPeriod * TEMPG_STALE_CNT)));
+}
+
+//------------------------------------------------------------------------------        
+// PRIVATE: Sensor of the next transaction (pending trigger, else oldest
+// conversion, idle: first sensor of the next round)
+//------------------------------------------------------------------------------        
+U8 objTempGroup::nextSensor(void)
+{
+    U8 mask = (trigMask != 0) ? trigMask : pendMask;
+    if (grpState == TEMP_ST_IDLE)
+    {
+        mask = 0;
+        for (U8 i=0; i<sensorCnt; i++)
+        {
+            if (skipCnt[i] == 0)
+                mask |= (U8)(1 << i);
+        }
+    }
+    for (U8 i=0; i<sensorCnt; i++)
+    {
+        if (mask & (1 << i))
+            return i;
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------        
+// PRIVATE: Failure n -> skip 2^n-1 periods (exponential backoff)
+//------------------------------------------------------------------------------        
+void objTempGroup::sensorFail(U8 sensorIdx)
+{
+    if (failCnt[sensorIdx] < 0xFF)
+    {
+        failCnt[sensorIdx]++;
+    }
+    U8 shift = failCnt[sensorIdx];
+    if (shift > TEMPG_BACKOFF_MAX)
+    {
+        shift = TEMPG_BACKOFF_MAX;
+    }
+    skipCnt[sensorIdx] = (U8)((1 << shift) - 1);
+}
+
 #endif // CE_OBJ_TEMPERA
 // END OF objTemperacpp                 
@@ -33,10 +33,39 @@
 /* Initialize constructor with "Wire.begin();" */
 #define TEMP_OPEN_WIRE
 
+/* I2C bus interface */
+#include "defIccBus.h"
+
 /* DHT12 I2C Address */
 #define TEMP_I2C_ADDR      0x5C
 #define TEMP_TXBUF_SIZE       5
 
+/* Split-phase sampling in "Tick()" (one bus transaction per call):
+ *   trigger (register pointer) -> TEMP_CONV_MS -> collect 5 bytes
+ *   -> checksum -> cached reading with timestamp
+ * Sample period [ms], the DHT12 needs min. 2 s between measurements
+ */
+#define TEMP_PERIOD_MIN    2000
+#define TEMP_PERIOD_DEF    5000
+#define TEMP_CONV_MS         50
+
+/* Serial output of received bytes */
+//#define TEMP_DEBUG
+
+/* Reading, decoded once per valid sample (integer math, lookup tables):
+ *   dew point and absolute humidity from saturation vapour pressure
+ *   (Magnus, -40..80°C), heat index NWS (Rothfusz) 26..50°C / 40..100%,
+ *   outside of this range heat index = temperature
+ */
+typedef struct
+{
+    S16 temp;         // 0.1°C      [215 = 21,5°C]
+    U16 humi;         // 0.1%       [908 = 90,8%]
+    S16 dewPoint;     // 0.1°C      <-400..+800>
+    U16 absHumi;      // 0.01 g/m³  [1025 = 10,25 g/m³]
+    S16 heatIndex;    // 0.1°C
+} tempReading;
+
 //==============================================================================
 // OBJECT CLASS: objTempera - Get temperatur and Humidity with DHT12
 //==============================================================================
@@ -48,21 +77,143 @@ class objTempera
         
         /* Initialize I2C port */
         bool Init(U8 bTempCAddr);
+        
+        /* Use other I2C bus (default: shared iccWire on "Wire"), call before Init */
+        void SetBus(iccBus *pIccBus) { pBus = pIccBus; }
                
-        /* Read temperatur and humidity data from i2c bus */
+        /* Bus of the sensor (objIccBus) */
+        iccBus *GetBus(void) { return pBus; }
+        
+        /* Sample period [ms] (min. TEMP_PERIOD_MIN) */
+        void SetPeriod(U16 msPeriod) { tempPeriod = (msPeriod < TEMP_PERIOD_MIN) ? TEMP_PERIOD_MIN : msPeriod; }
+        
+        /* Service function: trigger or collect, TRUE if the bus was used */
+        bool Tick(void);
+        
+        /* Manual/group sampling: start conversion, FALSE on bus error */
+        bool Trigger(void);
+        
+        /* Read result (TEMP_CONV_MS after "Trigger()"), FALSE on error */
+        bool Collect(void);
+               
+        /* TRUE once after a new valid reading (no bus access), */
+        /* "Tick()" never called and no group: blocking read (TEMP_CONV_MS), */
+        /* TRUE if OK */
         bool ReadData(void);
         
-        /* Get temperatur from buffer <-1000..+1000> [215 = 21,5°C] */
-        S16 Temperatur(void);
+        /* TRUE if a valid reading is cached */
+        bool Valid(void) { return bValid; }
+        
+        /* Age of the cached reading [ms] */
+        U32 GetAge(void) { return (millis() - tempTime); }
+        
+        /* Bus and checksum errors */
+        U16 GetErrors(void) { return statError; }
+        
+        /* Get temperatur <-1000..+1000> [215 = 21,5°C] */
+        S16 Temperatur(void) { return tempValue.temp; }
                 
-        /* Get humidity from buffer <0..1000> [908 = 90,8%] */
-        U16 Humidity(void);
+        /* Get humidity <0..1000> [908 = 90,8%] */
+        U16 Humidity(void) { return tempValue.humi; }
+        
+        /* Last valid reading with derived values */
+        const tempReading *GetReading(void) { return &tempValue; }
+        
+        /* Decode 5 received bytes, FALSE if invalid (checksum not checked) */
+        static bool Decode(const U8 *pBuffer, tempReading *pValue);
         
     private:                
+        iccBus *pBus;
         U8 tempAddr;                
-        U8 tempBuffer[TEMP_TXBUF_SIZE];                
-        U8 checkSum();
+        tempReading tempValue;              // Last valid reading
+        U32 tempTime;
+        bool bValid;
+        bool bNew;
+        bool bSampler;                      // "Tick()" or group sampling
+        
+        /* Sampler */
+        U8 tempState;
+        U16 tempPeriod;
+        U32 tempTrigger;
+        U16 statError;
+        
+        static U8 checkSum(const U8 *pBuffer);
+        static U32 satPressure(S16 temp);
+        static S16 dewPoint(U32 vapour);
+        static S16 heatIndex(S16 temp, U16 humi);
 };            
 
+//------------------------------------------------------------------------------
+/* Sensor group: one sensor per "Tick()" (max. one bus transaction), the
+ * sensors of a round are triggered one after another and each one is collected
+ * TEMP_CONV_MS after its own trigger -> conversions overlap, no bus blocked.
+ * Sensors may use different addresses and buses ("SetBus()"), do not call
+ * "Tick()" of a grouped sensor and do not insert it into objIccBus.
+ *   group.Insert(&sensor1);         // sensor1.Init(0x5C)
+ *   group.Insert(&sensor2);         // sensor2.SetBus(&muxChannel2)
+ *   loop() { group.Tick(); }
+ * objIccBus: insert the group (not its sensors), "GetBus()" is the bus of the
+ * sensor served by the next "Tick()".
+ * A failing sensor is skipped for 1, 3, 7.. periods (max. 2^TEMPG_BACKOFF_MAX-1),
+ * a reading older than TEMPG_STALE_CNT periods is stale.
+ */
+#define TEMPG_SENSOR_MAX      8
+#define TEMPG_BACKOFF_MAX     5
+#define TEMPG_STALE_CNT       3
+
+//==============================================================================
+// OBJECT CLASS: objTempGroup - Pipelined polling of several objTempera
+//==============================================================================
+class objTempGroup
+{
+    public:
+        /* Class constructor */
+        objTempGroup(void);
+        
+        /* Insert sensor, FALSE if full */
+        bool Insert(objTempera *pSensor);
+        
+        /* Sample period [ms] (min. TEMP_PERIOD_MIN) */
+        void SetPeriod(U16 msPeriod) { grpPeriod = (msPeriod < TEMP_PERIOD_MIN) ? TEMP_PERIOD_MIN : msPeriod; }
+        
+        /* Service function: trigger or collect one sensor, TRUE if a bus was used */
+        bool Tick(void);
+        
+        /* TRUE once after a completed round */
+        bool RoundDone(void);
+        
+        /* Bus of the next "Tick()" (objIccBus), NULL if empty */
+        iccBus *GetBus(void) { return (sensorCnt > 0) ? pSensor[nextSensor()]->GetBus() : NULL; }
+        
+        /* Number of sensors */
+        U8 GetCount(void) { return sensorCnt; }
+        
+        /* Sensor "sensorIdx" (order of "Insert()"), NULL if invalid */
+        objTempera *GetSensor(U8 sensorIdx) { return (sensorIdx < sensorCnt) ? pSensor[sensorIdx] : NULL; }
+        
+        /* TRUE if no reading or older than TEMPG_STALE_CNT periods */
+        bool Stale(U8 sensorIdx);
+        
+        /* Consecutive failures of sensor (0 = OK) */
+        U8 GetFailures(U8 sensorIdx) { return (sensorIdx < sensorCnt) ? failCnt[sensorIdx] : 0; }
+        
+    private:
+        objTempera *pSensor[TEMPG_SENSOR_MAX];
+        U8 sensorCnt;
+        U8 failCnt[TEMPG_SENSOR_MAX];
+        U8 skipCnt[TEMPG_SENSOR_MAX];
+        U16 convStart[TEMPG_SENSOR_MAX];    // Trigger time [ms, low word]
+        U8 trigMask;                        // Sensors to trigger in this round
+        U8 pendMask;                        // Triggered sensors (bit per index)
+        
+        U8 grpState;
+        U16 grpPeriod;
+        U32 grpTrigger;
+        bool bRound;
+        
+        U8 nextSensor(void);
+        void sensorFail(U8 sensorIdx);
+};
+
 #endif // _CPP_OBJTEMPERA
 
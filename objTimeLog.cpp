@@ -0,0 +1,510 @@
+//------------------------------------------------------------------------------
+// File...: objTimeLog.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objTimeLog - Compact circular log for temperature/humidity
+//------------------------------------------------------------------------------
+#include "classEnable.h"
+#ifdef CE_OBJ_TIMELOG
+#include <Arduino.h>
+#include "objTimeLog.h"
+
+//------------------------------------------------------------------------------
+// Internal defines
+//------------------------------------------------------------------------------
+#define TLOG_SEQ_EMPTY   0xFF
+#define TLOG_SEQ_WRAP    0xFF
+#define TLOG_REC_LONG    0xC0
+#define TLOG_REC_RUN     0x80
+#define TLOG_RUN_MAX     64
+
+#define TLOG_SHORT_T_MIN (-8)
+#define TLOG_SHORT_T_MAX 7
+#define TLOG_SHORT_H_MIN (-4)
+#define TLOG_SHORT_H_MAX 3
+
+//------------------------------------------------------------------------------
+// Class constructor
+//------------------------------------------------------------------------------
+objTimeLog::objTimeLog(void)
+{
+    pStore = NULL;
+    pageSize = 0;
+    pageCnt = 0;
+    logPeriod = 0;
+    bEmpty = true;
+    headPage = 0;
+    headOffset = 0;
+    headSeq = 0;
+    memset(&last, 0, sizeof(last));
+    runCnt = 0;
+    statSamples = 0;
+    statBytes = 0;
+}
+
+//------------------------------------------------------------------------------
+// Open log, search newest page and end of records
+//------------------------------------------------------------------------------
+bool objTimeLog::Begin(tlogStore *pStore, U16 secPeriod)
+{
+    this->pStore = pStore;
+    pageSize = pStore->PageSize();
+    pageCnt = pStore->PageCount();
+    logPeriod = secPeriod;
+    bEmpty = true;
+    runCnt = 0;
+    statSamples = 0;
+    statBytes = 0;
+    
+    if ((pageCnt < 2) || (pageCnt >= TLOG_SEQ_WRAP) ||
+        (pageSize < TLOG_PAGE_MIN) || (pageSize > TLOG_PAGE_MAX))
+    {
+        this->pStore = NULL;
+        return false; // ERROR
+    }
+    
+    /* Newest page: followed by an erased page or a sequence gap */
+    for (U16 p=0; p<pageCnt; p++)
+    {
+        U8 seq = pageSeq(p);
+        if (seq == TLOG_SEQ_EMPTY)
+        {
+            continue;
+        }
+        
+        U8 nextSeq = pageSeq((p + 1) % pageCnt);
+        if (nextSeq != (U8)((seq + 1) % TLOG_SEQ_WRAP))
+        {
+            headPage = p;
+            headSeq = seq;
+            bEmpty = false;
+            break;
+        }
+    }
+    
+    if (bEmpty)
+    {
+        return true; // OK (empty log)
+    }
+    
+    /* Decode newest page to end of records */
+    tlogReader rd;
+    readStart(&rd, headPage);
+    last = rd.cur;
+    while (readNext(&rd))
+    {
+        last = rd.cur;
+    }
+    headOffset = rd.offset;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Erase all pages
+//------------------------------------------------------------------------------
+void objTimeLog::Clear(void)
+{
+    if (pStore == NULL)
+    {
+        return;
+    }
+    
+    for (U16 p=0; p<pageCnt; p++)
+    {
+        if (pageSeq(p) != TLOG_SEQ_EMPTY)
+        {
+            pStore->Erase(p);
+        }
+    }
+    bEmpty = true;
+    runCnt = 0;
+}
+
+//------------------------------------------------------------------------------
+// Append sample
+//------------------------------------------------------------------------------
+bool objTimeLog::Append(U32 secTime, S16 temp, U16 humi)
+{
+    if (pStore == NULL)
+    {
+        return false; // ERROR
+    }
+    
+    tlogSample smp;
+    smp.secTime = secTime;
+    smp.temp = temp;
+    smp.humi = humi;
+    
+    if (bEmpty)
+    {
+        headPage = pageCnt - 1;
+        headSeq = TLOG_SEQ_WRAP - 1;
+        pageStart(&smp);
+        statSamples++;
+        return true; // OK
+    }
+    
+    if (secTime < last.secTime)
+    {
+        return false; // ERROR
+    }
+    
+    U32 dt = secTime - last.secTime;
+    S32 dTemp = (S32)temp - last.temp;
+    S32 dHumi = (S32)humi - last.humi;
+    
+    /* Unchanged: count in RAM only */
+    if ((dt == logPeriod) && (dTemp == 0) && (dHumi == 0))
+    {
+        last.secTime = secTime;
+        runCnt++;
+        if (runCnt >= TLOG_RUN_MAX)
+        {
+            runWrite();
+        }
+        statSamples++;
+        return true; // OK
+    }
+    
+    runWrite();
+    
+    U8 rec[TLOG_REC_MAX];
+    U8 recLen;
+    if ((dt == logPeriod) &&
+        (dTemp >= TLOG_SHORT_T_MIN) && (dTemp <= TLOG_SHORT_T_MAX) &&
+        (dHumi >= TLOG_SHORT_H_MIN) && (dHumi <= TLOG_SHORT_H_MAX))
+    {
+        rec[0] = (U8)(((dTemp - TLOG_SHORT_T_MIN) << 3) | (dHumi - TLOG_SHORT_H_MIN));
+        recLen = 1;
+    }
+    else
+    {
+        rec[0] = TLOG_REC_LONG;
+        recLen = 1;
+        recLen += putVarint(&rec[recLen], dt);
+        recLen += putVarint(&rec[recLen], zigzag(dTemp));
+        recLen += putVarint(&rec[recLen], zigzag(dHumi));
+    }
+    
+    if (!recordWrite(rec, recLen))
+    {
+        pageStart(&smp);
+    }
+    last = smp;
+    statSamples++;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Write pending unchanged samples
+//------------------------------------------------------------------------------
+void objTimeLog::Flush(void)
+{
+    if (pStore != NULL)
+    {
+        runWrite();
+    }
+}
+
+//------------------------------------------------------------------------------
+// Get samples of time range, oldest first
+//------------------------------------------------------------------------------
+U16 objTimeLog::Query(U32 secFrom, U32 secTo, tlogSample *pOut, U16 maxCnt)
+{
+    if ((pStore == NULL) || bEmpty || (maxCnt == 0))
+    {
+        return 0;
+    }
+    
+    U16 outCnt = 0;
+    U16 page = headPage;
+    
+    /* Oldest page follows the newest one */
+    for (U16 i=0; i<pageCnt; i++)
+    {
+        page = (page + 1) % pageCnt;
+        if (pageSeq(page) == TLOG_SEQ_EMPTY)
+        {
+            continue;
+        }
+        
+        /* Skip page if the next page starts before the range */
+        if (page != headPage)
+        {
+            U16 next = (page + 1) % pageCnt;
+            U8 nextTime[4];
+            pStore->Read(next, 1, nextTime, 4);
+            U32 nextSec = (U32)nextTime[0] | ((U32)nextTime[1] << 8) |
+                          ((U32)nextTime[2] << 16) | ((U32)nextTime[3] << 24);
+            if (nextSec < secFrom)
+            {
+                continue;
+            }
+        }
+        
+        tlogReader rd;
+        bool bNext = readStart(&rd, page);
+        while (bNext)
+        {
+            if (rd.cur.secTime > secTo)
+            {
+                return outCnt;
+            }
+            if (rd.cur.secTime >= secFrom)
+            {
+                pOut[outCnt++] = rd.cur;
+                if (outCnt >= maxCnt)
+                {
+                    return outCnt;
+                }
+            }
+            bNext = readNext(&rd);
+        }
+        
+        if (page == headPage)
+        {
+            break;
+        }
+    }
+    
+    /* Unchanged samples not yet written */
+    tlogSample smp = last;
+    smp.secTime -= (U32)runCnt * logPeriod;
+    for (U8 r=0; r<runCnt; r++)
+    {
+        smp.secTime += logPeriod;
+        if (smp.secTime > secTo)
+        {
+            break;
+        }
+        if (smp.secTime >= secFrom)
+        {
+            pOut[outCnt++] = smp;
+            if (outCnt >= maxCnt)
+            {
+                break;
+            }
+        }
+    }
+    return outCnt;
+}
+
+//------------------------------------------------------------------------------
+// Newest sample
+//------------------------------------------------------------------------------
+bool objTimeLog::GetLast(tlogSample *pSample)
+{
+    if ((pStore == NULL) || bEmpty)
+    {
+        return false; // ERROR
+    }
+    *pSample = last;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Statistic since "Begin()"
+//------------------------------------------------------------------------------
+void objTimeLog::GetStats(U32 *sampleCnt, U32 *byteCnt)
+{
+    *sampleCnt = statSamples;
+    *byteCnt = statBytes;
+}
+
+//------------------------------------------------------------------------------
+// Sequence number of page
+//------------------------------------------------------------------------------
+U8 objTimeLog::pageSeq(U16 page)
+{
+    U8 seq;
+    pStore->Read(page, 0, &seq, 1);
+    return seq;
+}
+
+//------------------------------------------------------------------------------
+// Erase next page and write header with base sample
+//------------------------------------------------------------------------------
+void objTimeLog::pageStart(const tlogSample *pBase)
+{
+    headPage = (headPage + 1) % pageCnt;
+    headSeq = (headSeq + 1) % TLOG_SEQ_WRAP;
+    
+    if (pageSeq(headPage) != TLOG_SEQ_EMPTY)
+    {
+        pStore->Erase(headPage);
+    }
+    
+    U8 head[TLOG_HEAD_LEN];
+    head[0] = headSeq;
+    head[1] = (U8)(pBase->secTime);
+    head[2] = (U8)(pBase->secTime >> 8);
+    head[3] = (U8)(pBase->secTime >> 16);
+    head[4] = (U8)(pBase->secTime >> 24);
+    head[5] = (U8)((U16)pBase->temp);
+    head[6] = (U8)((U16)pBase->temp >> 8);
+    head[7] = (U8)(pBase->humi);
+    head[8] = (U8)(pBase->humi >> 8);
+    pStore->Write(headPage, 0, head, TLOG_HEAD_LEN);
+    
+    headOffset = TLOG_HEAD_LEN;
+    statBytes += TLOG_HEAD_LEN;
+    last = *pBase;
+    bEmpty = false;
+}
+
+//------------------------------------------------------------------------------
+// Write record to newest page, FALSE if page is full
+//------------------------------------------------------------------------------
+bool objTimeLog::recordWrite(const U8 *pRec, U8 recLen)
+{
+    if ((headOffset + recLen) > pageSize)
+    {
+        return false; // ERROR
+    }
+    pStore->Write(headPage, headOffset, pRec, recLen);
+    headOffset += recLen;
+    statBytes += recLen;
+    return true; // OK
+}
+
+//------------------------------------------------------------------------------
+// Write pending unchanged samples as run record
+//------------------------------------------------------------------------------
+void objTimeLog::runWrite(void)
+{
+    if (runCnt == 0)
+    {
+        return;
+    }
+    
+    U8 rec = TLOG_REC_RUN | (runCnt - 1);
+    if (!recordWrite(&rec, 1))
+    {
+        /* Page full: first sample of the run is the new base */
+        tlogSample smp = last;
+        U8 cnt = runCnt;
+        smp.secTime -= (U32)(cnt - 1) * logPeriod;
+        pageStart(&smp);
+        last.secTime += (U32)(cnt - 1) * logPeriod;
+        if (cnt > 1)
+        {
+            rec = TLOG_REC_RUN | (cnt - 2);
+            recordWrite(&rec, 1);
+        }
+    }
+    runCnt = 0;
+}
+
+//------------------------------------------------------------------------------
+// Start reading page, current sample is the base sample
+//------------------------------------------------------------------------------
+bool objTimeLog::readStart(tlogReader *pRd, U16 page)
+{
+    U8 head[TLOG_HEAD_LEN];
+    pStore->Read(page, 0, head, TLOG_HEAD_LEN);
+    pRd->page = page;
+    pRd->offset = TLOG_HEAD_LEN;
+    pRd->runLeft = 0;
+    pRd->cur.secTime = (U32)head[1] | ((U32)head[2] << 8) |
+                       ((U32)head[3] << 16) | ((U32)head[4] << 24);
+    pRd->cur.temp = (S16)((U16)head[5] | ((U16)head[6] << 8));
+    pRd->cur.humi = (U16)head[7] | ((U16)head[8] << 8);
+    return (head[0] != TLOG_SEQ_EMPTY);
+}
+
+//------------------------------------------------------------------------------
+// Decode next sample, FALSE at end of page
+//------------------------------------------------------------------------------
+bool objTimeLog::readNext(tlogReader *pRd)
+{
+    if (pRd->runLeft > 0)
+    {
+        pRd->runLeft--;
+        pRd->cur.secTime += logPeriod;
+        return true;
+    }
+    
+    if (pRd->offset >= pageSize)
+    {
+        return false;
+    }
+    
+    U16 recOffset = pRd->offset;
+    U8 rec = readByte(pRd);
+    if ((rec & 0x80) == 0)
+    {
+        pRd->cur.secTime += logPeriod;
+        pRd->cur.temp += (S16)(rec >> 3) + TLOG_SHORT_T_MIN;
+        pRd->cur.humi += (S16)(rec & 0x07) + TLOG_SHORT_H_MIN;
+        return true;
+    }
+    if ((rec & 0xC0) == TLOG_REC_RUN)
+    {
+        pRd->runLeft = rec & 0x3F;
+        pRd->cur.secTime += logPeriod;
+        return true;
+    }
+    if (rec == TLOG_REC_LONG)
+    {
+        pRd->cur.secTime += readVarint(pRd);
+        pRd->cur.temp += (S16)unzigzag(readVarint(pRd));
+        pRd->cur.humi += (S16)unzigzag(readVarint(pRd));
+        return true;
+    }
+    
+    /* End of records */
+    pRd->offset = recOffset;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Read next byte of page
+//------------------------------------------------------------------------------
+U8 objTimeLog::readByte(tlogReader *pRd)
+{
+    U8 data = 0xFF;
+    if (pRd->offset < pageSize)
+    {
+        pStore->Read(pRd->page, pRd->offset, &data, 1);
+        pRd->offset++;
+    }
+    return data;
+}
+
+//------------------------------------------------------------------------------
+// Read varint (7 bits per byte, LSB first)
+//------------------------------------------------------------------------------
+U32 objTimeLog::readVarint(tlogReader *pRd)
+{
+    U32 value = 0;
+    for (U8 shift=0; shift<35; shift+=7)
+    {
+        U8 data = readByte(pRd);
+        value |= (U32)(data & 0x7F) << shift;
+        if ((data & 0x80) == 0)
+        {
+            break;
+        }
+    }
+    return value;
+}
+
+//------------------------------------------------------------------------------
+// Write varint, return length
+//------------------------------------------------------------------------------
+U8 objTimeLog::putVarint(U8 *pBuf, U32 value)
+{
+    U8 len = 0;
+    while (value >= 0x80)
+    {
+        pBuf[len++] = (U8)(value | 0x80);
+        value >>= 7;
+    }
+    pBuf[len++] = (U8)value;
+    return len;
+}
+
+#endif // CE_OBJ_TIMELOG
+
+// END OF objTimeLog.cpp
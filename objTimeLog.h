@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+// File...: objTimeLog.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// OBJECT CLASS: objTimeLog - Compact circular log for temperature/humidity
+//------------------------------------------------------------------------------
+#ifndef _CPP_OBJTIMELOG
+#define _CPP_OBJTIMELOG
+
+//------------------------------------------------------------------------------
+/* The log is written into pages of a caller provided region ("tlogStore":
+ * RAM buffer, EEPROM, flash pages), every byte is written once per round,
+ * the pages are used round robin -> equal wear, no fixed index location.
+ *
+ * Page: header (9 bytes) + records, erased bytes are 0xFF
+ *   [0]    sequence number 0..254 (0xFF = erased page)
+ *   [1..4] time [s], [5..6] temperature [0.1°C], [7..8] humidity [0.1%]
+ *
+ * Records (delta to the previous sample, "secPeriod" = nominal interval):
+ *   0ttt thhh        : dt = secPeriod, dTemp = t-8 (-8..7), dHumi = h-4 (-4..3)
+ *   10nn nnnn        : n+1 samples unchanged, dt = secPeriod (1..64)
+ *   1100 0000 v v v  : dt, dTemp, dHumi as zigzag varints
+ *   1111 1111        : end of page
+ *
+ * Unchanged samples are counted in RAM and written as one record when the
+ * values change (or "Flush()") -> up to 64 samples per byte.
+ */
+//------------------------------------------------------------------------------
+
+/* Page header length */
+#define TLOG_HEAD_LEN      9
+
+/* Longest record: marker + 5 + 3 + 3 varint bytes */
+#define TLOG_REC_MAX      12
+
+/* Page size [bytes]: header and at least one longest record */
+#define TLOG_PAGE_MIN     (TLOG_HEAD_LEN + TLOG_REC_MAX)
+#define TLOG_PAGE_MAX     4096
+
+/* Sample */
+typedef struct
+{
+    U32 secTime;
+    S16 temp;         // 0.1°C
+    U16 humi;         // 0.1%
+} tlogSample;
+
+//==============================================================================
+// INTERFACE: tlogStore - Storage in pages
+//==============================================================================
+class tlogStore
+{
+    public:
+        virtual U16 PageSize(void) = 0;
+        virtual U16 PageCount(void) = 0;
+        virtual void Read(U16 page, U16 offset, U8 *pData, U16 dataLen) = 0;
+        virtual void Write(U16 page, U16 offset, const U8 *pData, U16 dataLen) = 0;
+        
+        /* Set all bytes of page to 0xFF */
+        virtual void Erase(U16 page) = 0;
+};
+
+//==============================================================================
+// STORE: tlogRam - Byte region in RAM
+//==============================================================================
+class tlogRam : public tlogStore
+{
+    public:
+        tlogRam(U8 *pRegion, U16 regionLen, U16 pageSize)
+        {
+            pMem = pRegion;
+            pgSize = pageSize;
+            pgCount = regionLen / pageSize;
+        }
+        
+        virtual U16 PageSize(void) { return pgSize; }
+        virtual U16 PageCount(void) { return pgCount; }
+        
+        virtual void Read(U16 page, U16 offset, U8 *pData, U16 dataLen)
+        {
+            memcpy(pData, &pMem[((U32)page * pgSize) + offset], dataLen);
+        }
+        
+        virtual void Write(U16 page, U16 offset, const U8 *pData, U16 dataLen)
+        {
+            memcpy(&pMem[((U32)page * pgSize) + offset], pData, dataLen);
+        }
+        
+        virtual void Erase(U16 page)
+        {
+            memset(&pMem[(U32)page * pgSize], 0xFF, pgSize);
+        }
+        
+    private:
+        U8 *pMem;
+        U16 pgSize;
+        U16 pgCount;
+};
+
+/* Page reader (sequential decode) */
+typedef struct
+{
+    U16 page;
+    U16 offset;
+    U8  runLeft;      // Unchanged samples left of a run record
+    tlogSample cur;
+} tlogReader;
+
+//==============================================================================
+// OBJECT CLASS: objTimeLog - Compact circular log
+//==============================================================================
+class objTimeLog
+{
+    public:
+        /* Class constructor */
+        objTimeLog(void);
+        
+        /* Open log in store (min. 2 pages of TLOG_PAGE_MIN..TLOG_PAGE_MAX */
+        /* bytes), continue after the newest sample, FALSE if store invalid */
+        bool Begin(tlogStore *pStore, U16 secPeriod);
+        
+        /* Erase all pages */
+        void Clear(void);
+        
+        /* Append sample (time must not decrease), FALSE on error */
+        bool Append(U32 secTime, S16 temp, U16 humi);
+        
+        /* Write pending unchanged samples (e.g. before power down) */
+        void Flush(void);
+        
+        /* Get max. "maxCnt" samples secFrom <= time <= secTo, oldest */
+        /* first, return number of samples */
+        U16 Query(U32 secFrom, U32 secTo, tlogSample *pOut, U16 maxCnt);
+        
+        /* Newest sample, FALSE if log is empty */
+        bool GetLast(tlogSample *pSample);
+        
+        /* Statistic since "Begin()": appended samples and written bytes */
+        void GetStats(U32 *sampleCnt, U32 *byteCnt);
+        
+    private:
+        tlogStore *pStore;
+        U16 pageSize;
+        U16 pageCnt;
+        U16 logPeriod;
+        
+        /* Write position and last sample */
+        bool bEmpty;
+        U16 headPage;
+        U16 headOffset;
+        U8 headSeq;
+        tlogSample last;
+        U8 runCnt;
+        
+        U32 statSamples;
+        U32 statBytes;
+        
+        U8 pageSeq(U16 page);
+        void pageStart(const tlogSample *pBase);
+        bool recordWrite(const U8 *pRec, U8 recLen);
+        void runWrite(void);
+        bool readStart(tlogReader *pRd, U16 page);
+        bool readNext(tlogReader *pRd);
+        U8 readByte(tlogReader *pRd);
+        U32 readVarint(tlogReader *pRd);
+        static U8 putVarint(U8 *pBuf, U32 value);
+        static U32 zigzag(S32 value) { return ((U32)value << 1) ^ (U32)(value >> 31); }
+        static S32 unzigzag(U32 value) { return (S32)(value >> 1) ^ -(S32)(value & 1); }
+};
+
+#endif // _CPP_OBJTIMELOG
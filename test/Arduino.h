@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+// File...: Arduino.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: Arduino core stand-in with simulated time and pins (Linux)
+//------------------------------------------------------------------------------
+#ifndef _CPP_HOST_ARDUINO
+#define _CPP_HOST_ARDUINO
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+typedef uint8_t  U8;
+typedef uint16_t U16;
+typedef uint32_t U32;
+typedef int8_t   S8;
+typedef int16_t  S16;
+typedef int32_t  S32;
+
+#include "../defGlobal.h"
+
+#define HIGH          1
+#define LOW           0
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+#define CHANGE        1
+#define RISING        3
+#define FALLING       2
+#define NOT_AN_INTERRUPT (-1)
+
+#define DEC          10
+#define HEX          16
+#define BIN           2
+
+#define PROGMEM
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+
+#define noInterrupts()
+#define interrupts()
+
+#define HOST_PIN_CNT     64
+
+//------------------------------------------------------------------------------
+// Simulated time: only "HostAdvance()", "delay()" and the fake bus move it
+//------------------------------------------------------------------------------
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long msTime);
+void delayMicroseconds(unsigned int usTime);
+
+/* Advance simulated time [us] */
+void HostAdvance(uint32_t usTime);
+
+/* Simulated time since start [us] (64 bit, no wrap) */
+uint64_t HostMicros(void);
+
+/* Set simulated time (test start, millis() wrap tests) */
+void HostSetMicros(uint64_t usTime);
+
+//------------------------------------------------------------------------------
+// Simulated pins
+//------------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+int  digitalPinToInterrupt(uint8_t pin);
+void attachInterrupt(uint8_t irq, void (*pIsr)(void), int mode);
+void detachInterrupt(uint8_t irq);
+
+/* Output hook: called by "digitalWrite()" (e.g. pulse recorder) */
+typedef void (*hostPinHook)(uint8_t pin, uint8_t val);
+void HostPinHook(hostPinHook pHook);
+
+/* Set input level, calls the interrupt routine of the pin on change */
+void HostPinSet(uint8_t pin, uint8_t val);
+
+/* Last written output level */
+uint8_t HostPinGet(uint8_t pin);
+
+//------------------------------------------------------------------------------
+// Serial: output is discarded
+//------------------------------------------------------------------------------
+struct hostSerial
+{
+    void begin(unsigned long) {}
+    template <class T> void print(T, int = DEC) {}
+    template <class T> void println(T, int = DEC) {}
+    void println(void) {}
+};
+extern hostSerial Serial;
+
+#endif // _CPP_HOST_ARDUINO
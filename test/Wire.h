@@ -0,0 +1,94 @@
+//------------------------------------------------------------------------------
+// File...: Wire.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: fake TwoWire bus with simulated devices and bus timing
+//------------------------------------------------------------------------------
+// Every transaction moves the simulated time by its bus time:
+//   (start + address + data bytes) * 9 bit + stop at "setClock()" (100 kHz)
+// Devices are attached per I2C address, a missing device answers NACK.
+//------------------------------------------------------------------------------
+#ifndef _CPP_HOST_WIRE
+#define _CPP_HOST_WIRE
+
+#include "Arduino.h"
+
+#define WIRE_BUF_LEN     32
+#define WIRE_DEV_MAX      8
+
+//==============================================================================
+// INTERFACE: fakeIccDevice - Simulated I2C device
+//==============================================================================
+class fakeIccDevice
+{
+    public:
+        virtual ~fakeIccDevice() {}
+        
+        /* Write from master, FALSE = NACK */
+        virtual bool OnWrite(U8 devAddr, const U8 *pData, U8 dataLen) = 0;
+        
+        /* Read by master, return number of bytes sent */
+        virtual U8 OnRead(U8 devAddr, U8 *pData, U8 dataLen) = 0;
+};
+
+/* Bus statistic */
+typedef struct
+{
+    U32 wrTrans;
+    U32 rdTrans;
+    U32 nackCnt;
+    U32 byteCnt;
+    uint64_t usBusy;
+    U32 beginCnt;
+} fakeWireStats;
+
+//==============================================================================
+// CLASS: TwoWire - Fake bus
+//==============================================================================
+class TwoWire
+{
+    public:
+        TwoWire(void);
+        
+        void begin(void) { stats.beginCnt++; }
+        void setClock(U32 hzClock) { busClock = hzClock; }
+        void beginTransmission(U8 devAddr);
+        void beginTransmission(int devAddr) { beginTransmission((U8)devAddr); }
+        size_t write(U8 data);
+        size_t write(const U8 *pData, size_t dataLen);
+        U8 endTransmission(bool bStop = true);
+        U8 requestFrom(U8 devAddr, U8 dataLen);
+        U8 requestFrom(int devAddr, int dataLen) { return requestFrom((U8)devAddr, (U8)dataLen); }
+        int available(void) { return rxLen - rxPos; }
+        int read(void) { return (rxPos < rxLen) ? rxBuf[rxPos++] : -1; }
+        
+        /* Host: attach device to address (also addresses of one chip) */
+        bool Attach(U8 devAddr, fakeIccDevice *pDev);
+        void DetachAll(void) { devCnt = 0; }
+        
+        /* Host: statistic */
+        const fakeWireStats *GetStats(void) { return &stats; }
+        void ClearStats(void) { memset(&stats, 0, sizeof(stats)); }
+        
+    private:
+        U32 busClock;
+        U8 devCnt;
+        U8 devAddrList[WIRE_DEV_MAX];
+        fakeIccDevice *devList[WIRE_DEV_MAX];
+        U8 txAddr;
+        U8 txBuf[WIRE_BUF_LEN];
+        U8 txLen;
+        U8 rxBuf[WIRE_BUF_LEN];
+        U8 rxLen;
+        U8 rxPos;
+        fakeWireStats stats;
+        
+        fakeIccDevice *findDev(U8 devAddr);
+        void busTime(U8 byteCnt);
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif // _CPP_HOST_WIRE
@@ -0,0 +1,329 @@
+//------------------------------------------------------------------------------
+// File...: fakeRadio.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: simulated tuner chips (RDA5807M, TEA5767) on the fake bus
+//------------------------------------------------------------------------------
+// Both chips know a list of stations (frequence, RSSI, stereo, PI). Tune
+// and seek complete at once, the status reflects the tuned frequence.
+//------------------------------------------------------------------------------
+#ifndef _CPP_FAKERADIO
+#define _CPP_FAKERADIO
+
+#include "Wire.h"
+
+#define FAKE_STATION_MAX  16
+
+/* Simulated station */
+typedef struct
+{
+    U16 fsFreq;     // 87,6 MHz -> 8760
+    U8  fsRssi;     // 0..127 (TEA5767: /8)
+    bool fsStereo;
+    U16 fsPI;       // RDS program identification (0 = no RDS)
+} fakeStation;
+
+//==============================================================================
+// BASE: fakeTuner - Station list
+//==============================================================================
+class fakeTuner : public fakeIccDevice
+{
+    public:
+        fakeTuner(void) { stCnt = 0; tuneFreq = 0; writeCnt = 0; readCnt = 0; }
+
+        void AddStation(U16 freq, U8 rssi, bool bStereo, U16 pi)
+        {
+            if (stCnt < FAKE_STATION_MAX)
+            {
+                fakeStation *pSt = &stList[stCnt++];
+                pSt->fsFreq = freq;
+                pSt->fsRssi = rssi;
+                pSt->fsStereo = bStereo;
+                pSt->fsPI = pi;
+            }
+        }
+
+        U16 GetTuned(void) { return tuneFreq; }
+        U32 GetWrites(void) { return writeCnt; }
+        U32 GetReads(void) { return readCnt; }
+
+    protected:
+        fakeStation stList[FAKE_STATION_MAX];
+        U8 stCnt;
+        U16 tuneFreq;
+        U32 writeCnt;
+        U32 readCnt;
+
+        const fakeStation *station(U16 freq)
+        {
+            for (U8 i=0; i<stCnt; i++)
+            {
+                if (stList[i].fsFreq == freq)
+                    return &stList[i];
+            }
+            return NULL;
+        }
+
+        /* Next station beside "freq" inside fMin..fMax (0 = none) */
+        U16 seekNext(U16 freq, bool bUp, U16 fMin, U16 fMax, bool bWrap)
+        {
+            U16 best = 0;
+            for (U8 i=0; i<stCnt; i++)
+            {
+                U16 f = stList[i].fsFreq;
+                if ((f < fMin) || (f > fMax))
+                    continue;
+                if (bUp && (f > freq) && ((best == 0) || (f < best)))
+                    best = f;
+                if (!bUp && (f < freq) && ((best == 0) || (f > best)))
+                    best = f;
+            }
+            if ((best == 0) && bWrap)
+            {
+                for (U8 i=0; i<stCnt; i++)
+                {
+                    U16 f = stList[i].fsFreq;
+                    if ((f < fMin) || (f > fMax))
+                        continue;
+                    if (bUp && ((best == 0) || (f < best)))
+                        best = f;
+                    if (!bUp && ((best == 0) || (f > best)))
+                        best = f;
+                }
+            }
+            return best;
+        }
+};
+
+//==============================================================================
+// CHIP: fakeRda5807m - 0x10 sequential (write from 0x02, read from 0x0A),
+//                      0x11 random access [register, high, low]
+//==============================================================================
+class fakeRda5807m : public fakeTuner
+{
+    public:
+        fakeRda5807m(void)
+        {
+            memset(reg, 0, sizeof(reg));
+            reg[0x00] = 0x5804;
+            resetCnt = 0;
+            rdsPending = false;
+        }
+
+        U16 GetReg(U8 iRegister) { return reg[iRegister & 0x0F]; }
+        U32 GetResets(void) { return resetCnt; }
+
+        virtual bool OnWrite(U8 devAddr, const U8 *pData, U8 dataLen)
+        {
+            writeCnt++;
+            if (dataLen == 0)
+                return true;
+            if (devAddr == 0x11)
+            {
+                if (dataLen >= 3)
+                    setReg(pData[0], ((U16)pData[1] << 8) | pData[2]);
+                return true;
+            }
+            for (U8 i=0; (i + 1) < dataLen; i+=2)
+            {
+                setReg(0x02 + (i / 2), ((U16)pData[i] << 8) | pData[i + 1]);
+            }
+            return true;
+        }
+
+        virtual U8 OnRead(U8 devAddr, U8 *pData, U8 dataLen)
+        {
+            (void)devAddr;
+            readCnt++;
+            for (U8 i=0; i<dataLen; i++)
+            {
+                U16 val = reg[(0x0A + (i / 2)) & 0x0F];
+                pData[i] = (i & 1) ? (U8)val : (U8)(val >> 8);
+            }
+            /* RDSR cleared by reading the blocks */
+            if (dataLen >= 12)
+            {
+                reg[0x0A] &= ~0x8000;
+            }
+            return dataLen;
+        }
+
+        /* New RDS group of tuned station (PI in block A) */
+        void PushRds(U16 blockB, U16 blockC, U16 blockD)
+        {
+            const fakeStation *pSt = station(tuneFreq);
+            if ((pSt == NULL) || (pSt->fsPI == 0) || !(reg[0x02] & 0x0008))
+                return;
+            reg[0x0A] |= 0x8000;
+            reg[0x0C] = pSt->fsPI;
+            reg[0x0D] = blockB;
+            reg[0x0E] = blockC;
+            reg[0x0F] = blockD;
+        }
+
+    private:
+        U16 reg[16];
+        U32 resetCnt;
+        bool rdsPending;
+
+        U16 fMin(void)
+        {
+            static const U16 bandMin[4] = { 8700, 7600, 7600, 6500 };
+            return bandMin[(reg[0x03] >> 2) & 0x03];
+        }
+
+        U16 fMax(void)
+        {
+            static const U16 bandMax[4] = { 10800, 9100, 10800, 7600 };
+            return bandMax[(reg[0x03] >> 2) & 0x03];
+        }
+
+        /* Spacing [kHz] */
+        U16 space(void)
+        {
+            static const U16 bandSpace[4] = { 100, 200, 50, 25 };
+            return bandSpace[reg[0x03] & 0x03];
+        }
+
+        void setReg(U8 iRegister, U16 val)
+        {
+            if ((iRegister < 0x02) || (iRegister > 0x07))
+                return;
+            reg[iRegister] = val;
+            if ((iRegister == 0x02) && (val & 0x0002))
+            {
+                resetCnt++;
+                return;
+            }
+            if ((iRegister == 0x02) && (val & 0x0100))
+            {
+                doSeek();
+            }
+            else if ((iRegister == 0x03) && (val & 0x0010))
+            {
+                U16 chan = val >> 6;
+                tuned(fMin() + (U16)(((U32)chan * space()) / 10), false);
+            }
+        }
+
+        void doSeek(void)
+        {
+            bool bUp = (reg[0x02] & 0x0200) != 0;
+            bool bWrap = (reg[0x02] & 0x0080) == 0;
+            U16 freq = seekNext(tuneFreq, bUp, fMin(), fMax(), bWrap);
+            if (freq == 0)
+            {
+                /* SF: stays at band limit */
+                tuned(bUp ? fMax() : fMin(), true);
+                return;
+            }
+            tuned(freq, false);
+        }
+
+        void tuned(U16 freq, bool bFail)
+        {
+            tuneFreq = freq;
+            U16 chan = (U16)((((U32)(freq - fMin())) * 10) / space());
+            const fakeStation *pSt = station(freq);
+            reg[0x0A] = 0x4000 | (chan & 0x03FF);
+            if (bFail)
+                reg[0x0A] |= 0x2000;
+            if ((pSt != NULL) && pSt->fsStereo)
+                reg[0x0A] |= 0x0400;
+            reg[0x0B] = 0x0080;
+            if (pSt != NULL)
+                reg[0x0B] |= ((U16)(pSt->fsRssi & 0x7F) << 9) | 0x0100;
+        }
+};
+
+//==============================================================================
+// CHIP: fakeTea5767 - 5 byte write and read frame
+//==============================================================================
+class fakeTea5767 : public fakeTuner
+{
+    public:
+        fakeTea5767(void) { memset(wr, 0, sizeof(wr)); memset(rd, 0, sizeof(rd)); }
+
+        const U8 *GetFrame(void) { return wr; }
+
+        virtual bool OnWrite(U8 devAddr, const U8 *pData, U8 dataLen)
+        {
+            (void)devAddr;
+            writeCnt++;
+            if (dataLen == 2)
+            {
+                /* Single register frame [register, value] (objRadio) */
+                if (pData[0] < 5)
+                    wr[pData[0]] = pData[1];
+            }
+            else
+            {
+                for (U8 i=0; (i<dataLen) && (i<5); i++)
+                    wr[i] = pData[i];
+            }
+            if (dataLen == 0)
+                return true;
+
+            bool bJapan = (wr[3] & 0x20) != 0;
+            U16 fMin = bJapan ? 7600 : 8750;
+            U16 fMax = bJapan ? 9100 : 10800;
+            U16 pll = ((U16)(wr[0] & 0x3F) << 8) | wr[1];
+            U16 freq = pllFreq(pll);
+            bool bFail = false;
+            if (wr[0] & 0x40)
+            {
+                /* Search from the written PLL (objRadio starts beside) */
+                bool bUp = (wr[2] & 0x80) != 0;
+                U16 found = seekNext(bUp ? freq - 1 : freq + 1, bUp, fMin, fMax, false);
+                if (found == 0)
+                {
+                    bFail = true;
+                    found = bUp ? fMax : fMin;
+                }
+                freq = found;
+                pll = freqPll(freq);
+            }
+            tuneFreq = freq;
+
+            const fakeStation *pSt = station(freq);
+            rd[0] = 0x80 | (bFail ? 0x40 : 0) | ((pll >> 8) & 0x3F);
+            rd[1] = pll & 0xFF;
+            rd[2] = 0x37;
+            if ((pSt != NULL) && pSt->fsStereo)
+                rd[2] |= 0x80;
+            if (pSt == NULL)
+                rd[2] = (rd[2] & 0x80) | 0x10;
+            rd[3] = (pSt != NULL) ? (U8)((pSt->fsRssi >> 3) << 4) : 0;
+            rd[4] = 0;
+            return true;
+        }
+
+        virtual U8 OnRead(U8 devAddr, U8 *pData, U8 dataLen)
+        {
+            (void)devAddr;
+            readCnt++;
+            for (U8 i=0; i<dataLen; i++)
+                pData[i] = (i < 5) ? rd[i] : 0;
+            return dataLen;
+        }
+
+    private:
+        U8 wr[5];
+        U8 rd[5];
+
+        /* High side injection: PLL = 4 * (f + 225 kHz) / 32768 Hz */
+        static U16 freqPll(U16 freq)
+        {
+            return (U16)(((U32)freq * 10000 + 225000) / 8192);
+        }
+
+        /* PLL -> frequence, rounded to 50 kHz [10 kHz] */
+        static U16 pllFreq(U16 pll)
+        {
+            U32 kHz = ((U32)pll * 8192 - 225000) / 1000;
+            return (U16)(((kHz + 25) / 50) * 5);
+        }
+};
+
+#endif // _CPP_FAKERADIO
@@ -0,0 +1,107 @@
+//------------------------------------------------------------------------------
+// File...: fakeSensor.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: simulated DHT12 and synthetic bus load on the fake bus
+//------------------------------------------------------------------------------
+#ifndef _CPP_FAKESENSOR
+#define _CPP_FAKESENSOR
+
+#include "Wire.h"
+#include "../defIccBus.h"
+
+//==============================================================================
+// SENSOR: fakeDht12 - register pointer write, 5 byte read [H, h, T, t, sum]
+//==============================================================================
+class fakeDht12 : public fakeIccDevice
+{
+    public:
+        fakeDht12(void) { SetValue(215, 456); regPos = 0; readCnt = 0; bFail = false; }
+        
+        /* Temperatur and humidity [0.1] (e.g. -105 -> -10,5°C) */
+        void SetValue(S16 temp, U16 humi)
+        {
+            U16 tAbs = (temp < 0) ? -temp : temp;
+            frame[0] = humi / 10;
+            frame[1] = humi % 10;
+            frame[2] = tAbs / 10;
+            frame[3] = (tAbs % 10) | ((temp < 0) ? 0x80 : 0);
+            frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+        }
+        
+        /* Raw frame (checksum not updated) */
+        void SetFrame(const U8 *pFrame) { memcpy(frame, pFrame, 5); }
+        
+        /* Sensor does not answer (NACK) */
+        void SetFail(bool bFailOn) { bFail = bFailOn; }
+        
+        U32 GetReads(void) { return readCnt; }
+        
+        virtual bool OnWrite(U8 devAddr, const U8 *pData, U8 dataLen)
+        {
+            (void)devAddr;
+            if (bFail)
+                return false;
+            if (dataLen > 0)
+                regPos = pData[0];
+            return true;
+        }
+        
+        virtual U8 OnRead(U8 devAddr, U8 *pData, U8 dataLen)
+        {
+            (void)devAddr;
+            if (bFail)
+                return 0;
+            readCnt++;
+            U8 n = 0;
+            for (; (n < dataLen) && ((regPos + n) < 5); n++)
+                pData[n] = frame[regPos + n];
+            return n;
+        }
+        
+    private:
+        U8 frame[5];
+        U8 regPos;
+        U32 readCnt;
+        bool bFail;
+};
+
+//==============================================================================
+// DEVICE: fakeLoad - one transaction per "Tick()" (saturated device)
+//==============================================================================
+class fakeLoad : public fakeIccDevice
+{
+    public:
+        fakeLoad(void) { pBus = iccWire::Default(); loadAddr = 0x70; loadLen = 4; }
+        
+        void SetBus(iccBus *pIccBus) { pBus = pIccBus; }
+        iccBus *GetBus(void) { return pBus; }
+        void SetAddr(U8 addr, U8 dataLen) { loadAddr = addr; loadLen = dataLen; }
+        
+        bool Tick(void)
+        {
+            U8 data[WIRE_BUF_LEN] = { 0 };
+            pBus->Write(loadAddr, data, loadLen);
+            return true;
+        }
+        
+        virtual bool OnWrite(U8 devAddr, const U8 *pData, U8 dataLen)
+        {
+            (void)devAddr; (void)pData; (void)dataLen;
+            return true;
+        }
+        
+        virtual U8 OnRead(U8 devAddr, U8 *pData, U8 dataLen)
+        {
+            (void)devAddr; (void)pData;
+            return dataLen;
+        }
+        
+    private:
+        iccBus *pBus;
+        U8 loadAddr;
+        U8 loadLen;
+};
+
+#endif // _CPP_FAKESENSOR
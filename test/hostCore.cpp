@@ -0,0 +1,217 @@
+//------------------------------------------------------------------------------
+// File...: hostCore.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: simulated time, pins and fake TwoWire bus
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "Wire.h"
+
+static uint64_t hostTime = 0;
+static U8 pinOut[HOST_PIN_CNT];
+static U8 pinIn[HOST_PIN_CNT];
+static void (*pinIsr[HOST_PIN_CNT])(void);
+static hostPinHook pinHook = NULL;
+
+hostSerial Serial;
+TwoWire Wire;
+TwoWire Wire1;
+
+//------------------------------------------------------------------------------
+// Simulated time
+//------------------------------------------------------------------------------
+unsigned long millis(void) { return (U32)(hostTime / 1000); }
+unsigned long micros(void) { return (U32)hostTime; }
+void delay(unsigned long msTime) { hostTime += (uint64_t)msTime * 1000; }
+void delayMicroseconds(unsigned int usTime) { hostTime += usTime; }
+void HostAdvance(uint32_t usTime) { hostTime += usTime; }
+uint64_t HostMicros(void) { return hostTime; }
+void HostSetMicros(uint64_t usTime) { hostTime = usTime; }
+
+//------------------------------------------------------------------------------
+// Simulated pins (pin number = interrupt number)
+//------------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if ((pin < HOST_PIN_CNT) && (mode == INPUT_PULLUP))
+    {
+        pinIn[pin] = HIGH;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+    if (pin >= HOST_PIN_CNT)
+        return;
+    pinOut[pin] = val;
+    if (pinHook != NULL)
+    {
+        pinHook(pin, val);
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    return (pin < HOST_PIN_CNT) ? pinIn[pin] : LOW;
+}
+
+int digitalPinToInterrupt(uint8_t pin)
+{
+    return (pin < HOST_PIN_CNT) ? pin : NOT_AN_INTERRUPT;
+}
+
+void attachInterrupt(uint8_t irq, void (*pIsr)(void), int mode)
+{
+    (void)mode;
+    if (irq < HOST_PIN_CNT)
+    {
+        pinIsr[irq] = pIsr;
+    }
+}
+
+void detachInterrupt(uint8_t irq)
+{
+    if (irq < HOST_PIN_CNT)
+    {
+        pinIsr[irq] = NULL;
+    }
+}
+
+void HostPinHook(hostPinHook pHook) { pinHook = pHook; }
+
+void HostPinSet(uint8_t pin, uint8_t val)
+{
+    if (pin >= HOST_PIN_CNT)
+        return;
+    bool bChange = (pinIn[pin] != val);
+    pinIn[pin] = val;
+    if (bChange && (pinIsr[pin] != NULL))
+    {
+        pinIsr[pin]();
+    }
+}
+
+uint8_t HostPinGet(uint8_t pin)
+{
+    return (pin < HOST_PIN_CNT) ? pinOut[pin] : LOW;
+}
+
+//==============================================================================
+// Fake TwoWire bus
+//==============================================================================
+TwoWire::TwoWire(void)
+{
+    busClock = 100000;
+    devCnt = 0;
+    txAddr = 0;
+    txLen = 0;
+    rxLen = 0;
+    rxPos = 0;
+    ClearStats();
+}
+
+bool TwoWire::Attach(U8 devAddr, fakeIccDevice *pDev)
+{
+    if (devCnt >= WIRE_DEV_MAX)
+    {
+        return false;
+    }
+    devAddrList[devCnt] = devAddr;
+    devList[devCnt] = pDev;
+    devCnt++;
+    return true;
+}
+
+void TwoWire::beginTransmission(U8 devAddr)
+{
+    txAddr = devAddr;
+    txLen = 0;
+}
+
+size_t TwoWire::write(U8 data)
+{
+    if (txLen >= WIRE_BUF_LEN)
+    {
+        return 0;
+    }
+    txBuf[txLen++] = data;
+    return 1;
+}
+
+size_t TwoWire::write(const U8 *pData, size_t dataLen)
+{
+    size_t n = 0;
+    while ((n < dataLen) && write(pData[n]))
+    {
+        n++;
+    }
+    return n;
+}
+
+/* 0 = OK, 2 = NACK on address, 3 = NACK on data (Wire status) */
+U8 TwoWire::endTransmission(bool bStop)
+{
+    (void)bStop;
+    fakeIccDevice *pDev = findDev(txAddr);
+    stats.wrTrans++;
+    if (pDev == NULL)
+    {
+        busTime(0);
+        stats.nackCnt++;
+        return 2;
+    }
+    busTime(txLen);
+    stats.byteCnt += txLen;
+    if (!pDev->OnWrite(txAddr, txBuf, txLen))
+    {
+        stats.nackCnt++;
+        return 3;
+    }
+    return 0;
+}
+
+U8 TwoWire::requestFrom(U8 devAddr, U8 dataLen)
+{
+    fakeIccDevice *pDev = findDev(devAddr);
+    stats.rdTrans++;
+    rxPos = 0;
+    rxLen = 0;
+    if (dataLen > WIRE_BUF_LEN)
+    {
+        dataLen = WIRE_BUF_LEN;
+    }
+    if (pDev == NULL)
+    {
+        busTime(0);
+        stats.nackCnt++;
+        return 0;
+    }
+    rxLen = pDev->OnRead(devAddr, rxBuf, dataLen);
+    busTime(rxLen);
+    stats.byteCnt += rxLen;
+    return rxLen;
+}
+
+fakeIccDevice *TwoWire::findDev(U8 devAddr)
+{
+    for (U8 i=0; i<devCnt; i++)
+    {
+        if (devAddrList[i] == devAddr)
+        {
+            return devList[i];
+        }
+    }
+    return NULL;
+}
+
+/* Start, address byte, data bytes (9 bit each), stop */
+void TwoWire::busTime(U8 byteCnt)
+{
+    U32 bitCnt = 2 + ((U32)(byteCnt + 1) * 9);
+    U32 usTime = (bitCnt * 1000000UL + busClock - 1) / busClock;
+    hostTime += usTime;
+    stats.usBusy += usTime;
+}
+
+// END OF hostCore.cpp
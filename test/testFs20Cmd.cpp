@@ -0,0 +1,194 @@
+//------------------------------------------------------------------------------
+// File...: testFs20Cmd.cpp
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// Host test: objFs20 command queue order, merge and priority
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objFs20.h"
+#include "testHost.h"
+
+#define TX_PIN          5
+#define HC         0x6342
+#define SENT_MAX       16
+
+/* Completed telegrams (callback after last repetition) */
+static U8 sentAddr[SENT_MAX];
+static U8 sentCmd[SENT_MAX];
+static U8 sentCnt = 0;
+
+static void onSent(U16 homeCode, U8 addrByte, U8 cmdByte)
+{
+    (void)homeCode;
+    if (sentCnt < SENT_MAX)
+    {
+        sentAddr[sentCnt] = addrByte;
+        sentCmd[sentCnt] = cmdByte;
+        sentCnt++;
+    }
+}
+
+static void runAll(objFs20 *pFs20)
+{
+    for (U32 n=0; (n<200000) && pFs20->Busy(); n++)
+    {
+        pFs20->Tick();
+        HostAdvance(20);
+    }
+}
+
+/* Start a job and keep it on air */
+static void startBusy(objFs20 *pFs20)
+{
+    sentCnt = 0;
+    pFs20->Send(HC, 0x44, 0x10);
+    pFs20->Tick();
+    HostAdvance(20);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    objFs20 fs20;
+    fs20.Init(TX_PIN);
+    fs20.SetCallback(onSent);
+    
+    /* All ON, then actor 1 OFF (higher priority): FIFO, actor 1 ends OFF */
+    startBusy(&fs20);
+    fs20.Send(HC, 0xFF, 0x10);
+    fs20.Switch(HC, 0x01, false);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 3);
+    TEST_EQUAL(sentAddr[1], 0xFF);
+    TEST_EQUAL(sentAddr[2], 0x01);
+    TEST_EQUAL(sentCmd[2], 0x00);
+    
+    /* Actor 1 ON, then group 0 (0x0F) toggle: FIFO in the other direction */
+    startBusy(&fs20);
+    fs20.SendPrio(HC, 0x01, 0x10, FS20_PRIO_LOW);
+    fs20.SendPrio(HC, 0x0F, 0x12, FS20_PRIO_HIGH);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 3);
+    TEST_EQUAL(sentAddr[1], 0x01);
+    TEST_EQUAL(sentAddr[2], 0x0F);
+    
+    /* Other actors: highest priority first */
+    startBusy(&fs20);
+    fs20.SendPrio(HC, 0x02, 0x10, FS20_PRIO_LOW);
+    fs20.SendPrio(HC, 0x03, 0x10, FS20_PRIO_NORMAL);
+    fs20.SendPrio(HC, 0x13, 0x00, FS20_PRIO_HIGH);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 4);
+    TEST_EQUAL(sentAddr[1], 0x13);
+    TEST_EQUAL(sentAddr[2], 0x03);
+    TEST_EQUAL(sentAddr[3], 0x02);
+    
+    /* Blocked command does not block others: 0x05 waits for 0xF5 */
+    startBusy(&fs20);
+    fs20.SendPrio(HC, 0xF5, 0x12, FS20_PRIO_LOW);
+    fs20.SendPrio(HC, 0x05, 0x00, FS20_PRIO_HIGH);
+    fs20.SendPrio(HC, 0x06, 0x10, FS20_PRIO_NORMAL);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 4);
+    TEST_EQUAL(sentAddr[1], 0x06);
+    TEST_EQUAL(sentAddr[2], 0xF5);
+    TEST_EQUAL(sentAddr[3], 0x05);
+    
+    /* Other homeCode never blocks */
+    startBusy(&fs20);
+    fs20.SendPrio(HC, 0xFF, 0x12, FS20_PRIO_LOW);
+    fs20.SendPrio(HC + 1, 0x01, 0x00, FS20_PRIO_HIGH);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 3);
+    TEST_EQUAL(sentAddr[1], 0x01);
+    
+    /* Absolute command replaces covered pending commands */
+    U16 cmdMerged = 0;
+    U16 cmdDropped = 0;
+    fs20.GetQueueStats(&cmdMerged, &cmdDropped);
+    startBusy(&fs20);
+    fs20.Send(HC, 0x01, 0x10);
+    fs20.Send(HC, 0x02, 0x10);
+    fs20.Send(HC, 0x0F, 0x00);
+    runAll(&fs20);
+    U16 newMerged = 0;
+    fs20.GetQueueStats(&newMerged, &cmdDropped);
+    TEST_EQUAL(newMerged - cmdMerged, 2);
+    TEST_EQUAL(sentCnt, 2);
+    TEST_EQUAL(sentAddr[1], 0x0F);
+    
+    /* Ramp from unknown level: target level at once, no ramp running */
+    startBusy(&fs20);
+    TEST_CHECK(fs20.DimmRamp(HC, 0x21, FS20_LEVEL_UNKNOWN, 8, 10000));
+    TEST_CHECK(!fs20.DimmBusy(HC, 0x21));
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 2);
+    TEST_EQUAL(sentAddr[1], 0x21);
+    TEST_EQUAL(sentCmd[1], 8);
+    
+    /* Scene over budget: rejected and counted as dropped, not deferred */
+    objFs20 fsScene;
+    fsScene.Init(TX_PIN);
+    fsScene.SetAirLimit(100);
+    fs20SceneItem scene[3] = { { HC, 0x11, 0x10, {} }, { HC, 0x12, 0x10, {} }, 
+                               { HC, 0x13, 0x10, {} } };
+    U8 itemCnt = 3;
+    TEST_CHECK(!fsScene.SendScene(scene, &itemCnt, NULL));
+    U16 cmdDeferred = 0;
+    fsScene.GetDutyStats(&cmdDeferred, &cmdDropped);
+    TEST_EQUAL(cmdDeferred, 0);
+    TEST_EQUAL(cmdDropped, 1);
+    TEST_CHECK(!fsScene.Busy());
+    fsScene.SetAirLimit(FS20_DC_LIMIT);
+    TEST_CHECK(fsScene.SendScene(scene, &itemCnt, NULL));
+    runAll(&fsScene);
+    U32 msScene = 0;
+    for (U8 i=0; i<itemCnt; i++)
+        msScene += (objFs20::AirTime(&scene[i].telegram) + 999) / 1000;
+    TEST_EQUAL(fsScene.GetAirTime(), msScene);
+    
+    /* Cache: hits, least recently used drops out, key includes homeCode */
+    objFs20 fsCache;
+    fsCache.Init(TX_PIN);
+    U16 cacheHit = 0;
+    U16 cacheMiss = 0;
+    for (U8 a=1; a<=FS20_CACHE_LEN; a++)
+        fsCache.GetTelegram(HC, a, 0x10);
+    fsCache.GetTelegram(HC, 1, 0x10);
+    fsCache.GetCacheStats(&cacheHit, &cacheMiss);
+    TEST_EQUAL(cacheHit, 1);
+    TEST_EQUAL(cacheMiss, FS20_CACHE_LEN);
+    fsCache.GetTelegram(HC, FS20_CACHE_LEN + 1, 0x10);
+    fsCache.GetTelegram(HC, 1, 0x10);
+    fsCache.GetTelegram(HC, 3, 0x10);
+    fsCache.GetTelegram(HC, 2, 0x10);              // dropped by actor 5
+    fsCache.GetCacheStats(&cacheHit, &cacheMiss);
+    TEST_EQUAL(cacheHit, 3);
+    TEST_EQUAL(cacheMiss, FS20_CACHE_LEN + 2);
+    
+    fs20Telegram tgOld;
+    fs20Telegram tgNew;
+    objFs20::Encode(HC, 1, 0x10, &tgOld);
+    objFs20::Encode(HC + 1, 1, 0x10, &tgNew);
+    const fs20Telegram *pTg = fsCache.GetTelegram(HC + 1, 1, 0x10);
+    fsCache.GetCacheStats(&cacheHit, &cacheMiss);
+    TEST_EQUAL(cacheMiss, FS20_CACHE_LEN + 3);
+    TEST_CHECK(memcmp(pTg, &tgNew, sizeof(tgNew)) == 0);
+    TEST_CHECK(memcmp(pTg, &tgOld, sizeof(tgOld)) != 0);
+    
+    /* Scene items from the cache: repeated scene only hits */
+    fs20SceneItem sceneRep[2] = { { HC, 0x01, 0x10, {} }, { HC + 1, 0x01, 0x10, {} } };
+    itemCnt = 2;
+    TEST_CHECK(fsCache.SendScene(sceneRep, &itemCnt, NULL));
+    runAll(&fsCache);
+    fsCache.GetCacheStats(&cacheHit, &cacheMiss);
+    TEST_EQUAL(cacheHit, 5);
+    TEST_EQUAL(cacheMiss, FS20_CACHE_LEN + 3);
+    TEST_CHECK(memcmp(&sceneRep[0].telegram, &tgOld, sizeof(tgOld)) == 0);
+    TEST_CHECK(memcmp(&sceneRep[1].telegram, &tgNew, sizeof(tgNew)) == 0);
+    
+    return TestResult("testFs20Cmd");
+}
+
+// END OF testFs20Cmd.cpp
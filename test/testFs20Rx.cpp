@@ -0,0 +1,264 @@
+//------------------------------------------------------------------------------
+// File...: testFs20Rx.cpp
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// Host test: objFs20Rx replay of simulated RX868 traces (clean and noisy),
+// decode rate and false-accept rate
+//------------------------------------------------------------------------------
+#include <stdlib.h>
+#include "Arduino.h"
+#include "../objFs20Rx.h"
+#include "testHost.h"
+
+#define TRACE_TG      2000   // Telegrams per trace
+
+/* Trace generator state */
+static objFs20Rx *pRx = NULL;
+static uint64_t usTrace = 0;
+static bool bTraceLevel = false;
+static U32 jitterUs = 0;      // Max. phase error [us] (+-)
+static U16 glitchPerMil = 0;  // Spike probability per phase [1/1000]
+
+/* Replay result */
+typedef struct
+{
+    U32 tgSent;
+    U32 tgOk;         // Decoded and equal to sent telegram
+    U32 tgFalse;      // Decoded but not sent (false accept)
+    U32 fhtAsFs20;    // FHT reported as FS20
+} rxResult;
+
+static U32 rnd(U32 n) { return (U32)rand() % n; }
+
+//------------------------------------------------------------------------------
+// Phase of "usLen" with "bLevel" -> edge at its end, decode in background
+//------------------------------------------------------------------------------
+static void phase(U32 usLen, bool bLevel)
+{
+    if (bLevel != bTraceLevel)
+    {
+        bTraceLevel = bLevel;
+        HostSetMicros(usTrace);
+        pRx->Capture((U32)usTrace, bLevel);
+        pRx->Decode(8);
+    }
+    if ((glitchPerMil != 0) && (rnd(1000) < glitchPerMil) && (usLen > 200))
+    {
+        /* Spike of 20..120 us inside the phase */
+        U32 usPos = 50 + rnd(usLen - 150);
+        usTrace += usPos;
+        HostSetMicros(usTrace);
+        pRx->Capture((U32)usTrace, !bLevel);
+        pRx->Decode(8);
+        U32 usSpike = 20 + rnd(100);
+        usTrace += usSpike;
+        HostSetMicros(usTrace);
+        pRx->Capture((U32)usTrace, bLevel);
+        pRx->Decode(8);
+        usLen -= usPos + usSpike;
+    }
+    if (jitterUs != 0)
+        usLen = usLen + rnd(2 * jitterUs + 1) - jitterUs;
+    
+    /* loop() calls "Decode()" every ms, also during a long phase */
+    if (usLen > 1000)
+    {
+        HostSetMicros(usTrace + 1000);
+        pRx->Decode(8);
+    }
+    usTrace += usLen;
+}
+
+static void sendBit(U8 aBit)
+{
+    U32 usLen = aBit ? 600 : 400;
+    phase(usLen, true);
+    phase(usLen, false);
+}
+
+static void sendByte(U8 aByte)
+{
+    U8 parity = 0;
+    for (U8 i=0; i<8; i++)
+    {
+        U8 aBit = (aByte >> (7 - i)) & 0x01;
+        parity ^= aBit;
+        sendBit(aBit);
+    }
+    sendBit(parity);
+}
+
+/* Telegram: 12 sync, start, bytes + checksum, end bit, gap */
+static void sendTelegram(const U8 *pData, U8 dataLen, U8 chkOfs)
+{
+    U8 sum = chkOfs;
+    for (U8 i=0; i<12; i++)
+        sendBit(0);
+    sendBit(1);
+    for (U8 i=0; i<dataLen; i++)
+    {
+        sendByte(pData[i]);
+        sum += pData[i];
+    }
+    sendByte(sum);
+    sendBit(0);
+    phase(10000, false);
+}
+
+/* Receiver output without signal: random noise */
+static void sendNoise(U32 usTotal)
+{
+    U32 usEnd = (U32)(usTrace / 1000) * 1000 + usTotal;
+    while ((U32)usTrace < usEnd)
+    {
+        phase(50 + rnd(3000), !bTraceLevel);
+    }
+    phase(5000, false);
+}
+
+//------------------------------------------------------------------------------
+// Random telegram: FS20 (4 bytes), FS20 with extension (5), FHT (5)
+//------------------------------------------------------------------------------
+static void makeTelegram(fs20RxTelegram *pTg, U8 *pData, U8 *pChkOfs, bool bFhtAmbig)
+{
+    U8 kind = bFhtAmbig ? 2 : rnd(3);
+    pData[0] = rnd(256);
+    pData[1] = rnd(256);
+    pData[2] = rnd(256);
+    pData[3] = rnd(256);
+    pData[4] = rnd(256);
+    if (kind == 0)
+    {
+        pData[3] &= ~0x20;
+        pTg->rxType = FS20RX_TYPE_FS20;
+        pTg->rxLen = 4;
+        *pChkOfs = 0x06;
+    }
+    else if (kind == 1)
+    {
+        pData[3] |= 0x20;
+        pTg->rxType = FS20RX_TYPE_FS20;
+        pTg->rxLen = 5;
+        *pChkOfs = 0x06;
+    }
+    else
+    {
+        pTg->rxType = FS20RX_TYPE_FHT;
+        pTg->rxLen = 5;
+        *pChkOfs = 0x0C;
+        if (bFhtAmbig)
+        {
+            /* 5th byte = FS20 checksum of the first 4 bytes */
+            pData[3] &= ~0x20;
+            pData[4] = (U8)(0x06 + pData[0] + pData[1] + pData[2] + pData[3]);
+        }
+    }
+    pTg->homeCode = ((U16)pData[0] << 8) | pData[1];
+    pTg->addrByte = pData[2];
+    pTg->cmdByte = pData[3];
+    pTg->extByte = (pTg->rxLen > 4) ? pData[4] : 0;
+}
+
+static bool sameTelegram(const fs20RxTelegram *pA, const fs20RxTelegram *pB)
+{
+    return (pA->rxType == pB->rxType) && (pA->homeCode == pB->homeCode) &&
+           (pA->addrByte == pB->addrByte) && (pA->cmdByte == pB->cmdByte) &&
+           (pA->extByte == pB->extByte) && (pA->rxLen == pB->rxLen);
+}
+
+//------------------------------------------------------------------------------
+// Replay "TRACE_TG" telegrams (3 repetitions each), noise in between
+//------------------------------------------------------------------------------
+static void replay(U32 jitter, U16 glitch, bool bNoise, bool bFhtAmbig, rxResult *pRes)
+{
+    objFs20Rx rx;
+    TEST_CHECK(rx.Init(0xFF));
+    pRx = &rx;
+    jitterUs = jitter;
+    glitchPerMil = glitch;
+    memset(pRes, 0, sizeof(rxResult));
+    srand(4711);
+    
+    for (U32 n=0; n<TRACE_TG; n++)
+    {
+        fs20RxTelegram tgSent;
+        U8 data[5];
+        U8 chkOfs;
+        makeTelegram(&tgSent, data, &chkOfs, bFhtAmbig);
+        for (U8 r=0; r<3; r++)
+        {
+            sendTelegram(data, tgSent.rxLen, chkOfs);
+        }
+        if (bNoise)
+            sendNoise(300000);
+        else
+            phase(300000, false);
+        
+        pRes->tgSent++;
+        
+        bool bFound = false;
+        fs20RxTelegram tgRx;
+        while (rx.Read(&tgRx))
+        {
+            if (!bFound && sameTelegram(&tgRx, &tgSent))
+            {
+                bFound = true;
+                pRes->tgOk++;
+            }
+            else
+            {
+                pRes->tgFalse++;
+                if ((tgSent.rxType == FS20RX_TYPE_FHT) && (tgRx.rxType == FS20RX_TYPE_FS20) &&
+                    (tgRx.homeCode == tgSent.homeCode))
+                {
+                    pRes->fhtAsFs20++;
+                }
+            }
+        }
+    }
+    pRx = NULL;
+}
+
+static void report(const char *pName, const rxResult *pRes)
+{
+    printf("  %-26s decoded %5.1f%%, false accept %.2f%% (%u/%u/%u)\n", pName,
+           100.0 * pRes->tgOk / pRes->tgSent, 100.0 * pRes->tgFalse / pRes->tgSent,
+           pRes->tgOk, pRes->tgFalse, pRes->tgSent);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    rxResult res;
+    
+    replay(0, 0, false, false, &res);
+    report("clean:", &res);
+    TEST_EQUAL(res.tgOk, TRACE_TG);
+    TEST_EQUAL(res.tgFalse, 0);
+    
+    /* FHT with FS20 checksum after 5 bytes (1 of 256 on air) */
+    replay(0, 0, false, true, &res);
+    report("FHT, FS20 checksum:", &res);
+    TEST_EQUAL(res.tgOk, TRACE_TG);
+    TEST_EQUAL(res.fhtAsFs20, 0);
+    
+    replay(80, 0, true, false, &res);
+    report("noise, jitter 80us:", &res);
+    TEST_CHECK(res.tgOk >= (TRACE_TG * 99) / 100);
+    TEST_CHECK(res.tgFalse <= TRACE_TG / 100);
+    
+    /* Spike in 0.5% of the phases -> ~55% of the repetitions broken */
+    replay(60, 5, true, false, &res);
+    report("noise, jitter 60us, spikes:", &res);
+    TEST_CHECK(res.tgOk >= (TRACE_TG * 85) / 100);
+    TEST_CHECK(res.tgFalse <= TRACE_TG / 100);
+    
+    U16 rxDecoded, rxRepeat, rxError, rxLost;
+    objFs20Rx rx;
+    rx.GetStats(&rxDecoded, &rxRepeat, &rxError, &rxLost);
+    TEST_EQUAL(rxDecoded, 0);
+    return TestResult("testFs20Rx");
+}
+
+// END OF testFs20Rx.cpp
@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------------
+// File...: testFs20Scene.cpp
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// Host test: objFs20 scene grouping, scene latency vs. sequential "Send()"
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objFs20.h"
+#include "testHost.h"
+
+#define TX_PIN          5
+#define HC         0x6342
+#define SCENE_MAX      40
+#define TG_REP          3     // Repetitions per command (objFs20.cpp)
+#define TG_MAX        (SCENE_MAX * TG_REP)
+
+/* Completed commands (callback after last repetition) */
+static U8 sentAddr[SCENE_MAX];
+static U8 sentCmd[SCENE_MAX];
+static U8 sentCnt = 0;
+static uint64_t usLastDone = 0;
+
+static void onSent(U16 homeCode, U8 addrByte, U8 cmdByte)
+{
+    (void)homeCode;
+    if (sentCnt < SCENE_MAX)
+    {
+        sentAddr[sentCnt] = addrByte;
+        sentCmd[sentCnt] = cmdByte;
+        sentCnt++;
+    }
+    usLastDone = HostMicros();
+}
+
+/* Telegram end recorder (pin hook): carrier off for > 1.5 ms = gap */
+static uint64_t tgEnd[TG_MAX];
+static U16 tgCnt = 0;
+static uint64_t usFall = 0;
+
+static void onPin(uint8_t pin, uint8_t val)
+{
+    if (pin != TX_PIN)
+        return;
+    if (val == LOW)
+    {
+        usFall = HostMicros();
+    }
+    else if ((usFall != 0) && (HostMicros() - usFall > 1500) && (tgCnt < TG_MAX))
+    {
+        tgEnd[tgCnt++] = usFall;
+    }
+}
+
+static void runAll(objFs20 *pFs20)
+{
+    for (U32 n=0; (n<2000000) && pFs20->Busy(); n++)
+    {
+        pFs20->Tick();
+        HostAdvance(20);
+    }
+    if ((usFall != 0) && (tgCnt < TG_MAX))
+        tgEnd[tgCnt++] = usFall;
+}
+
+static void startRun(void)
+{
+    sentCnt = 0;
+    tgCnt = 0;
+    usFall = 0;
+}
+
+/* Group members of the benchmark: sub-addresses 0..3 */
+static const U16 benchGroups[FS20_GROUP_CNT] =
+{
+    0x000F, 0x000F, 0x000F, 0x000F, 0x000F, 0x000F, 0x000F, 0x000F,
+    0x000F, 0x000F, 0x000F, 0x000F, 0x000F, 0x000F, 0x000F
+};
+
+/* Scene of "cnt" dimmers (groups of 4), "cmd" for all */
+static void makeScene(fs20SceneItem *pItems, U8 cnt, U8 cmdByte)
+{
+    for (U8 i=0; i<cnt; i++)
+    {
+        pItems[i].homeCode = HC;
+        pItems[i].addrByte = (U8)(((i / 4) << 4) | (i % 4));
+        pItems[i].cmdByte = cmdByte;
+    }
+}
+
+/* Sent commands for the actor (group master included) */
+static U8 actorCmd(U8 addrByte)
+{
+    U8 cmdByte = 0xFF;
+    for (U8 i=0; i<sentCnt; i++)
+    {
+        if ((sentAddr[i] == addrByte) ||
+            (sentAddr[i] == (U8)((addrByte & 0xF0) | 0x0F)))
+            cmdByte = sentCmd[i];
+    }
+    return cmdByte;
+}
+
+//------------------------------------------------------------------------------
+// Scene latency [ms]: all actors switched (first telegram) and all done
+//------------------------------------------------------------------------------
+static void benchScene(U8 cnt, bool bGroup, U32 *pMsFirst, U32 *pMsDone)
+{
+    objFs20 fs20;
+    fs20.Init(TX_PIN);
+    fs20.SetCallback(onSent);
+    fs20SceneItem scene[SCENE_MAX];
+    makeScene(scene, cnt, 0x10);
+    U8 itemCnt = cnt;
+
+    startRun();
+    uint64_t usStart = HostMicros();
+    TEST_CHECK(fs20.SendScene(scene, &itemCnt, (bGroup) ? benchGroups : NULL));
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, itemCnt);
+    TEST_EQUAL(tgCnt, itemCnt * TG_REP);
+    *pMsFirst = (U32)((tgEnd[itemCnt - 1] - usStart) / 1000);
+    *pMsDone = (U32)((usLastDone - usStart) / 1000);
+}
+
+static void benchSequential(U8 cnt, U32 *pMsFirst, U32 *pMsDone)
+{
+    objFs20 fs20;
+    fs20.Init(TX_PIN);
+    fs20.SetCallback(onSent);
+    fs20SceneItem scene[SCENE_MAX];
+    makeScene(scene, cnt, 0x10);
+
+    /* Application loop: feed the queue as it frees */
+    startRun();
+    uint64_t usStart = HostMicros();
+    U8 sendIdx = 0;
+    for (U32 n=0; (n<2000000) && ((sendIdx < cnt) || fs20.Busy()); n++)
+    {
+        if ((sendIdx < cnt) &&
+            fs20.Send(scene[sendIdx].homeCode, scene[sendIdx].addrByte,
+                      scene[sendIdx].cmdByte))
+            sendIdx++;
+        fs20.Tick();
+        HostAdvance(20);
+    }
+    if ((usFall != 0) && (tgCnt < TG_MAX))
+        tgEnd[tgCnt++] = usFall;
+    TEST_EQUAL(sentCnt, cnt);
+    TEST_EQUAL(tgCnt, cnt * TG_REP);
+    *pMsFirst = (U32)((tgEnd[(cnt - 1) * TG_REP] - usStart) / 1000);
+    *pMsDone = (U32)((usLastDone - usStart) / 1000);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    HostPinHook(onPin);
+    objFs20 fs20;
+    fs20.Init(TX_PIN);
+    fs20.SetCallback(onSent);
+
+    /* Members: group 1..3 = sub-addresses 1..3, group 4 = 0..2 */
+    U16 groups[FS20_GROUP_CNT] = { 0 };
+    groups[1] = 0x000E;
+    groups[2] = 0x000E;
+    groups[3] = 0x000E;
+    groups[4] = 0x0007;
+
+    /* Group members with different commands: no master, every actor right */
+    fs20SceneItem mixed[3] = { { HC, 0x11, 0x10, {} }, { HC, 0x12, 0x00, {} },
+                               { HC, 0x13, 0x00, {} } };
+    U8 itemCnt = 3;
+    startRun();
+    TEST_CHECK(fs20.SendScene(mixed, &itemCnt, groups));
+    TEST_EQUAL(itemCnt, 3);
+    runAll(&fs20);
+    TEST_EQUAL(actorCmd(0x11), 0x10);
+    TEST_EQUAL(actorCmd(0x12), 0x00);
+    TEST_EQUAL(actorCmd(0x13), 0x00);
+
+    /* Different member behind the first: no master either */
+    fs20SceneItem last[3] = { { HC, 0x21, 0x00, {} }, { HC, 0x22, 0x00, {} },
+                              { HC, 0x23, 0x10, {} } };
+    itemCnt = 3;
+    startRun();
+    TEST_CHECK(fs20.SendScene(last, &itemCnt, groups));
+    TEST_EQUAL(itemCnt, 3);
+    runAll(&fs20);
+    TEST_EQUAL(actorCmd(0x21), 0x00);
+    TEST_EQUAL(actorCmd(0x23), 0x10);
+
+    /* Same command for the group: master, other homeCode stays single */
+    fs20SceneItem same[4] = { { HC, 0x31, 0x10, {} }, { HC + 1, 0x32, 0x10, {} },
+                              { HC, 0x32, 0x10, {} }, { HC, 0x33, 0x10, {} } };
+    itemCnt = 4;
+    startRun();
+    TEST_CHECK(fs20.SendScene(same, &itemCnt, groups));
+    TEST_EQUAL(itemCnt, 2);
+    TEST_EQUAL(same[0].addrByte, 0x3F);
+    TEST_EQUAL(same[1].homeCode, HC + 1);
+    TEST_EQUAL(same[1].addrByte, 0x32);
+    runAll(&fs20);
+
+    /* Member 0x40 not in the scene: no master, it would switch 0x40 too */
+    fs20SceneItem part[2] = { { HC, 0x41, 0x10, {} }, { HC, 0x42, 0x10, {} } };
+    itemCnt = 2;
+    startRun();
+    TEST_CHECK(fs20.SendScene(part, &itemCnt, groups));
+    TEST_EQUAL(itemCnt, 2);
+    TEST_EQUAL(part[0].addrByte, 0x41);
+    TEST_EQUAL(part[1].addrByte, 0x42);
+    runAll(&fs20);
+    TEST_EQUAL(actorCmd(0x40), 0xFF);
+
+    /* Group without declared members: never grouped */
+    fs20SceneItem undecl[2] = { { HC, 0x51, 0x10, {} }, { HC, 0x52, 0x10, {} } };
+    itemCnt = 2;
+    TEST_CHECK(fs20.SendScene(undecl, &itemCnt, groups));
+    TEST_EQUAL(itemCnt, 2);
+    runAll(&fs20);
+
+    /* Function groups 0xFn: never collapsed to the global master 0xFF */
+    U16 allGroups[FS20_GROUP_CNT];
+    for (U8 g=0; g<FS20_GROUP_CNT; g++)
+        allGroups[g] = FS20_GROUP_ALL;
+    fs20SceneItem func[2] = { { HC, 0xF1, 0x10, {} }, { HC, 0xF2, 0x10, {} } };
+    itemCnt = 2;
+    startRun();
+    TEST_CHECK(fs20.SendScene(func, &itemCnt, allGroups));
+    TEST_EQUAL(itemCnt, 2);
+    TEST_EQUAL(func[0].addrByte, 0xF1);
+    TEST_EQUAL(func[1].addrByte, 0xF2);
+    runAll(&fs20);
+    TEST_EQUAL(sentCnt, 2);
+    TEST_EQUAL(sentAddr[0], 0xF1);
+    TEST_EQUAL(sentAddr[1], 0xF2);
+
+    /* Benchmark: sequential "Send()" vs. scene (interleaved, grouped) */
+    static const U8 benchCnt[2] = { 20, 40 };
+    for (U8 b=0; b<2; b++)
+    {
+        U32 msSeqFirst = 0, msSeqDone = 0;
+        U32 msSceneFirst = 0, msSceneDone = 0;
+        U32 msGroupFirst = 0, msGroupDone = 0;
+        benchSequential(benchCnt[b], &msSeqFirst, &msSeqDone);
+        benchScene(benchCnt[b], false, &msSceneFirst, &msSceneDone);
+        benchScene(benchCnt[b], true, &msGroupFirst, &msGroupDone);
+        printf("  %u actors: all switched / done [ms]: sequential %lu / %lu, "
+               "scene %lu / %lu, grouped %lu / %lu\n", benchCnt[b],
+               (unsigned long)msSeqFirst, (unsigned long)msSeqDone,
+               (unsigned long)msSceneFirst, (unsigned long)msSceneDone,
+               (unsigned long)msGroupFirst, (unsigned long)msGroupDone);
+        TEST_CHECK(msSceneFirst * 2 < msSeqFirst);
+        TEST_CHECK(msSceneDone < msSeqDone);
+        TEST_CHECK(msGroupDone * 3 < msSceneDone);
+    }
+
+    return TestResult("testFs20Scene");
+}
+
+// END OF testFs20Scene.cpp
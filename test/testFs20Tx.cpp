@@ -0,0 +1,184 @@
+//------------------------------------------------------------------------------
+// File...: testFs20Tx.cpp
+// Author.: M. Anders
+// Date...: 24.06.2020
+//------------------------------------------------------------------------------
+// Host test: objFs20 pulse timing, simulated Timer1 and polled engine
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objFs20.h"
+#include "testHost.h"
+
+#define TX_PIN          5
+#define EDGE_MAX     1024
+
+/* Pulse recorder (pin hook) */
+static uint64_t edgeTime[EDGE_MAX];
+static U8 edgeLevel[EDGE_MAX];
+static U16 edgeCnt = 0;
+
+static void onPin(uint8_t pin, uint8_t val)
+{
+    if ((pin != TX_PIN) || (edgeCnt >= EDGE_MAX))
+        return;
+    if ((edgeCnt > 0) && (edgeLevel[edgeCnt - 1] == val))
+        return;
+    edgeTime[edgeCnt] = HostMicros();
+    edgeLevel[edgeCnt] = val;
+    edgeCnt++;
+}
+
+/* Result of one transmission */
+typedef struct
+{
+    U8 tgCnt;         // Decoded telegrams equal to "Encode()"
+    U16 usMaxErr;     // Max. half-bit error [us]
+    U16 halfCnt;      // Half-bits measured
+    U32 usHigh;       // Sum of HIGH phases (carrier on)
+} txResult;
+
+//------------------------------------------------------------------------------
+// Decode recorded pulses: HIGH+LOW = bit (600us = 1), LOW > 2 ms = gap
+//------------------------------------------------------------------------------
+static void analyse(const fs20Telegram *pTg, txResult *pRes)
+{
+    U8 bitCnt = 0;
+    bool bOk = true;
+    pRes->tgCnt = 0;
+    pRes->usMaxErr = 0;
+    pRes->halfCnt = 0;
+    pRes->usHigh = 0;
+    for (U16 i=0; (i + 2) < edgeCnt; i+=2)
+    {
+        U32 usHigh = (U32)(edgeTime[i + 1] - edgeTime[i]);
+        U32 usLow = (U32)(edgeTime[i + 2] - edgeTime[i + 1]);
+        bool bGap = (usLow > 2000);
+        if (bGap)
+            usLow -= 8000;
+        
+        bool bExp = (bitCnt < pTg->tgLen) && 
+                    (pTg->tgBits[bitCnt >> 3] & (0x80 >> (bitCnt & 0x07)));
+        U32 usExp = bExp ? 600 : 400;
+        U32 errHigh = (usHigh > usExp) ? usHigh - usExp : usExp - usHigh;
+        U32 errLow = (usLow > usExp) ? usLow - usExp : usExp - usLow;
+        U32 err = (errHigh > errLow) ? errHigh : errLow;
+        if (err > pRes->usMaxErr)
+            pRes->usMaxErr = (U16)err;
+        pRes->halfCnt += 2;
+        pRes->usHigh += usHigh;
+        
+        /* Receiver: 500us threshold, both halves must agree */
+        if (((usHigh > 500) != bExp) || ((usLow > 500) != bExp) || 
+            (usHigh > 800) || (usLow > 800) || (usHigh < 200) || (usLow < 200))
+            bOk = false;
+        bitCnt++;
+        if (bGap)
+        {
+            if (bOk && (bitCnt == pTg->tgLen))
+                pRes->tgCnt++;
+            bitCnt = 0;
+            bOk = true;
+        }
+    }
+    /* Last telegram ends with the final LOW (no following edge) */
+    if (bOk && ((bitCnt + 1) == pTg->tgLen))
+        pRes->tgCnt++;
+    if ((edgeCnt > 0) && (edgeLevel[edgeCnt - 1] == 0))
+        pRes->usHigh += (U32)(edgeTime[edgeCnt - 1] - edgeTime[edgeCnt - 2]);
+}
+
+//------------------------------------------------------------------------------
+// Send one command, call "Tick()" every "usLoop", stall "usStall" every 10 ms
+//------------------------------------------------------------------------------
+static void transmit(U32 usLoop, U32 usStall, txResult *pRes)
+{
+    fs20Telegram tg;
+    objFs20::Encode(0x6342, 0x01, 0x11, &tg);
+    
+    objFs20 fs20;
+    TEST_CHECK(fs20.Init(TX_PIN));
+    edgeCnt = 0;
+    HostPinHook(onPin);
+    fs20.Send(0x6342, 0x01, 0x11);
+    
+    uint64_t usStart = HostMicros();
+    uint64_t usNextStall = usStart + 10000;
+    while (fs20.Busy() && ((HostMicros() - usStart) < 1000000))
+    {
+        fs20.Tick();
+        HostAdvance(usLoop);
+        if ((usStall != 0) && (HostMicros() >= usNextStall))
+        {
+            HostAdvance(usStall);
+            usNextStall += 10000;
+        }
+    }
+    HostPinHook(NULL);
+    analyse(&tg, pRes);
+}
+
+//------------------------------------------------------------------------------
+// Timer1: compare value per pulse at 12/16/20 MHz (prescaler 8)
+//------------------------------------------------------------------------------
+static void testTimerTicks(void)
+{
+    static const U32 hzList[4] = { 8000000UL, 12000000UL, 16000000UL, 20000000UL };
+    static const U16 usList[4] = { 400, 600, 8000, 20 };
+    for (U8 h=0; h<4; h++)
+    {
+        U32 nsMaxErr = 0;
+        for (U8 u=0; u<4; u++)
+        {
+            /* Timer period (OCR1A + 1) * 8 / F_CPU */
+            U32 ticks = FS20_TIMER_TICKS(usList[u], hzList[h]);
+            U32 nsPulse = (U32)(((uint64_t)ticks * 8000000000ULL) / hzList[h]);
+            U32 nsExp = (U32)usList[u] * 1000;
+            U32 nsErr = (nsPulse > nsExp) ? nsPulse - nsExp : nsExp - nsPulse;
+            if (nsErr > nsMaxErr)
+                nsMaxErr = nsErr;
+            TEST_CHECK(ticks <= 65536);
+        }
+        TEST_CHECK(nsMaxErr < 1000);
+        printf("  Timer1 %2u MHz: max. pulse error %u ns\n", 
+               (unsigned)(hzList[h] / 1000000UL), nsMaxErr);
+    }
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    txResult res;
+    
+    /* Timer interrupt: edge at the compare match (1us resolution) */
+    transmit(1, 0, &res);
+    TEST_EQUAL(res.tgCnt, 3);
+    TEST_EQUAL(res.usMaxErr, 0);
+    TEST_EQUAL(res.halfCnt, 3 * 2 * FS20_TG_BITS - 2);
+    printf("  simulated timer: %u telegrams, max. half-bit error %u us\n", 
+           res.tgCnt, res.usMaxErr);
+    
+    /* Duty cycle charge = carrier on time */
+    fs20Telegram tg;
+    objFs20::Encode(0x6342, 0x01, 0x11, &tg);
+    TEST_EQUAL(objFs20::AirTime(&tg), res.usHigh);
+    printf("  air time (HIGH phases) of 3 telegrams: %u us\n", res.usHigh);
+    
+    /* Polled engine, loop() of 30us */
+    transmit(30, 0, &res);
+    TEST_EQUAL(res.tgCnt, 3);
+    TEST_CHECK(res.usMaxErr <= 30);
+    printf("  polled, 30us loop: %u telegrams, max. half-bit error %u us\n", 
+           res.tgCnt, res.usMaxErr);
+    
+    /* Polled engine, 1 ms stall (I2C transaction) every 10 ms */
+    transmit(20, 1000, &res);
+    TEST_CHECK(res.usMaxErr > 100);
+    TEST_CHECK(res.tgCnt < 3);
+    printf("  polled, 1ms stall per 10ms: %u telegrams, max. half-bit error %u us\n", 
+           res.tgCnt, res.usMaxErr);
+    
+    testTimerTicks();
+    return TestResult("testFs20Tx");
+}
+
+// END OF testFs20Tx.cpp
@@ -0,0 +1,34 @@
+//------------------------------------------------------------------------------
+// File...: testHost.h
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: check macros and result
+//------------------------------------------------------------------------------
+#ifndef _CPP_TESTHOST
+#define _CPP_TESTHOST
+
+#include <stdio.h>
+
+static int testFail = 0;
+static int testCnt = 0;
+
+/* Check condition, print file and line on failure */
+#define TEST_CHECK(c) \
+    do { testCnt++; if (!(c)) { testFail++; \
+         printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #c); } } while (0)
+
+/* Check equal integers, print both values on failure */
+#define TEST_EQUAL(a, b) \
+    do { testCnt++; long _a = (long)(a); long _b = (long)(b); if (_a != _b) { \
+         testFail++; printf("FAIL %s:%d: %s = %ld, expected %ld\n", \
+         __FILE__, __LINE__, #a, _a, _b); } } while (0)
+
+/* Print summary, return exit code for main() */
+static inline int TestResult(const char *pName)
+{
+    printf("%s: %d checks, %d failed\n", pName, testCnt, testFail);
+    return (testFail == 0) ? 0 : 1;
+}
+
+#endif // _CPP_TESTHOST
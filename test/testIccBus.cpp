@@ -0,0 +1,418 @@
+//------------------------------------------------------------------------------
+// File...: testIccBus.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objIccBus scheduler, shared default bus, simulated throughput
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "Wire.h"
+#include "../objIccBus.h"
+#include "../objRadio.h"
+#include "../objRds.h"
+#include "../objTempera.h"
+#include "fakeRadio.h"
+#include "fakeSensor.h"
+#include "testHost.h"
+
+static U32 wireTrans(TwoWire *pWire)
+{
+    return pWire->GetStats()->wrTrans + pWire->GetStats()->rdTrans;
+}
+
+//------------------------------------------------------------------------------
+// Radio and DHT12 without "SetBus()" share one bus: max. one transaction
+//------------------------------------------------------------------------------
+static void testSharedBus(void)
+{
+    fakeRda5807m chip;
+    fakeDht12 dht;
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    Wire.Attach(TEMP_I2C_ADDR, &dht);
+    
+    objRadioT<radioRda5807m> radio;
+    objTempera sensor;
+    TEST_CHECK(radio.GetBus() == sensor.GetBus());
+    TEST_CHECK(radio.GetBus() == iccWire::Default());
+    
+    objIccBus busMgr;
+    TEST_CHECK(busMgr.Insert(&radio, 4));
+    TEST_CHECK(busMgr.Insert(&sensor, 1));
+    radio.Init(0x10);
+    TEST_CHECK(sensor.Init(0));
+    sensor.SetPeriod(TEMP_PERIOD_MIN);
+    radio.SetSignalPoll(20);
+    
+    U32 maxPerTick = 0;
+    for (U32 ms=0; ms<10000; ms++)
+    {
+        U32 trStart = wireTrans(&Wire);
+        busMgr.Tick();
+        U32 trTick = wireTrans(&Wire) - trStart;
+        if (trTick > maxPerTick)
+            maxPerTick = trTick;
+        HostAdvance(1000);
+    }
+    TEST_EQUAL(maxPerTick, 1);
+    TEST_CHECK(sensor.Valid());
+    TEST_EQUAL(sensor.Temperatur(), 215);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+}
+
+//------------------------------------------------------------------------------
+// Priorities on one bus, second bus in parallel, "SetBus()" after "Insert()"
+//------------------------------------------------------------------------------
+static void testPriority(void)
+{
+    fakeLoad load[4];
+    Wire.DetachAll();
+    Wire1.DetachAll();
+    for (U8 i=0; i<4; i++)
+    {
+        load[i].SetAddr(0x70 + i, 4);
+        Wire.Attach(0x70 + i, &load[i]);
+        Wire1.Attach(0x70 + i, &load[i]);
+    }
+    
+    objIccBus busMgr;
+    busMgr.Insert(&load[0], 4);
+    busMgr.Insert(&load[1], 2);
+    busMgr.Insert(&load[2], 1);
+    busMgr.Insert(&load[3], 1);
+    
+    /* Moved to Wire1 after "Insert()" */
+    iccWire wire1Bus(&Wire1);
+    load[3].SetBus(&wire1Bus);
+    
+    Wire.ClearStats();
+    Wire1.ClearStats();
+    U32 trSum = 0;
+    for (U16 n=0; n<700; n++)
+    {
+        trSum += busMgr.Tick();
+    }
+    TEST_EQUAL(wireTrans(&Wire), 700);
+    TEST_EQUAL(wireTrans(&Wire1), 700);
+    TEST_EQUAL(trSum, 1400);
+    TEST_EQUAL(busMgr.GetTrans(&load[0]), 400);
+    TEST_EQUAL(busMgr.GetTrans(&load[1]), 200);
+    TEST_EQUAL(busMgr.GetTrans(&load[2]), 100);
+    TEST_EQUAL(busMgr.GetTrans(&load[3]), 700);
+    
+    /* Back to default bus: shared with the others */
+    load[3].SetBus(iccWire::Default());
+    busMgr.ClearStats();
+    for (U16 n=0; n<800; n++)
+    {
+        busMgr.Tick();
+    }
+    TEST_EQUAL(busMgr.GetTrans(&load[0]), 400);
+    TEST_EQUAL(busMgr.GetTrans(&load[3]), 100);
+}
+
+//------------------------------------------------------------------------------
+// Simulated throughput: N tuners with RDS on one or two buses (100 kHz)
+//------------------------------------------------------------------------------
+static void testThroughput(void)
+{
+    fakeRda5807m chip1;
+    fakeTea5767 chip2;
+    fakeRda5807m chip3;
+    chip1.AddStation(RADIO_FDEF, 60, true, 0xD311);
+    chip3.AddStation(RADIO_FDEF, 60, true, 0xD3C2);
+    Wire.DetachAll();
+    Wire1.DetachAll();
+    Wire.Attach(0x10, &chip1);
+    Wire.Attach(0x11, &chip1);
+    Wire.Attach(0x60, &chip2);
+    Wire1.Attach(0x10, &chip3);
+    Wire1.Attach(0x11, &chip3);
+    
+    objRds rds1;
+    objRds rds3;
+    objRadioT<radioRda5807m> radio1;
+    objRadioT<radioTea5767> radio2;
+    objRadioT<radioRda5807m> radio3;
+    iccWire wire1Bus(&Wire1);
+    radio3.SetBus(&wire1Bus);
+    radio1.AttachRds(&rds1);
+    radio3.AttachRds(&rds3);
+    radio1.SetRds(true);
+    radio3.SetRds(true);
+    radio1.SetSignalPoll(100);
+    radio2.SetSignalPoll(100);
+    radio3.SetSignalPoll(100);
+    
+    objIccBus busMgr;
+    busMgr.Insert(&radio1, 4);
+    busMgr.Insert(&radio2, 1);
+    busMgr.Insert(&radio3, 4);
+    radio1.Init(0x10);
+    radio2.Init(0x60);
+    radio3.Init(0x10);
+    for (U16 ms=0; ms<2000; ms++)
+    {
+        busMgr.Tick();
+        HostAdvance(1000);
+    }
+    
+    /* 10 s simulated, main loop every 1 ms plus bus time */
+    busMgr.ClearStats();
+    Wire.ClearStats();
+    Wire1.ClearStats();
+    uint64_t usStart = HostMicros();
+    for (U16 ms=0; ms<10000; ms++)
+    {
+        if ((ms % 88) == 0)
+        {
+            chip1.PushRds(0x0000, 0x0000, 0x0000);
+            chip3.PushRds(0x0000, 0x0000, 0x0000);
+        }
+        busMgr.Tick();
+        HostAdvance(1000);
+    }
+    U32 msRun = (U32)((HostMicros() - usStart) / 1000);
+    U32 busLoad0 = (U32)(Wire.GetStats()->usBusy / (10 * msRun));
+    U32 busLoad1 = (U32)(Wire1.GetStats()->usBusy / (10 * msRun));
+    printf("  3 tuners, 2 buses: %u trans/s (%u/%u/%u in %u ms), bus load %u%%/%u%%\n",
+           busMgr.GetThroughput(), busMgr.GetTrans(&radio1), busMgr.GetTrans(&radio2),
+           busMgr.GetTrans(&radio3), msRun, busLoad0, busLoad1);
+    TEST_EQUAL(rds1.GetPI(), 0xD311);
+    TEST_EQUAL(rds3.GetPI(), 0xD3C2);
+    TEST_CHECK(busMgr.GetTrans(&radio2) >= 90);
+    TEST_CHECK(busMgr.GetThroughput() > 0);
+    
+    /* Worst case: saturated devices, 4 byte writes on both buses */
+    fakeLoad load[4];
+    Wire.DetachAll();
+    Wire1.DetachAll();
+    objIccBus loadMgr;
+    for (U8 i=0; i<4; i++)
+    {
+        load[i].SetAddr(0x70 + i, 4);
+        if (i >= 2)
+            load[i].SetBus(&wire1Bus);
+        Wire.Attach(0x70 + i, &load[i]);
+        Wire1.Attach(0x70 + i, &load[i]);
+        loadMgr.Insert(&load[i], 1);
+    }
+    loadMgr.ClearStats();
+    usStart = HostMicros();
+    while ((HostMicros() - usStart) < 1000000)
+    {
+        loadMgr.Tick();
+    }
+    printf("  saturated, 2 buses: %u trans/s (one CPU, buses not overlapped)\n",
+           loadMgr.GetThroughput());
+    TEST_CHECK(loadMgr.GetThroughput() > 1000);
+}
+
+//------------------------------------------------------------------------------
+// DHT12 on Wire1: "Init()" starts its bus, "ReadData()" without "Tick()"
+// reads blocking, with "Tick()" only the cached reading
+//------------------------------------------------------------------------------
+static void testSensorBus(void)
+{
+    fakeDht12 dht;
+    Wire.DetachAll();
+    Wire1.DetachAll();
+    Wire1.Attach(TEMP_I2C_ADDR, &dht);
+    
+    iccWire wire1Bus(&Wire1);
+    objTempera sensor;
+    sensor.SetBus(&wire1Bus);
+    Wire.ClearStats();
+    Wire1.ClearStats();
+    TEST_CHECK(sensor.Init(0));
+    TEST_EQUAL(Wire.GetStats()->beginCnt, 0);
+    TEST_EQUAL(Wire1.GetStats()->beginCnt, 1);
+    
+    /* Blocking: trigger, TEMP_CONV_MS, collect */
+    uint64_t usStart = HostMicros();
+    TEST_CHECK(sensor.ReadData());
+    TEST_CHECK(HostMicros() - usStart >= TEMP_CONV_MS * 1000);
+    TEST_EQUAL(sensor.Temperatur(), 215);
+    dht.SetValue(-55, 300);
+    TEST_CHECK(sensor.ReadData());
+    TEST_EQUAL(sensor.Temperatur(), -55);
+    TEST_EQUAL(dht.GetReads(), 2);
+    dht.SetFail(true);
+    TEST_CHECK(!sensor.ReadData());
+    dht.SetFail(false);
+    
+    /* Sampler running: no bus access, TRUE once per reading */
+    dht.SetValue(230, 400);
+    for (U32 ms=0; ms<=TEMP_CONV_MS; ms++)
+    {
+        sensor.Tick();
+        HostAdvance(1000);
+    }
+    U32 trStart = wireTrans(&Wire1);
+    TEST_CHECK(sensor.ReadData());
+    TEST_CHECK(!sensor.ReadData());
+    TEST_EQUAL(wireTrans(&Wire1), trStart);
+    TEST_EQUAL(sensor.Temperatur(), 230);
+}
+
+//------------------------------------------------------------------------------
+// Sensor group as objIccBus device: bus of the sensor of the next "Tick()"
+//------------------------------------------------------------------------------
+static void testGroupBus(void)
+{
+    fakeRda5807m chip;
+    fakeDht12 dht;
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    Wire.Attach(TEMP_I2C_ADDR, &dht);
+    
+    objRadioT<radioRda5807m> radio;
+    objTempera sensor;
+    objTempGroup group;
+    TEST_CHECK(group.GetBus() == NULL);
+    
+    /* Group inserted while empty, bus is read in every "Tick()" */
+    objIccBus busMgr;
+    TEST_CHECK(busMgr.Insert(&radio, 4));
+    TEST_CHECK(busMgr.Insert(&group, 1));
+    TEST_CHECK(sensor.Init(0));
+    TEST_CHECK(group.Insert(&sensor));
+    TEST_CHECK(group.GetBus() == sensor.GetBus());
+    group.SetPeriod(TEMP_PERIOD_MIN);
+    radio.Init(0x10);
+    
+    U32 maxPerTick = 0;
+    for (U32 ms=0; ms<5000; ms++)
+    {
+        U32 trStart = wireTrans(&Wire);
+        busMgr.Tick();
+        U32 trTick = wireTrans(&Wire) - trStart;
+        if (trTick > maxPerTick)
+            maxPerTick = trTick;
+        HostAdvance(1000);
+    }
+    TEST_EQUAL(maxPerTick, 1);
+    TEST_CHECK(!group.Stale(0));
+    TEST_EQUAL(sensor.Temperatur(), 215);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+}
+
+//------------------------------------------------------------------------------
+// Group on two buses: one sensor per tick, backoff 1/3/7 periods, stale
+//------------------------------------------------------------------------------
+static void testGroupStagger(void)
+{
+    fakeRda5807m chip;
+    fakeDht12 dhtA;
+    fakeDht12 dhtB;
+    fakeDht12 dhtC;
+    fakeLoad load;
+    Wire.DetachAll();
+    Wire1.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    Wire.Attach(TEMP_I2C_ADDR, &dhtA);
+    Wire.Attach(TEMP_I2C_ADDR + 1, &dhtB);
+    Wire1.Attach(TEMP_I2C_ADDR, &dhtC);
+    Wire1.Attach(0x70, &load);
+    
+    /* A and B on "Wire", C on "Wire1" (saturated by a load device) */
+    iccWire wire1Bus(&Wire1);
+    objTempera sensorA;
+    objTempera sensorB;
+    objTempera sensorC;
+    sensorC.SetBus(&wire1Bus);
+    load.SetBus(&wire1Bus);
+    TEST_CHECK(sensorA.Init(0));
+    TEST_CHECK(sensorB.Init(TEMP_I2C_ADDR + 1));
+    TEST_CHECK(sensorC.Init(0));
+    dhtC.SetValue(-42, 600);
+    
+    objTempGroup group;
+    TEST_CHECK(group.Insert(&sensorA));
+    TEST_CHECK(group.Insert(&sensorB));
+    TEST_CHECK(group.Insert(&sensorC));
+    group.SetPeriod(TEMP_PERIOD_MIN);
+    
+    objRadioT<radioRda5807m> radio;
+    objIccBus busMgr;
+    TEST_CHECK(busMgr.Insert(&radio, 4));
+    TEST_CHECK(busMgr.Insert(&group, 1));
+    TEST_CHECK(busMgr.Insert(&load, 1));
+    radio.Init(0x10);
+    
+    /* 16 rounds, B fails: tried in round 0, 2, 6 and 14 */
+    dhtB.SetFail(true);
+    U32 maxWire = 0;
+    U32 maxWire1 = 0;
+    U8 roundCnt = 0;
+    U16 triedMask = 0;
+    U8 lastFail = 0;
+    while (roundCnt < 16)
+    {
+        U32 trWire = wireTrans(&Wire);
+        U32 trWire1 = wireTrans(&Wire1);
+        busMgr.Tick();
+        trWire = wireTrans(&Wire) - trWire;
+        trWire1 = wireTrans(&Wire1) - trWire1;
+        if (trWire > maxWire)
+            maxWire = trWire;
+        if (trWire1 > maxWire1)
+            maxWire1 = trWire1;
+        if (group.RoundDone())
+        {
+            if (group.GetFailures(1) != lastFail)
+                triedMask |= (U16)(1 << roundCnt);
+            lastFail = group.GetFailures(1);
+            roundCnt++;
+        }
+        HostAdvance(1000);
+    }
+    TEST_EQUAL(maxWire, 1);
+    TEST_EQUAL(maxWire1, 1);
+    TEST_EQUAL(triedMask, (1 << 0) | (1 << 2) | (1 << 6) | (1 << 14));
+    TEST_EQUAL(group.GetFailures(0), 0);
+    TEST_EQUAL(group.GetFailures(1), 4);
+    TEST_EQUAL(group.GetFailures(2), 0);
+    TEST_EQUAL(dhtA.GetReads(), 16);
+    TEST_EQUAL(dhtC.GetReads(), 16);
+    TEST_EQUAL(sensorA.Temperatur(), 215);
+    TEST_EQUAL(sensorC.Temperatur(), -42);
+    TEST_CHECK(!group.Stale(0));
+    TEST_CHECK(group.Stale(1));
+    TEST_CHECK(!group.Stale(2));
+    
+    /* C fails: stale after TEMPG_STALE_CNT periods, A stays fresh */
+    dhtC.SetFail(true);
+    for (U32 ms=0; ms<2UL*TEMP_PERIOD_MIN; ms++)
+    {
+        busMgr.Tick();
+        HostAdvance(1000);
+    }
+    TEST_CHECK(!group.Stale(2));
+    for (U32 ms=0; ms<2UL*TEMP_PERIOD_MIN; ms++)
+    {
+        busMgr.Tick();
+        HostAdvance(1000);
+    }
+    TEST_CHECK(group.Stale(2));
+    TEST_CHECK(!group.Stale(0));
+    TEST_CHECK(group.GetFailures(2) > 0);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testSharedBus();
+    testSensorBus();
+    testGroupBus();
+    testGroupStagger();
+    testPriority();
+    testThroughput();
+    return TestResult("testIccBus");
+}
+
+// END OF testIccBus.cpp
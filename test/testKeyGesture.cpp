@@ -0,0 +1,263 @@
+//------------------------------------------------------------------------------
+// File...: testKeyGesture.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objKey gestures from synthetic timestamped edges ("KeyEdge()")
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objKey.h"
+#include "testHost.h"
+
+#define LOG_MAX       64
+
+/* Event log (drained after every tick) */
+static keyEvent evLog[LOG_MAX];
+static U8 evCnt = 0;
+
+static void drain(objKey *pKey)
+{
+    keyEvent ev;
+    while (pKey->GetEvent(&ev))
+    {
+        if (evCnt < LOG_MAX)
+            evLog[evCnt++] = ev;
+    }
+}
+
+/* Run "Tick()" for "msTime" in 1 ms steps */
+static void run(objKey *pKey, U32 msTime)
+{
+    for (U32 t=0; t<msTime; t++)
+    {
+        HostAdvance(1000);
+        pKey->Tick();
+        drain(pKey);
+    }
+}
+
+static void edge(objKey *pKey, U8 keyIndex, bool bDown)
+{
+    pKey->KeyEdge(keyIndex, bDown, (U16)millis());
+    drain(pKey);
+}
+
+/* Number of events of the type (keyIndex 0 = any key) */
+static U8 count(U8 keyIndex, U8 evType)
+{
+    U8 cnt = 0;
+    for (U8 i=0; i<evCnt; i++)
+    {
+        if ((evLog[i].keyEvent == evType) &&
+            ((keyIndex == 0) || (evLog[i].keyIndex == keyIndex)))
+            cnt++;
+    }
+    return cnt;
+}
+
+/* Index of the n-th event of the type, LOG_MAX if none */
+static U8 find(U8 evType, U8 n)
+{
+    for (U8 i=0; i<evCnt; i++)
+    {
+        if ((evLog[i].keyEvent == evType) && (n-- == 0))
+            return i;
+    }
+    return LOG_MAX;
+}
+
+//------------------------------------------------------------------------------
+// Profiles: repeat interval only checked against the minimum with repeat
+//------------------------------------------------------------------------------
+static void testProfile(objKey *pKey)
+{
+    keyProfile prof = { 500, 0, 0, 50, 0 };
+    TEST_CHECK(pKey->SetProfile(1, &prof));
+    prof.msRepeat = 30;
+    TEST_CHECK(!pKey->SetProfile(1, &prof));
+    prof.msRepeat = 50;
+    TEST_CHECK(pKey->SetProfile(1, &prof));
+    TEST_CHECK(!pKey->SetProfile(KEY_PROFILE_CNT, &prof));
+    TEST_CHECK(pKey->SetGesture(KEY_CNT_MAX, 1));
+    TEST_CHECK(!pKey->SetGesture(0, 1));
+    TEST_CHECK(!pKey->SetGesture(1, KEY_PROFILE_CNT));
+    TEST_CHECK(pKey->SetGesture(KEY_CNT_MAX, 0));
+}
+
+//------------------------------------------------------------------------------
+// Default profile: click, long press, accelerated repeat
+//------------------------------------------------------------------------------
+static void testLongRepeat(objKey *pKey)
+{
+    /* Short press: PRESS, RELEASE, CLICK at once */
+    evCnt = 0;
+    edge(pKey, 1, true);
+    run(pKey, 100);
+    edge(pKey, 1, false);
+    run(pKey, 20);
+    TEST_EQUAL(evCnt, 3);
+    TEST_EQUAL(evLog[0].keyEvent, KEY_EV_PRESS);
+    TEST_EQUAL(evLog[1].keyEvent, KEY_EV_RELEASE);
+    TEST_EQUAL(evLog[2].keyEvent, KEY_EV_CLICK);
+    TEST_EQUAL(evLog[2].keyIndex, 1);
+
+    /* Hold 2 s: LONG after 800 ms, then repeats from 200 ms accelerated */
+    evCnt = 0;
+    U16 msPress = (U16)millis();
+    edge(pKey, 2, true);
+    run(pKey, 2000);
+    edge(pKey, 2, false);
+    run(pKey, 20);
+    U8 iLong = find(KEY_EV_LONG, 0);
+    TEST_CHECK(iLong < LOG_MAX);
+    U16 msLong = (U16)(evLog[iLong].keyTime - msPress);
+    TEST_CHECK((msLong >= KEY_LONG_MS) && (msLong < KEY_LONG_MS + KEY_TICK_MS));
+    U8 repCnt = count(2, KEY_EV_REPEAT);
+    TEST_CHECK(repCnt >= 6);
+    U16 msLast = evLog[iLong].keyTime;
+    U16 msGap = 0xFFFF;
+    for (U8 r=0; r<repCnt; r++)
+    {
+        U16 msTime = evLog[find(KEY_EV_REPEAT, r)].keyTime;
+        U16 msDiff = msTime - msLast;
+        if (r == 0)
+            TEST_CHECK((msDiff >= KEY_REPEAT_MS) && (msDiff < KEY_REPEAT_MS + KEY_TICK_MS));
+        TEST_CHECK(msDiff <= msGap);
+        TEST_CHECK(msDiff + KEY_TICK_MS > KEY_REPEAT_MIN_MS);
+        msGap = msDiff;
+        msLast = msTime;
+    }
+    TEST_CHECK(msGap < KEY_REPEAT_MS);
+    TEST_EQUAL(count(2, KEY_EV_CLICK), 0);
+    TEST_EQUAL(count(2, KEY_EV_RELEASE), 1);
+}
+
+//------------------------------------------------------------------------------
+// Profile without repeat: only LONG, also when held over U16 wrap
+//------------------------------------------------------------------------------
+static void testNoRepeat(objKey *pKey)
+{
+    keyProfile prof = { 500, 0, 0, 50, 0 };
+    TEST_CHECK(pKey->SetProfile(1, &prof));
+    TEST_CHECK(pKey->SetGesture(3, 1));
+    evCnt = 0;
+    edge(pKey, 3, true);
+    run(pKey, 140000);
+    edge(pKey, 3, false);
+    run(pKey, 20);
+    TEST_EQUAL(count(3, KEY_EV_LONG), 1);
+    TEST_EQUAL(count(3, KEY_EV_REPEAT), 0);
+    TEST_EQUAL(count(3, KEY_EV_CLICK), 0);
+    TEST_CHECK(pKey->SetGesture(3, 0));
+}
+
+//------------------------------------------------------------------------------
+// Double click: second click within "msDouble", single click after timeout
+//------------------------------------------------------------------------------
+static void testDouble(objKey *pKey)
+{
+    keyProfile prof = { 800, 300, 200, 50, 32 };
+    TEST_CHECK(pKey->SetProfile(2, &prof));
+    TEST_CHECK(pKey->SetGesture(4, 2));
+
+    evCnt = 0;
+    edge(pKey, 4, true);
+    run(pKey, 80);
+    edge(pKey, 4, false);
+    run(pKey, 150);
+    TEST_EQUAL(count(4, KEY_EV_CLICK), 0);
+    edge(pKey, 4, true);
+    run(pKey, 80);
+    edge(pKey, 4, false);
+    run(pKey, 400);
+    TEST_EQUAL(count(4, KEY_EV_DOUBLE), 1);
+    TEST_EQUAL(count(4, KEY_EV_CLICK), 0);
+
+    /* Single click: CLICK with the release time after "msDouble" */
+    evCnt = 0;
+    edge(pKey, 4, true);
+    run(pKey, 80);
+    U16 msRelease = (U16)millis();
+    edge(pKey, 4, false);
+    run(pKey, 200);
+    TEST_EQUAL(count(4, KEY_EV_CLICK), 0);
+    run(pKey, 150);
+    TEST_EQUAL(count(4, KEY_EV_CLICK), 1);
+    TEST_EQUAL(evLog[find(KEY_EV_CLICK, 0)].keyTime, msRelease);
+    TEST_EQUAL(count(4, KEY_EV_DOUBLE), 0);
+}
+
+//------------------------------------------------------------------------------
+// Chords: keys within KEY_CHORD_MS, no further gestures of their keys
+//------------------------------------------------------------------------------
+static void testChord(objKey *pKey)
+{
+    const U8 chordKeys[2] = { 5, 6 };
+    TEST_CHECK(pKey->SetChord(1, chordKeys, 2));
+    TEST_CHECK(!pKey->SetChord(1, chordKeys, 1));
+    TEST_CHECK(!pKey->SetChord(KEY_CHORD_MAX + 1, chordKeys, 2));
+
+    evCnt = 0;
+    edge(pKey, 5, true);
+    run(pKey, 60);
+    edge(pKey, 6, true);
+    run(pKey, 1500);
+    edge(pKey, 5, false);
+    edge(pKey, 6, false);
+    run(pKey, 20);
+    TEST_EQUAL(count(1, KEY_EV_CHORD), 1);
+    TEST_EQUAL(count(0, KEY_EV_LONG), 0);
+    TEST_EQUAL(count(0, KEY_EV_REPEAT), 0);
+    TEST_EQUAL(count(0, KEY_EV_CLICK), 0);
+    TEST_EQUAL(count(0, KEY_EV_RELEASE), 2);
+
+    /* Too slow: no chord, both keys single clicks */
+    evCnt = 0;
+    edge(pKey, 5, true);
+    run(pKey, KEY_CHORD_MS + 50);
+    edge(pKey, 6, true);
+    run(pKey, 50);
+    edge(pKey, 5, false);
+    edge(pKey, 6, false);
+    run(pKey, 20);
+    TEST_EQUAL(count(0, KEY_EV_CHORD), 0);
+    TEST_EQUAL(count(5, KEY_EV_CLICK), 1);
+    TEST_EQUAL(count(6, KEY_EV_CLICK), 1);
+    TEST_CHECK(pKey->SetChord(1, NULL, 0));
+}
+
+//------------------------------------------------------------------------------
+// Fixed memory: more than KEY_ACTIVE_MAX keys held -> edges only
+//------------------------------------------------------------------------------
+static void testActiveMax(objKey *pKey)
+{
+    evCnt = 0;
+    for (U8 k=1; k<=KEY_ACTIVE_MAX + 1; k++)
+        edge(pKey, k, true);
+    run(pKey, KEY_LONG_MS + 20);
+    for (U8 k=1; k<=KEY_ACTIVE_MAX + 1; k++)
+        edge(pKey, k, false);
+    run(pKey, 20);
+    TEST_EQUAL(count(0, KEY_EV_PRESS), KEY_ACTIVE_MAX + 1);
+    TEST_EQUAL(count(0, KEY_EV_RELEASE), KEY_ACTIVE_MAX + 1);
+    TEST_EQUAL(count(0, KEY_EV_LONG), KEY_ACTIVE_MAX);
+    TEST_EQUAL(count(KEY_ACTIVE_MAX + 1, KEY_EV_LONG), 0);
+    TEST_EQUAL(pKey->GetLostEvents(), 0);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    objKey keys;
+    run(&keys, 10);
+
+    testProfile(&keys);
+    testLongRepeat(&keys);
+    testNoRepeat(&keys);
+    testDouble(&keys);
+    testChord(&keys);
+    testActiveMax(&keys);
+    return TestResult("testKeyGesture");
+}
+
+// END OF testKeyGesture.cpp
@@ -0,0 +1,197 @@
+//------------------------------------------------------------------------------
+// File...: testKeyMatrix.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objKey 4 x 4 matrix (built with KEY_MATRIX_ROWS/COLS = 4), row
+// sequence, debounce and ghost keys on a simulated switch matrix
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objKey.h"
+#include "testHost.h"
+
+#if (KEY_MATRIX_ROWS != 4) || (KEY_MATRIX_COLS != 4)
+  #error "testKeyMatrix: build with -DKEY_MATRIX_ROWS=4 -DKEY_MATRIX_COLS=4"
+#endif
+
+#define MX_ROWS        4
+#define MX_COLS        4
+#define SEQ_MAX       16
+
+static const U8 rowPins[MX_ROWS] = { 20, 21, 22, 23 };
+static const U8 colPins[MX_COLS] = { 24, 25, 26, 27 };
+
+/* Switch matrix: pressed keys, driven row (last row written LOW) */
+static bool keyDown[MX_ROWS][MX_COLS];
+static S8 rowDriven = -1;
+
+/* Driven rows in order */
+static U8 rowSeq[SEQ_MAX];
+static U8 seqCnt = 0;
+
+/* Columns connected to the driven row (also over open rows -> ghosts) */
+static void updateCols(void)
+{
+    bool rowReach[MX_ROWS] = { false };
+    bool colReach[MX_COLS] = { false };
+    if (rowDriven >= 0)
+        rowReach[rowDriven] = true;
+    for (bool bMore = true; bMore; )
+    {
+        bMore = false;
+        for (U8 r=0; r<MX_ROWS; r++)
+        {
+            for (U8 c=0; c<MX_COLS; c++)
+            {
+                if (keyDown[r][c] && (rowReach[r] != colReach[c]))
+                {
+                    rowReach[r] = true;
+                    colReach[c] = true;
+                    bMore = true;
+                }
+            }
+        }
+    }
+    for (U8 c=0; c<MX_COLS; c++)
+        HostPinSet(colPins[c], colReach[c] ? LOW : HIGH);
+}
+
+static void onPin(uint8_t pin, uint8_t val)
+{
+    for (U8 r=0; r<MX_ROWS; r++)
+    {
+        if ((pin == rowPins[r]) && (val == LOW))
+        {
+            rowDriven = r;
+            if (seqCnt < SEQ_MAX)
+                rowSeq[seqCnt++] = r;
+        }
+    }
+    updateCols();
+}
+
+static void press(U8 row, U8 col, bool bDown)
+{
+    keyDown[row][col] = bDown;
+    updateCols();
+}
+
+/* Run "Tick()" for "msTime" in 1 ms steps */
+static void run(objKey *pKey, U32 msTime)
+{
+    for (U32 t=0; t<msTime; t++)
+    {
+        HostAdvance(1000);
+        pKey->Tick();
+    }
+}
+
+/* Number of events of the key and type, queue drained */
+static U8 events(objKey *pKey, U8 keyIndex, U8 evType, U16 *pTime)
+{
+    U8 cnt = 0;
+    keyEvent ev;
+    while (pKey->GetEvent(&ev))
+    {
+        if ((ev.keyIndex == keyIndex) && (ev.keyEvent == evType))
+        {
+            cnt++;
+            if (pTime != NULL)
+                *pTime = ev.keyTime;
+        }
+    }
+    return cnt;
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    HostPinHook(onPin);
+    objKey keys;
+    const U8 rowPins5[5] = { 20, 21, 22, 23, 28 };
+    TEST_CHECK(!keys.InsertMatrix(rowPins5, 5, colPins, MX_COLS));
+    TEST_CHECK(keys.InsertMatrix(rowPins, MX_ROWS, colPins, MX_COLS));
+    TEST_CHECK(!keys.InsertMatrix(rowPins, MX_ROWS, colPins, MX_COLS));
+    TEST_EQUAL(objKey::MatrixKey(3, 3), KEY_CNT_MAX + MX_ROWS * MX_COLS);
+
+    /* Row sequence: one row per KEY_MATRIX_TICK_MS, round robin */
+    run(&keys, 2 * MX_ROWS * KEY_MATRIX_TICK_MS);
+    TEST_EQUAL(seqCnt, 1 + 2 * MX_ROWS);
+    bool bSeq = true;
+    for (U8 i=0; i<seqCnt; i++)
+        bSeq &= (rowSeq[i] == (i % MX_ROWS));
+    TEST_CHECK(bSeq);
+
+    /* Bounce shorter than 4 scans: no change */
+    U8 msScan = MX_ROWS * KEY_MATRIX_TICK_MS;
+    press(1, 2, true);
+    run(&keys, 2 * msScan);
+    press(1, 2, false);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(1, 2)));
+    TEST_EQUAL(events(&keys, objKey::MatrixKey(1, 2), KEY_EV_PRESS, NULL), 0);
+
+    /* Stable for 4 scans: press, event time = first scan LOW */
+    U16 msPress = (U16)millis();
+    press(1, 2, true);
+    run(&keys, 3 * msScan);
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(1, 2)));
+    run(&keys, msScan);
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(1, 2)));
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(2, 1)));
+    U16 msEvent = 0;
+    TEST_EQUAL(events(&keys, objKey::MatrixKey(1, 2), KEY_EV_PRESS, &msEvent), 1);
+    TEST_CHECK((U16)(msEvent - msPress) <= msScan);
+
+    /* Release: latched once */
+    press(1, 2, false);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(1, 2)));
+    TEST_CHECK(keys.KeyPressed(objKey::MatrixKey(1, 2)));
+    TEST_CHECK(!keys.KeyPressed(objKey::MatrixKey(1, 2)));
+    TEST_EQUAL(events(&keys, objKey::MatrixKey(1, 2), KEY_EV_RELEASE, NULL), 1);
+
+    /* Two keys in a row, then in a column: no ghost */
+    press(2, 0, true);
+    press(2, 3, true);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(2, 0)));
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(2, 3)));
+    press(2, 0, false);
+    press(3, 3, true);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(2, 0)));
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(2, 3)));
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(3, 3)));
+    TEST_EQUAL(keys.GetGhosts(), 0);
+    press(2, 3, false);
+    press(3, 3, false);
+    run(&keys, 4 * msScan);
+    events(&keys, 0, 0, NULL);
+
+    /* Third corner of a rectangle: the fourth reads as pressed too */
+    /* -> rows with two common columns keep their state */
+    press(0, 0, true);
+    press(0, 1, true);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(0, 0)));
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(0, 1)));
+    press(1, 0, true);
+    run(&keys, 8 * msScan);
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(0, 0)));
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(0, 1)));
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(1, 0)));
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(1, 1)));
+    TEST_CHECK(keys.GetGhosts() > 0);
+
+    /* Rectangle resolved: the real key follows, never the ghost */
+    press(0, 1, false);
+    run(&keys, 4 * msScan);
+    TEST_CHECK(keys.KeyDown(objKey::MatrixKey(1, 0)));
+    TEST_CHECK(!keys.KeyDown(objKey::MatrixKey(0, 1)));
+    TEST_EQUAL(events(&keys, objKey::MatrixKey(1, 1), KEY_EV_PRESS, NULL), 0);
+
+    return TestResult("testKeyMatrix");
+}
+
+// END OF testKeyMatrix.cpp
@@ -0,0 +1,219 @@
+//------------------------------------------------------------------------------
+// File...: testKeyTick.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objKey vertical counter debounce, cycles per sample tick
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objKey.h"
+#include "testHost.h"
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define HOST_CYCLES()  __rdtsc()
+#endif
+
+#define KEY_PIN(k)     (2 + (k))     // Key 1..16 on pins 3..18
+#define BENCH_LOOPS    1000000
+
+static volatile U32 benchSink = 0;
+
+static double wallNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* One sample tick of objKey */
+static void sample(objKey *pKey)
+{
+    HostAdvance(KEY_TICK_MS * 1000);
+    pKey->Tick();
+}
+
+//------------------------------------------------------------------------------
+// Previous debounce for comparison: one counter per key, a branch per key
+//------------------------------------------------------------------------------
+static U8 seqDown[KEY_CNT_MAX];
+static U8 seqBounce[KEY_CNT_MAX];
+
+static U32 seqDebounce(keyMask rawDown)
+{
+    U32 evCnt = 0;
+    for (U8 i=0; i<KEY_CNT_MAX; i++)
+    {
+        U8 bDown = (rawDown >> i) & 1;
+        if (bDown == seqDown[i])
+        {
+            seqBounce[i] = 0;
+        }
+        else if (++seqBounce[i] >= (KEY_DEBOUNCE_MS / KEY_TICK_MS))
+        {
+            seqBounce[i] = 0;
+            seqDown[i] = bDown;
+            evCnt++;
+        }
+    }
+    return evCnt;
+}
+
+/* Vertical counter as in "objKey::Tick()" */
+static keyMask vcState = 0;
+static keyMask vcCnt0 = (keyMask)~0;
+static keyMask vcCnt1 = (keyMask)~0;
+
+static keyMask vcDebounce(keyMask rawDown)
+{
+    keyMask keyDiff = rawDown ^ vcState;
+    vcCnt0 = ~(vcCnt0 & keyDiff);
+    vcCnt1 = vcCnt0 ^ (vcCnt1 & keyDiff);
+    keyMask keyToggle = keyDiff & vcCnt0 & vcCnt1;
+    vcState ^= keyToggle;
+    return keyToggle;
+}
+
+/* Noisy input pattern (xorshift), some keys stable */
+static keyMask rawPattern[256];
+
+static void makePattern(void)
+{
+    U32 x = 2463534242UL;
+    for (U16 i=0; i<256; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        rawPattern[i] = (keyMask)(x & 0x0F0F);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Cost of the debounce per sample: vertical counter vs. counter per key
+//------------------------------------------------------------------------------
+static void benchDebounce(void)
+{
+    makePattern();
+
+    /* Both algorithms agree on the debounced state */
+    for (U32 n=0; n<4096; n++)
+    {
+        keyMask rawDown = rawPattern[(n >> 2) & 0xFF];
+        seqDebounce(rawDown);
+        vcDebounce(rawDown);
+    }
+    keyMask seqState = 0;
+    for (U8 i=0; i<KEY_CNT_MAX; i++)
+        seqState |= (keyMask)seqDown[i] << i;
+    TEST_EQUAL(vcState, seqState);
+
+    double ns = wallNs();
+#ifdef HOST_CYCLES
+    uint64_t cyc = HOST_CYCLES();
+#endif
+    for (U32 n=0; n<BENCH_LOOPS; n++)
+        benchSink += seqDebounce(rawPattern[n & 0xFF]);
+    double nsSeq = (wallNs() - ns) / BENCH_LOOPS;
+#ifdef HOST_CYCLES
+    double cycSeq = (double)(HOST_CYCLES() - cyc) / BENCH_LOOPS;
+    cyc = HOST_CYCLES();
+#endif
+    ns = wallNs();
+    for (U32 n=0; n<BENCH_LOOPS; n++)
+        benchSink += vcDebounce(rawPattern[n & 0xFF]);
+    double nsVc = (wallNs() - ns) / BENCH_LOOPS;
+#ifdef HOST_CYCLES
+    double cycVc = (double)(HOST_CYCLES() - cyc) / BENCH_LOOPS;
+    printf("  %u keys, debounce per sample: counter per key %.1f ns (%.0f TSC cycles), "
+           "vertical counter %.1f ns (%.0f TSC cycles)\n", KEY_CNT_MAX,
+           nsSeq, cycSeq, nsVc, cycVc);
+#else
+    printf("  %u keys, debounce per sample: counter per key %.1f ns, "
+           "vertical counter %.1f ns\n", KEY_CNT_MAX, nsSeq, nsVc);
+#endif
+    TEST_CHECK(nsVc < nsSeq);
+}
+
+//------------------------------------------------------------------------------
+// Host cost of "Tick()": idle call and sample tick (incl. pin reads)
+//------------------------------------------------------------------------------
+static void benchTick(objKey *pKey)
+{
+    double ns = wallNs();
+    for (U32 n=0; n<BENCH_LOOPS; n++)
+        HostAdvance(KEY_TICK_MS * 1000);
+    double nsBase = (wallNs() - ns) / BENCH_LOOPS;
+
+    ns = wallNs();
+    for (U32 n=0; n<BENCH_LOOPS; n++)
+        sample(pKey);
+    double nsSample = (wallNs() - ns) / BENCH_LOOPS - nsBase;
+
+    ns = wallNs();
+    for (U32 n=0; n<BENCH_LOOPS; n++)
+        pKey->Tick();
+    double nsIdle = (wallNs() - ns) / BENCH_LOOPS;
+    printf("  Tick(): sample %.1f ns (%u pin reads on host), idle %.1f ns\n",
+           nsSample, KEY_CNT_MAX, nsIdle);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    objKey keys;
+    for (U8 k=1; k<=KEY_CNT_MAX; k++)
+        TEST_CHECK(keys.Insert(KEY_PIN(k)));
+    TEST_CHECK(!keys.Insert(KEY_PIN(KEY_CNT_MAX + 1)));
+    sample(&keys);
+
+    /* Bounce shorter than the debounce time: no change */
+    HostPinSet(KEY_PIN(3), LOW);
+    sample(&keys);
+    sample(&keys);
+    HostPinSet(KEY_PIN(3), HIGH);
+    sample(&keys);
+    sample(&keys);
+    sample(&keys);
+    sample(&keys);
+    TEST_CHECK(!keys.KeyDown(3));
+    keyEvent ev;
+    TEST_CHECK(!keys.GetEvent(&ev));
+
+    /* Stable for 4 samples: press, event time = first sample LOW */
+    U16 msPress = (U16)(millis() + KEY_TICK_MS);
+    HostPinSet(KEY_PIN(3), LOW);
+    HostPinSet(KEY_PIN(16), LOW);
+    for (U8 i=0; i<4; i++)
+    {
+        TEST_CHECK(!keys.KeyDown(3));
+        sample(&keys);
+    }
+    TEST_CHECK(keys.KeyDown(3));
+    TEST_CHECK(keys.KeyDown(16));
+    TEST_CHECK(!keys.KeyDown(4));
+    TEST_CHECK(keys.GetEvent(&ev));
+    TEST_EQUAL(ev.keyIndex, 3);
+    TEST_EQUAL(ev.keyEvent, KEY_EV_PRESS);
+    TEST_EQUAL(ev.keyTime, msPress);
+    TEST_CHECK(keys.GetEvent(&ev));
+    TEST_EQUAL(ev.keyIndex, 16);
+
+    /* Release: latched once */
+    HostPinSet(KEY_PIN(3), HIGH);
+    HostPinSet(KEY_PIN(16), HIGH);
+    for (U8 i=0; i<4; i++)
+        sample(&keys);
+    TEST_CHECK(!keys.KeyDown(3));
+    TEST_CHECK(keys.KeyPressed(3));
+    TEST_CHECK(!keys.KeyPressed(3));
+    TEST_CHECK(keys.KeyPressed(16));
+    while (keys.GetEvent(&ev))
+        ;
+
+    benchDebounce();
+    benchTick(&keys);
+    return TestResult("testKeyTick");
+}
+
+// END OF testKeyTick.cpp
@@ -0,0 +1,212 @@
+//------------------------------------------------------------------------------
+// File...: testRadioBus.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objRadio transaction engine on the fake bus, latency per call
+//------------------------------------------------------------------------------
+#include <time.h>
+#include "Arduino.h"
+#include "Wire.h"
+#include "../objRadio.h"
+#include "fakeRadio.h"
+#include "testHost.h"
+
+static U8 doneType = 0;
+static U8 doneArg = 0;
+static U32 doneCnt = 0;
+
+static void onDone(U8 trType, U8 trArg)
+{
+    doneType = trType;
+    doneArg = trArg;
+    doneCnt++;
+}
+
+static double wallNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Tick every ms until ready, return power-up time [ms], max. bus time per call */
+template <class RADIO>
+static U32 powerUp(RADIO *pRadio, U32 *usMaxCall)
+{
+    uint64_t usStart = HostMicros();
+    *usMaxCall = 0;
+    for (U16 i=0; (i<2000) && (pRadio->GetState() != RADIO_STATE_READY); i++)
+    {
+        uint64_t usCall = HostMicros();
+        pRadio->Tick();
+        U32 usBus = (U32)(HostMicros() - usCall);
+        if (usBus > *usMaxCall)
+            *usMaxCall = usBus;
+        HostAdvance(1000);
+    }
+    return (U32)((HostMicros() - usStart) / 1000);
+}
+
+//------------------------------------------------------------------------------
+static void testRda(void)
+{
+    fakeRda5807m chip;
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    Wire.ClearStats();
+    
+    objRadioT<radioRda5807m> radio;
+    uint64_t usInit = HostMicros();
+    radio.Init(0x10);
+    TEST_EQUAL(HostMicros() - usInit, 0);                 // Init() does not block
+    TEST_EQUAL(Wire.GetStats()->wrTrans, 0);
+    TEST_CHECK(radio.IsBusy());
+    
+    U32 usMaxCall = 0;
+    U32 msPower = powerUp(&radio, &usMaxCall);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+    TEST_CHECK(msPower >= 610);
+    TEST_CHECK(usMaxCall < 1000);                          // One 8 byte burst max.
+    TEST_EQUAL(chip.GetResets(), 1);
+    TEST_EQUAL(chip.GetTuned(), RADIO_FDEF);
+    printf("  RDA5807M power-up %u ms simulated, max. %u us bus time per Tick()\n",
+           msPower, usMaxCall);
+    
+    /* Setter: regBuffer only, one transaction in the next Tick() */
+    HostAdvance(200000);
+    while (radio.IsBusy())
+    {
+        radio.Tick();
+        HostAdvance(1000);
+    }
+    U32 wrBefore = Wire.GetStats()->wrTrans;
+    uint64_t usCall = HostMicros();
+    radio.SetVolume(10);
+    radio.SetMute(true);
+    TEST_EQUAL(HostMicros() - usCall, 0);
+    TEST_EQUAL(Wire.GetStats()->wrTrans, wrBefore);
+    usCall = HostMicros();
+    TEST_CHECK(radio.Tick());
+    U32 usCommit = (U32)(HostMicros() - usCall);
+    TEST_EQUAL(Wire.GetStats()->wrTrans, wrBefore + 1);
+    TEST_EQUAL(chip.GetReg(0x05) & 0x0F, 10);
+    TEST_EQUAL(chip.GetReg(0x02) & 0x4000, 0);             // DMUTE cleared
+    TEST_CHECK(!radio.Tick());                             // Nothing left
+    printf("  SetVolume()+SetMute(): 0 us in call, %u us in next Tick()\n", usCommit);
+    
+    /* Queued read with completion callback */
+    radio.SetCallback(onDone);
+    TEST_CHECK(radio.Submit(RADIO_TR_RECEIVE, 4, 0));
+    TEST_EQUAL(doneCnt, 0);
+    radio.Tick();
+    TEST_EQUAL(doneCnt, 1);
+    TEST_EQUAL(doneType, RADIO_TR_RECEIVE);
+    TEST_EQUAL(doneArg, 4);
+    TEST_CHECK(radio.GetBusTime() > 0);
+    
+    /* Queue limit */
+    for (U8 i=0; i<RADIO_QUEUE_LEN; i++)
+        TEST_CHECK(radio.Submit(RADIO_TR_RECEIVE, 2, 0));
+    TEST_CHECK(!radio.Submit(RADIO_TR_RECEIVE, 2, 0));
+    while (radio.IsBusy())
+    {
+        radio.Tick();
+        HostAdvance(1000);
+    }
+    TEST_EQUAL(doneCnt, 1 + RADIO_QUEUE_LEN);
+    radio.SetCallback(NULL);
+    
+    /* Host cost of the call itself (idle tick, no bus) */
+    const int loopCnt = 1000000;
+    double ns = wallNs();
+    for (int i=0; i<loopCnt; i++)
+        radio.Tick();
+    printf("  idle Tick(): %.1f ns host time per call\n", (wallNs() - ns) / loopCnt);
+}
+
+//------------------------------------------------------------------------------
+static void testTea(void)
+{
+    fakeTea5767 chip;
+    Wire1.DetachAll();
+    Wire1.Attach(0x60, &chip);
+    iccWire wire1Bus(&Wire1);
+    
+    U32 wireTrans = Wire.GetStats()->wrTrans + Wire.GetStats()->rdTrans;
+    objRadioT<radioTea5767> radio;
+    radio.SetBus(&wire1Bus);
+    radio.Init(0x60);
+    U32 usMaxCall = 0;
+    U32 msPower = powerUp(&radio, &usMaxCall);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+    TEST_EQUAL(chip.GetTuned(), RADIO_FDEF);
+    TEST_EQUAL(Wire.GetStats()->wrTrans + Wire.GetStats()->rdTrans, wireTrans);
+    TEST_CHECK(chip.GetWrites() > 0);
+    printf("  TEA5767 power-up %u ms simulated, max. %u us bus time per Tick()\n",
+           msPower, usMaxCall);
+    
+    HostAdvance(200000);
+    while (radio.IsBusy())
+    {
+        radio.Tick();
+        HostAdvance(1000);
+    }
+    radio.SetMute(true);
+    radio.Tick();
+    TEST_EQUAL(chip.GetFrame()[2] & 0x06, 0x06);
+}
+
+//------------------------------------------------------------------------------
+// Signal windows: oldest window is replaced across "millis()" overflow
+//------------------------------------------------------------------------------
+static void testSignalWrap(void)
+{
+    static const U16 freqList[5] = { 8760, 9100, 9550, 10030, 10400 };
+    fakeRda5807m chip;
+    for (U8 i=0; i<5; i++)
+        chip.AddStation(freqList[i], 20 + 10 * i, true, 0);
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    
+    /* 4th window (200 ms each) gets the overflow, 5th is after it */
+    HostSetMicros(((uint64_t)0xFFFFFFFFUL - 1750) * 1000);
+    objRadioT<radioRda5807m> radio;
+    radio.Init(0x10);
+    U32 usMaxCall = 0;
+    powerUp(&radio, &usMaxCall);
+    radio.SetSignalPoll(50);
+    for (U8 i=0; i<5; i++)
+    {
+        radio.SetFrequence(freqList[i]);
+        for (U16 ms=0; ms<200; ms++)
+        {
+            radio.Tick();
+            HostAdvance(1000);
+        }
+    }
+    TEST_CHECK(millis() < 2000);
+    
+    /* First frequence sampled before overflow -> replaced */
+    radioSignal sig;
+    TEST_CHECK(!radio.GetSignal(freqList[0], &sig));
+    for (U8 i=1; i<5; i++)
+    {
+        TEST_CHECK(radio.GetSignal(freqList[i], &sig));
+        TEST_EQUAL(sig.sgMean, 20 + 10 * i);
+    }
+    HostSetMicros(0);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testRda();
+    testTea();
+    testSignalWrap();
+    return TestResult("testRadioBus");
+}
+
+// END OF testRadioBus.cpp
@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+// File...: testRadioChip.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: chip policies (power-up, shadow registers) on the fake bus
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "Wire.h"
+#include "../objRadio.h"
+#include "fakeRadio.h"
+#include "testHost.h"
+
+/* Tick every ms until "msRun" is over */
+template <class RADIO>
+static void run(RADIO *pRadio, U16 msRun)
+{
+    for (U16 i=0; i<msRun; i++)
+    {
+        pRadio->Tick();
+        HostAdvance(1000);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Policy only: power-up steps, frame length and wait time
+//------------------------------------------------------------------------------
+static void testPolicy(void)
+{
+    U8 reg[28];
+    U8 msgLen = 0;
+    U16 msWait = 0;
+    
+    radioRda5807m::InitBuffer(reg);
+    TEST_EQUAL(radioRda5807m::PowerUp(reg, RADIO_STATE_POWER, &msgLen, &msWait), 
+               RADIO_STATE_ENABLE);
+    TEST_EQUAL(msgLen, RDA_INIT_LEN);
+    TEST_EQUAL(msWait, 500);
+    TEST_EQUAL(reg[RDA_L2_BUF] & 0x03, 0x02);
+    TEST_EQUAL(radioRda5807m::PowerUp(reg, RADIO_STATE_ENABLE, &msgLen, &msWait), 
+               RADIO_STATE_TUNE);
+    TEST_EQUAL(msWait, 10);
+    TEST_EQUAL(reg[RDA_L2_BUF] & 0x03, 0x01);
+    TEST_EQUAL(radioRda5807m::PowerUp(reg, RADIO_STATE_TUNE, &msgLen, &msWait), 
+               RADIO_STATE_READY);
+    TEST_EQUAL(msgLen, RDA_TUNE_LEN);
+    TEST_EQUAL(reg[RDA_H2_BUF], 0xC0);
+    TEST_EQUAL(reg[RDA_L2_BUF], 0x01);
+    
+    /* Seek bits of shadow are not repeated by power-up */
+    radioRda5807m::SeekStart<radioBandEu>(reg, NULL, true, false);
+    radioRda5807m::PowerUp(reg, RADIO_STATE_TUNE, &msgLen, &msWait);
+    TEST_EQUAL(reg[RDA_H2_BUF], 0xC0);
+    TEST_EQUAL(reg[RDA_L2_BUF], 0x01);
+    
+    radioTea5767::InitBuffer(reg);
+    TEST_EQUAL(radioTea5767::PowerUp(reg, RADIO_STATE_POWER, &msgLen, &msWait), 
+               RADIO_STATE_READY);
+    TEST_EQUAL(msgLen, radioTea5767::SEND_LEN);
+    TEST_EQUAL(msWait, 100);
+}
+
+//------------------------------------------------------------------------------
+// RDA5807M: mute, mono, bass and RDS set before "Init()" survive power-up
+//------------------------------------------------------------------------------
+static void testRdaPreInit(void)
+{
+    fakeRda5807m chip;
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    
+    /* Defaults: audio on, stereo, no bass boost, no RDS */
+    {
+        objRadioT<radioRda5807m> radio;
+        radio.Init(0x10);
+        run(&radio, 1500);
+        TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+        TEST_EQUAL(chip.GetReg(0x02), 0xC001);
+        TEST_EQUAL(chip.GetResets(), 1);
+    }
+    
+    /* Expected shadow: same setters on policy */
+    U8 reg[28];
+    radioRda5807m::InitBuffer(reg);
+    radioRda5807m::Mute(reg, true);
+    radioRda5807m::Mono(reg, true);
+    radioRda5807m::Bass(reg, true);
+    radioRda5807m::Rds(reg, true);
+    
+    objRadioT<radioRda5807m> radio;
+    radio.SetMute(true);
+    radio.SetMono(true);
+    radio.SetBass(true);
+    radio.SetRds(true);
+    radio.SetFrequence(9550);
+    radio.Init(0x10);
+    run(&radio, 1500);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+    TEST_EQUAL(chip.GetTuned(), 9550);
+    TEST_EQUAL((chip.GetReg(0x02) >> 8) & RDA_H2_USER, reg[RDA_H2_BUF] & RDA_H2_USER);
+    TEST_EQUAL(chip.GetReg(0x02) & RDA_L2_USER, reg[RDA_L2_BUF] & RDA_L2_USER);
+    TEST_EQUAL(chip.GetReg(0x02) & 0x8001, 0x8001);
+    
+    /* Change after power-up: written by next "Tick()" */
+    radio.SetBass(false);
+    radio.SetMute(false);
+    run(&radio, 5);
+    TEST_EQUAL(chip.GetReg(0x02) & 0x1000, 0);
+    TEST_EQUAL(chip.GetReg(0x02) & 0x4000, 0x4000);
+    TEST_EQUAL(chip.GetReg(0x02) & RDA_L2_USER, RDA_L2_USER);
+}
+
+//------------------------------------------------------------------------------
+// TEA5767: mute and mono set before "Init()" in first frame
+//------------------------------------------------------------------------------
+static void testTeaPreInit(void)
+{
+    fakeTea5767 chip;
+    Wire.DetachAll();
+    Wire.Attach(0x60, &chip);
+    
+    objRadioT<radioTea5767> radio;
+    radio.SetMute(true);
+    radio.SetMono(true);
+    radio.SetFrequence(10400);
+    radio.Init(0x60);
+    run(&radio, 700);
+    TEST_EQUAL(radio.GetState(), RADIO_STATE_READY);
+    TEST_EQUAL(chip.GetTuned(), 10400);
+    TEST_EQUAL(chip.GetFrame()[2] & 0x0E, 0x0E);
+    
+    radio.SetMute(false);
+    run(&radio, 5);
+    TEST_EQUAL(chip.GetFrame()[2] & 0x0E, 0x08);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testPolicy();
+    testRdaPreInit();
+    testTeaPreInit();
+    return TestResult("testRadioChip");
+}
+
+// END OF testRadioChip.cpp
@@ -0,0 +1,201 @@
+//------------------------------------------------------------------------------
+// File...: testRadioScan.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objRadio seek, band scan and station table on both chips
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "Wire.h"
+#include "../objRadio.h"
+#include "../objRds.h"
+#include "fakeRadio.h"
+#include "testHost.h"
+
+/* Run "Tick()" every ms, push an RDS group every 20 ms, max. "msMax" */
+template <class RADIO>
+static U32 runScan(RADIO *pRadio, fakeTuner *pChip, fakeRda5807m *pRda, U32 msMax)
+{
+    (void)pChip;
+    uint64_t usStart = HostMicros();
+    for (U32 ms=0; ms<msMax; ms++)
+    {
+        if ((pRadio->GetScanState() == RADIO_SCAN_DONE) ||
+            (pRadio->GetScanState() == RADIO_SCAN_PAUSE))
+            break;
+        if ((pRda != NULL) && ((ms % 20) == 0))
+            pRda->PushRds(0x0000, 0x0000, 0x0000);
+        pRadio->Tick();
+        HostAdvance(1000);
+    }
+    return (U32)((HostMicros() - usStart) / 1000);
+}
+
+/* Power-up and pending commits done */
+template <class RADIO>
+static void ready(RADIO *pRadio)
+{
+    for (U16 i=0; (i<3000) && pRadio->IsBusy(); i++)
+    {
+        pRadio->Tick();
+        HostAdvance(1000);
+    }
+    for (U8 i=0; i<50; i++)
+    {
+        pRadio->Tick();
+        HostAdvance(1000);
+    }
+}
+
+//------------------------------------------------------------------------------
+// TEA5767 has no RDS: attached decoder must not delay the scan
+//------------------------------------------------------------------------------
+static void testTeaScan(void)
+{
+    fakeTea5767 chip;
+    chip.AddStation(8800, 80, true, 0);
+    chip.AddStation(9550, 40, false, 0);
+    chip.AddStation(10400, 120, true, 0);
+    Wire.DetachAll();
+    Wire.Attach(0x60, &chip);
+    
+    objRds rds;
+    objRadioT<radioTea5767> radio;
+    radio.AttachRds(&rds);
+    radio.Init(0x60);
+    ready(&radio);
+    
+    TEST_CHECK(radio.ScanBand(0));
+    U32 msScan = runScan(&radio, &chip, NULL, 10000);
+    TEST_EQUAL(radio.GetScanState(), RADIO_SCAN_DONE);
+    TEST_CHECK(msScan < RADIO_SCAN_PI);
+    printf("  TEA5767 scan with objRds attached: %u ms\n", msScan);
+    
+    U8 stCnt = 0;
+    const radioStation *pList = radio.GetStations(&stCnt);
+    TEST_EQUAL(stCnt, 3);
+    TEST_EQUAL(pList[0].stFreq, 8800);
+    TEST_EQUAL(pList[1].stFreq, 9550);
+    TEST_EQUAL(pList[2].stFreq, 10400);
+    TEST_EQUAL(pList[0].stFlags & RADIO_ST_STEREO, RADIO_ST_STEREO);
+    TEST_EQUAL(pList[1].stFlags & RADIO_ST_STEREO, 0);
+    TEST_EQUAL(pList[2].stRssi, 120 >> 3);
+}
+
+//------------------------------------------------------------------------------
+// RDA5807M: PI code of every station, paused and resumed scan, seek
+//------------------------------------------------------------------------------
+static void testRdaScan(void)
+{
+    fakeRda5807m chip;
+    chip.AddStation(8760, 50, true, 0xD311);
+    chip.AddStation(9100, 30, false, 0);
+    chip.AddStation(10030, 70, true, 0xD3C2);
+    Wire.DetachAll();
+    Wire.Attach(0x10, &chip);
+    Wire.Attach(0x11, &chip);
+    
+    objRds rds;
+    objRadioT<radioRda5807m> radio;
+    radio.AttachRds(&rds);
+    radio.Init(0x10);
+    ready(&radio);
+    radio.SetRds(true);
+    ready(&radio);
+    
+    /* Slices of 100 ms */
+    TEST_CHECK(radio.ScanBand(100));
+    U8 sliceCnt = 1;
+    runScan(&radio, &chip, &chip, 10000);
+    while ((radio.GetScanState() == RADIO_SCAN_PAUSE) && (sliceCnt < 50))
+    {
+        TEST_CHECK(radio.ScanBand(100));
+        sliceCnt++;
+        runScan(&radio, &chip, &chip, 10000);
+    }
+    TEST_EQUAL(radio.GetScanState(), RADIO_SCAN_DONE);
+    TEST_CHECK(sliceCnt > 1);
+    
+    U8 stCnt = 0;
+    const radioStation *pList = radio.GetStations(&stCnt);
+    TEST_EQUAL(stCnt, 3);
+    TEST_EQUAL(pList[0].stFreq, 8760);
+    TEST_EQUAL(pList[0].stPI, 0xD311);
+    TEST_EQUAL(pList[0].stRssi, 50);
+    TEST_EQUAL(pList[1].stPI, 0);
+    TEST_EQUAL(pList[2].stFreq, 10030);
+    TEST_EQUAL(pList[2].stPI, 0xD3C2);
+    
+    /* Saved table -> reload and tune by index */
+    radioStation saved[RADIO_STATION_MAX];
+    memcpy(saved, pList, stCnt * sizeof(radioStation));
+    TEST_CHECK(radio.SetStations(saved, stCnt));
+    TEST_CHECK(radio.SelectStation(1));
+    ready(&radio);
+    TEST_EQUAL(chip.GetTuned(), 9100);
+    TEST_CHECK(!radio.SelectStation(3));
+    
+    /* Hardware seek up with wrap */
+    TEST_CHECK(radio.Seek(true));
+    for (U16 i=0; (i<1000) && (radio.GetSeekState() == RADIO_SEEK_RUN); i++)
+    {
+        radio.Tick();
+        HostAdvance(1000);
+    }
+    TEST_EQUAL(radio.GetSeekState(), RADIO_SEEK_DONE);
+    TEST_EQUAL(radio.GetFrequence(), 10030);
+    TEST_EQUAL(chip.GetTuned(), 10030);
+}
+
+//------------------------------------------------------------------------------
+// Second band policy beside objRadio: Japan band on both chips
+//------------------------------------------------------------------------------
+static void testJpBand(void)
+{
+    fakeRda5807m rda;
+    rda.AddStation(7650, 40, true, 0);
+    rda.AddStation(8000, 60, true, 0);
+    rda.AddStation(9500, 60, true, 0);
+    fakeTea5767 tea;
+    tea.AddStation(7800, 90, true, 0);
+    tea.AddStation(9000, 90, false, 0);
+    Wire.DetachAll();
+    Wire.Attach(0x10, &rda);
+    Wire.Attach(0x11, &rda);
+    Wire.Attach(0x60, &tea);
+    
+    objRadioT<radioRda5807m, radioBandJp> radioRda;
+    objRadioT<radioTea5767, radioBandJp> radioTea;
+    radioRda.Init(0x10);
+    radioTea.Init(0x60);
+    ready(&radioRda);
+    ready(&radioTea);
+    TEST_EQUAL(radioRda.GetFrequence(), 7600);
+    
+    TEST_CHECK(radioRda.ScanBand(0));
+    runScan(&radioRda, &rda, NULL, 10000);
+    U8 stCnt = 0;
+    const radioStation *pList = radioRda.GetStations(&stCnt);
+    TEST_EQUAL(stCnt, 2);
+    TEST_EQUAL(pList[0].stFreq, 7650);
+    TEST_EQUAL(pList[1].stFreq, 8000);
+    
+    TEST_CHECK(radioTea.ScanBand(0));
+    runScan(&radioTea, &tea, NULL, 10000);
+    pList = radioTea.GetStations(&stCnt);
+    TEST_EQUAL(stCnt, 2);
+    TEST_EQUAL(pList[0].stFreq, 7800);
+    TEST_EQUAL(pList[1].stFreq, 9000);
+    TEST_CHECK(!radioTea.SetFrequence(9550));
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testTeaScan();
+    testRdaScan();
+    testJpBand();
+    return TestResult("testRadioScan");
+}
+
+// END OF testRadioScan.cpp
@@ -0,0 +1,154 @@
+//------------------------------------------------------------------------------
+// File...: testRds.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objRds decoder fed with recorded group streams
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objRds.h"
+#include "testHost.h"
+
+/* Recorded group: blocks A..D, BLERA [3:2] / BLERB [1:0] */
+typedef struct
+{
+    U16 blk[4];
+    U8  err;
+} rdsRec;
+
+/* Station PI 0xD313, TP, PTY 10: PS "ANTENNE ", RT "HELLO WORLD", CT */
+static const rdsRec streamA[] =
+{
+    { { 0xD313, 0x0540, 0xE341, 0x414E }, 0x00 },   // 0A seg 0 "AN", AF count 3 + 94.0
+    { { 0xD313, 0x2540, 0x4845, 0x4C4C }, 0x00 },   // 2A seg 0 "HELL"
+    { { 0xD313, 0x0541, 0x5A41, 0x5445 }, 0x00 },   // 0A seg 1 "TE", AF 96.5 + 94.0
+    { { 0xD313, 0x2541, 0x4F20, 0x574F }, 0x03 },   // 2A seg 1, BLERB 3 -> rejected
+    { { 0xD313, 0x0542, 0x415A, 0x4E4E }, 0x00 },   // 0A seg 2 "NN", AF duplicates
+    { { 0xD313, 0x4541, 0xCC20, 0xDB42 }, 0x00 },   // 4A CT 17.02.2020 13:45 UTC, +1 h
+    { { 0xD313, 0x0543, 0xE341, 0x4520 }, 0x00 },   // 0A seg 3 "E " -> PS complete
+    { { 0xD313, 0x2541, 0x4F20, 0x574F }, 0x00 },   // 2A seg 1 "O WO"
+    { { 0xD313, 0x2542, 0x524C, 0x440D }, 0x00 },   // 2A seg 2 "RLD" + end -> RT complete
+};
+
+/* Same station: new RadioText (flag B), first segment 1 "AB" + end */
+static const rdsRec streamB[] =
+{
+    { { 0xD313, 0x2551, 0x2041, 0x420D }, 0x00 },   // 2A flag B seg 1 " AB" + end
+    { { 0xD313, 0x2550, 0x4E45, 0x5753 }, 0x00 },   // 2A flag B seg 0 "NEWS"
+};
+
+/* 2B (32 chars, block C = PI): "HI" + end, block A with BLERA 3 */
+static const rdsRec streamC[] =
+{
+    { { 0xD314, 0x2D40, 0xD313, 0x4849 }, 0x0C },   // 2B seg 0 "HI", PI uncorrectable
+    { { 0xD313, 0x2D41, 0xD313, 0x0D20 }, 0x00 },   // 2B seg 1 end
+};
+
+/* Other station after a frequency change */
+static const rdsRec streamD[] =
+{
+    { { 0xD3C2, 0x0400, 0xE05A, 0x4E44 }, 0x00 },   // 0A seg 0 "ND", PTY 0
+};
+
+static void feed(objRds *pRds, const rdsRec *pRec, U8 recCnt)
+{
+    for (U8 i=0; i<recCnt; i++)
+    {
+        TEST_CHECK(pRds->Push(pRec[i].blk[0], pRec[i].blk[1], pRec[i].blk[2],
+                              pRec[i].blk[3], pRec[i].err));
+        TEST_EQUAL(pRds->Decode(4), 1);
+    }
+}
+
+#define FEED(pRds, stream) feed(pRds, stream, sizeof(stream) / sizeof(stream[0]))
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    objRds rds;
+    char text[RDS_RT_LEN + 1];
+    U16 grpRecv, grpError, grpLost;
+
+    /* PS only after all 4 segments, RT up to the end marker */
+    feed(&rds, streamA, 6);
+    TEST_CHECK(!rds.GetPS(text));
+    feed(&rds, streamA + 6, 3);
+    TEST_EQUAL(rds.GetPI(), 0xD313);
+    TEST_EQUAL(rds.GetPTY(), 10);
+    TEST_CHECK(rds.GetPS(text));
+    TEST_CHECK(strcmp(text, "ANTENNE ") == 0);
+    TEST_CHECK(rds.GetRT(text));
+    TEST_CHECK(strcmp(text, "HELLO WORLD") == 0);
+
+    /* CT: MJD 58896 = 17.02.2020, offset +2 x 30 min */
+    rdsTime ct;
+    TEST_CHECK(rds.GetCT(&ct));
+    TEST_EQUAL(ct.year, 2020);
+    TEST_EQUAL(ct.month, 2);
+    TEST_EQUAL(ct.day, 17);
+    TEST_EQUAL(ct.hour, 13);
+    TEST_EQUAL(ct.minute, 45);
+    TEST_EQUAL(ct.offset, 2);
+
+    /* AF: count code (0xE3) ignored, duplicates once */
+    U16 afList[RDS_AF_MAX];
+    TEST_EQUAL(rds.GetAF(afList, RDS_AF_MAX), 2);
+    TEST_EQUAL(afList[0], 9400);
+    TEST_EQUAL(afList[1], 9650);
+    TEST_EQUAL(rds.GetAF(afList, 1), 1);
+
+    /* BLERB 3 rejected */
+    rds.GetStats(&grpRecv, &grpError, &grpLost);
+    TEST_EQUAL(grpRecv, 9);
+    TEST_EQUAL(grpError, 1);
+    TEST_EQUAL(grpLost, 0);
+
+    /* A/B flag: old segments do not complete the new text */
+    feed(&rds, streamB, 1);
+    TEST_CHECK(rds.GetRT(text));
+    TEST_CHECK(strcmp(text, "HELLO WORLD") == 0);
+    feed(&rds, streamB + 1, 1);
+    TEST_CHECK(rds.GetRT(text));
+    TEST_CHECK(strcmp(text, "NEWS AB") == 0);
+
+    /* 2B with uncorrectable block A: text decoded, PI kept */
+    FEED(&rds, streamC);
+    TEST_CHECK(rds.GetRT(text));
+    TEST_CHECK(strcmp(text, "HI") == 0);
+    TEST_EQUAL(rds.GetPI(), 0xD313);
+
+    /* Error level 3 accepted after "SetMaxError(3)" */
+    rds.SetMaxError(3);
+    feed(&rds, streamA + 3, 1);
+    rds.GetStats(&grpRecv, &grpError, &grpLost);
+    TEST_EQUAL(grpError, 1);
+    rds.SetMaxError(RDS_ERR_MAX);
+
+    /* PI change: everything of the old station is cleared */
+    FEED(&rds, streamD);
+    TEST_EQUAL(rds.GetPI(), 0xD3C2);
+    TEST_EQUAL(rds.GetPTY(), 0);
+    TEST_CHECK(!rds.GetPS(text));
+    TEST_CHECK(!rds.GetRT(text));
+    TEST_CHECK(!rds.GetCT(&ct));
+    TEST_EQUAL(rds.GetAF(afList, RDS_AF_MAX), 1);
+    TEST_EQUAL(afList[0], 9650);
+
+    /* Ring full: RDS_RING_LEN - 1 groups, the next one is lost */
+    for (U8 i=0; i<RDS_RING_LEN - 1; i++)
+        TEST_CHECK(rds.Push(0xD3C2, 0x0400, 0, 0x2020, 0));
+    TEST_CHECK(!rds.Push(0xD3C2, 0x0400, 0, 0x2020, 0));
+    rds.GetStats(&grpRecv, &grpError, &grpLost);
+    TEST_EQUAL(grpLost, 1);
+
+    /* Bounded decode per call */
+    TEST_EQUAL(rds.Decode(4), 4);
+    TEST_EQUAL(rds.Decode(4), RDS_RING_LEN - 1 - 4);
+    TEST_EQUAL(rds.Decode(4), 0);
+    TEST_CHECK(rds.Push(0xD3C2, 0x0400, 0, 0x2020, 0));
+    TEST_EQUAL(rds.Decode(4), 1);
+
+    return TestResult("testRds");
+}
+
+// END OF testRds.cpp
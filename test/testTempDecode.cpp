@@ -0,0 +1,170 @@
+//------------------------------------------------------------------------------
+// File...: testTempDecode.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objTempera "Decode()" over all byte combinations, derived values
+// against the floating point formulas
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objTempera.h"
+#include "testHost.h"
+#include <math.h>
+
+/* DHT12 frame: humidity, humidity decimal, temperature, temperature decimal */
+#define FR_HUMI_H     0
+#define FR_HUMI_L     1
+#define FR_TEMP_H     2
+#define FR_TEMP_L     3
+
+/* NWS Rothfusz regression [°C] */
+static double rothfusz(double tc, double rh)
+{
+    double t = (tc * 9.0 / 5.0) + 32.0;
+    double hi = -42.379 + (2.04901523 * t) + (10.14333127 * rh) -
+                (0.22475541 * t * rh) - (6.83783e-3 * t * t) -
+                (5.481717e-2 * rh * rh) + (1.22874e-3 * t * t * rh) +
+                (8.5282e-4 * t * rh * rh) - (1.99e-6 * t * t * rh * rh);
+    return (hi - 32.0) * 5.0 / 9.0;
+}
+
+//------------------------------------------------------------------------------
+// Raw values: every byte pair of temperature and humidity
+//------------------------------------------------------------------------------
+static void testRaw(void)
+{
+    U8 frame[5] = { 50, 0, 20, 0, 0 };
+    tempReading rd;
+    U32 validCnt = 0;
+    bool bTemp = true;
+    bool bHumi = true;
+    for (U16 h=0; h<256; h++)
+    {
+        for (U16 l=0; l<256; l++)
+        {
+            /* Temperature: decimal 0..9, bit 7 = negative */
+            frame[FR_HUMI_H] = 50;
+            frame[FR_HUMI_L] = 0;
+            frame[FR_TEMP_H] = (U8)h;
+            frame[FR_TEMP_L] = (U8)l;
+            bool bOk = objTempera::Decode(frame, &rd);
+            S16 temp = (S16)((h * 10) + (l & 0x7F)) * ((l & 0x80) ? -1 : 1);
+            if ((bOk != ((l & 0x7F) <= 9)) || (bOk && (rd.temp != temp)))
+                bTemp = false;
+            if (bOk)
+                validCnt++;
+
+            /* Humidity: decimal 0..9 */
+            frame[FR_HUMI_H] = (U8)h;
+            frame[FR_HUMI_L] = (U8)l;
+            frame[FR_TEMP_H] = 20;
+            frame[FR_TEMP_L] = 0;
+            bOk = objTempera::Decode(frame, &rd);
+            if ((bOk != (l <= 9)) || (bOk && (rd.humi != ((h * 10) + l))))
+                bHumi = false;
+        }
+    }
+    TEST_CHECK(bTemp);
+    TEST_CHECK(bHumi);
+    TEST_EQUAL(validCnt, 256 * 20);
+}
+
+//------------------------------------------------------------------------------
+// Derived values: all valid temperatures x humidity 0..100%
+//------------------------------------------------------------------------------
+static void testDerived(void)
+{
+    U8 frame[5] = { 0, 0, 0, 0, 0 };
+    tempReading rd;
+    U32 decCnt = 0;
+    double maxDew = 0;
+    double maxAbs = 0;
+    double maxHeat = 0;
+    U32 heatPass = 0;
+    bool bPass = true;
+    bool bHeatClamp = true;
+    S16 heatMax = 0;
+    for (U16 th=0; th<256; th++)
+    {
+        for (U16 tl=0; tl<256; tl++)
+        {
+            if ((tl & 0x7F) > 9)
+                continue;
+            for (U16 hh=0; hh<=100; hh++)
+            {
+                for (U8 hl=0; hl<10; hl++)
+                {
+                    frame[FR_HUMI_H] = (U8)hh;
+                    frame[FR_HUMI_L] = hl;
+                    frame[FR_TEMP_H] = (U8)th;
+                    frame[FR_TEMP_L] = (U8)tl;
+                    objTempera::Decode(frame, &rd);
+                    decCnt++;
+
+                    double tc = rd.temp / 10.0;
+                    double rh = rd.humi / 10.0;
+
+                    /* Heat index only in 26..50°C / 40..100% (above 100% */
+                    /* clamped), else temperature */
+                    bool bHeat = (tc >= 26.0) && (tc <= 50.0) && (rh >= 40.0);
+                    if (!bHeat)
+                    {
+                        if (rd.heatIndex != rd.temp)
+                            bPass = false;
+                        heatPass++;
+                    }
+                    if (bHeat && (rh > 100.0))
+                        bHeatClamp &= (rd.heatIndex == heatMax);
+                    if ((rh > 100.0) || (tc < -40.0) || (tc > 80.0))
+                        continue;
+
+                    /* Magnus (Sonntag), table range -40..80°C */
+                    double mag = 17.62 * tc / (243.12 + tc);
+                    double vapour = 611.2 * exp(mag) * rh / 100.0;
+                    if (rh >= 1.0)
+                    {
+                        double g = log(rh / 100.0) + mag;
+                        double dew = 243.12 * g / (17.62 - g);
+                        if ((dew >= -40.0) && (fabs(dew - (rd.dewPoint / 10.0)) > maxDew))
+                            maxDew = fabs(dew - (rd.dewPoint / 10.0));
+                    }
+                    /* Relative error, absolute below 1 g/m³ (0.01 g/m³ truncated) */
+                    double absHumi = 2.16679 * vapour / (tc + 273.15);
+                    double absErr = fabs(absHumi - (rd.absHumi / 100.0)) / 
+                                    ((absHumi > 1.0) ? absHumi : 1.0);
+                    if (absErr > maxAbs)
+                        maxAbs = absErr;
+                    if (bHeat && (rh == 100.0))
+                        heatMax = rd.heatIndex;
+                    if (bHeat && (fabs(rothfusz(tc, rh) - (rd.heatIndex / 10.0)) > maxHeat))
+                        maxHeat = fabs(rothfusz(tc, rh) - (rd.heatIndex / 10.0));
+                }
+            }
+        }
+    }
+    printf("  %lu readings: max. error dew point %.3f C, abs. humidity %.2f%%, "
+           "heat index %.3f C\n", (unsigned long)decCnt, maxDew, maxAbs * 100.0, maxHeat);
+    TEST_CHECK(bPass);
+    TEST_CHECK(bHeatClamp);
+    TEST_CHECK(heatPass > 0);
+    TEST_CHECK(maxDew < 0.2);
+    TEST_CHECK(maxAbs < 0.015);
+    TEST_CHECK(maxHeat < 0.35);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testRaw();
+    testDerived();
+
+    /* Above the table: heat index = temperature (not the 50°C value) */
+    U8 frame[5] = { 60, 0, 55, 0, 0 };
+    tempReading rd;
+    TEST_CHECK(objTempera::Decode(frame, &rd));
+    TEST_EQUAL(rd.temp, 550);
+    TEST_EQUAL(rd.heatIndex, 550);
+    return TestResult("testTempDecode");
+}
+
+// END OF testTempDecode.cpp
@@ -0,0 +1,163 @@
+//------------------------------------------------------------------------------
+// File...: testTempFilter.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objTempFilter median, EMA and rolling windows
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objTempFilter.h"
+#include "testHost.h"
+#include <math.h>
+
+#define MS_SEC        1000UL
+#define MS_MIN       60000UL
+#define MS_HOUR    3600000UL
+
+//------------------------------------------------------------------------------
+// Median of 5: up to 2 spikes rejected, the 3rd is a step
+//------------------------------------------------------------------------------
+static void testSpike(void)
+{
+    objTempFilter filt;
+    tempfWindow win;
+    TEST_CHECK(!filt.GetWindow(TEMPF_WIN_MIN, &win));
+    U32 msTime = 0;
+    for (U8 i=0; i<4; i++)
+    {
+        filt.Insert(200, msTime);
+        msTime += MS_SEC;
+    }
+    filt.Insert(900, msTime);
+    TEST_EQUAL(filt.Median(), 200);
+    msTime += MS_SEC;
+    filt.Insert(900, msTime);
+    TEST_EQUAL(filt.Median(), 200);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winMax, 200);
+    TEST_EQUAL(filt.Average(), 200);
+    msTime += MS_SEC;
+    filt.Insert(900, msTime);
+    TEST_EQUAL(filt.Median(), 900);
+
+    /* Single negative spike */
+    filt.Insert(-400, msTime + MS_SEC);
+    TEST_EQUAL(filt.Median(), 900);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winMin, 200);
+    TEST_EQUAL(filt.GetCount(), 8);
+
+    filt.Clear();
+    TEST_EQUAL(filt.GetCount(), 0);
+    TEST_CHECK(!filt.GetWindow(TEMPF_WIN_DAY, &win));
+}
+
+//------------------------------------------------------------------------------
+// EMA alpha 1/8: follows the float recursion, settles on the exact value
+//------------------------------------------------------------------------------
+static void testEma(S16 from, S16 to)
+{
+    objTempFilter filt;
+    filt.Insert(from, 0);
+    double ema = from;
+    double maxErr = 0;
+    U8 n = 0;
+    for (; n<80; n++)
+    {
+        filt.Insert(to, (n + 1) * MS_SEC);
+        ema += (filt.Median() - ema) / (1 << TEMPF_EMA_SHIFT);
+        if (fabs(ema - filt.Average()) > maxErr)
+            maxErr = fabs(ema - filt.Average());
+
+        /* Time constant: 63% after 8 samples behind the median step */
+        if (n == 2 + 8)
+            TEST_CHECK(fabs(filt.Average() - from) > 0.6 * fabs((double)(to - from)));
+    }
+    TEST_CHECK(maxErr <= 1.0);
+    TEST_EQUAL(filt.Average(), to);
+}
+
+//------------------------------------------------------------------------------
+// Windows: rollover of the oldest bucket, gap clears, min/max/mean
+//------------------------------------------------------------------------------
+static void testWindow(void)
+{
+    objTempFilter filt;
+    tempfWindow win;
+    TEST_CHECK(!filt.GetWindow(TEMPF_WIN_CNT, &win));
+
+    /* Ramp 0..59 (one value per second), median lags 2 values */
+    for (U32 s=0; s<60; s++)
+        filt.Insert((S16)s, s * MS_SEC);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winCnt, 60);
+    TEST_EQUAL(win.winMin, 0);
+    TEST_EQUAL(win.winMax, 57);
+
+    /* 60 s: first bucket (0..9 s) drops out of the minute */
+    filt.Insert(60, 60 * MS_SEC);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winCnt, 51);
+    TEST_EQUAL(win.winMin, 8);
+    TEST_EQUAL(win.winMax, 58);
+    TEST_EQUAL(win.winMean, 33);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_HOUR, &win));
+    TEST_EQUAL(win.winCnt, 61);
+    TEST_EQUAL(win.winMin, 0);
+
+    /* Gap > 1 min: minute window only the new value */
+    filt.Insert(61, 60 * MS_SEC + 2 * MS_MIN);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winCnt, 1);
+    TEST_EQUAL(win.winMin, filt.Median());
+    TEST_EQUAL(win.winMax, filt.Median());
+    TEST_EQUAL(win.winMean, filt.Median());
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_HOUR, &win));
+    TEST_EQUAL(win.winCnt, 62);
+
+    /* Gap > 1 h: hour window too, day keeps all */
+    filt.Insert(62, 2 * MS_HOUR);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_HOUR, &win));
+    TEST_EQUAL(win.winCnt, 1);
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_DAY, &win));
+    TEST_EQUAL(win.winCnt, 63);
+    TEST_EQUAL(win.winMin, 0);
+
+    /* Min/max/mean of the median values (xorshift, negative values) */
+    filt.Clear();
+    U32 x = 2463534242UL;
+    S16 medMin = 0x7FFF;
+    S16 medMax = -0x7FFF;
+    double medSum = 0;
+    U16 cnt = 500;
+    for (U16 i=0; i<cnt; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        filt.Insert((S16)((x % 1201) - 600), i * 100UL);
+        medSum += filt.Median();
+        if (filt.Median() < medMin)
+            medMin = filt.Median();
+        if (filt.Median() > medMax)
+            medMax = filt.Median();
+    }
+    TEST_CHECK(filt.GetWindow(TEMPF_WIN_MIN, &win));
+    TEST_EQUAL(win.winCnt, cnt);
+    TEST_EQUAL(win.winMin, medMin);
+    TEST_EQUAL(win.winMax, medMax);
+    TEST_EQUAL(win.winMean, (S16)lround(medSum / cnt));
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    testSpike();
+    testEma(0, 800);
+    testEma(0, -150);
+    testEma(250, -37);
+    testWindow();
+    return TestResult("testTempFilter");
+}
+
+// END OF testTempFilter.cpp
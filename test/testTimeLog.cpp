@@ -0,0 +1,258 @@
+//------------------------------------------------------------------------------
+// File...: testTimeLog.cpp
+// Author.: M. Anders
+// Date...: 17.02.2020
+//------------------------------------------------------------------------------
+// Host test: objTimeLog page size limits, query at a page boundary, ring
+// wrap, reopen with "Begin()", week replay (compression, time per sample)
+//------------------------------------------------------------------------------
+#include "Arduino.h"
+#include "../objTimeLog.h"
+#include "testHost.h"
+#include <math.h>
+#include <time.h>
+
+#define PAGE_CNT       8
+#define SAME_CNT      12
+
+/* Week replay: one reading per minute */
+#define WEEK_PERIOD   60
+#define WEEK_CNT     (7 * 24 * 60)
+#define WEEK_PAGE    256
+#define WEEK_PAGES    64
+
+/* Ring wrap: smallest pages, sequence numbers 0..254 wrap */
+#define WRAP_PAGES     6
+#define WRAP_SEQ     250
+#define WRAP_CNT    5000
+
+static U8 region[PAGE_CNT * TLOG_PAGE_MAX];
+static tlogSample ref[WEEK_CNT];
+static tlogSample out[WEEK_CNT + 1];
+
+static double wallNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Synthetic DHT12 readings: day cycle, weather drift, sensor jitter */
+static void makeReadings(tlogSample *pSmp, U16 cnt, U16 secPeriod, U32 secStart)
+{
+    U32 x = 2463534242UL;
+    for (U16 i=0; i<cnt; i++)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        double day = 2.0 * M_PI * (i * (double)secPeriod) / 86400.0;
+        double week = 2.0 * M_PI * (i * (double)secPeriod) / (7 * 86400.0);
+        S16 jitter = ((x & 0x0F) == 0) ? 1 : (((x & 0x0F) == 1) ? -1 : 0);
+        pSmp[i].secTime = secStart + (U32)i * secPeriod;
+        pSmp[i].temp = (S16)lround(210.0 + 25.0 * sin(day) + 30.0 * sin(week)) + jitter;
+        pSmp[i].humi = (U16)lround(550.0 - 80.0 * sin(day) + 50.0 * cos(week));
+    }
+}
+
+static bool sameSamples(const tlogSample *pA, const tlogSample *pB, U16 cnt)
+{
+    for (U16 i=0; i<cnt; i++)
+    {
+        if ((pA[i].secTime != pB[i].secTime) || (pA[i].temp != pB[i].temp) ||
+            (pA[i].humi != pB[i].humi))
+            return false;
+    }
+    return true;
+}
+
+/* Page with sequence number in the ring of testWrap() */
+static bool pageFound(U8 seq)
+{
+    for (U8 p=0; p<WRAP_PAGES; p++)
+    {
+        if (region[p * TLOG_PAGE_MIN] == seq)
+            return true;
+    }
+    return false;
+}
+
+//------------------------------------------------------------------------------
+// Ring wrap: oldest pages overwritten, sequence numbers wrap, reopen finds
+// the newest page from the sequence gap
+//------------------------------------------------------------------------------
+static void testWrap(void)
+{
+    objTimeLog tlog;
+    tlogRam ram(region, WRAP_PAGES * TLOG_PAGE_MIN, TLOG_PAGE_MIN);
+    TEST_CHECK(tlog.Begin(&ram, 10));
+    tlog.Clear();
+    
+    /* Every sample changes: 1 byte per sample, 12 per page */
+    /* Up to sequence number WRAP_SEQ, the reopen loop passes 254 -> 0 */
+    bool bWrap = true;
+    U32 secTime = 1000;
+    S16 temp = 200;
+    for (U16 i=0; (i<WRAP_CNT) && !pageFound(WRAP_SEQ); i++)
+    {
+        secTime += 10;
+        temp += (i & 1) ? -3 : 4;
+        bWrap &= tlog.Append(secTime, temp, 400 + (i % 4));
+    }
+    TEST_CHECK(bWrap);
+    TEST_CHECK(pageFound(WRAP_SEQ));
+    
+    /* Oldest sample in the ring .. newest, continuous */
+    U16 cnt = tlog.Query(0, 0xFFFFFFFF, out, WEEK_CNT);
+    TEST_CHECK((cnt > (WRAP_PAGES - 1) * (TLOG_PAGE_MIN - TLOG_HEAD_LEN)) &&
+               (cnt <= WRAP_PAGES * (TLOG_PAGE_MIN - TLOG_HEAD_LEN + 1)));
+    bool bOrder = true;
+    for (U16 i=1; i<cnt; i++)
+        bOrder &= (out[i].secTime == out[i - 1].secTime + 10);
+    TEST_CHECK(bOrder);
+    TEST_EQUAL(out[cnt - 1].secTime, secTime);
+    TEST_EQUAL(out[cnt - 1].temp, temp);
+    
+    /* Reopen at every head position (sequence gap in the ring) */
+    bool bReopen = true;
+    for (U8 n=0; n<2 * WRAP_PAGES; n++)
+    {
+        for (U8 k=0; k<12; k++)
+        {
+            secTime += 10;
+            temp += (k & 1) ? -2 : 3;
+            tlog.Append(secTime, temp, 410);
+        }
+        tlog.Flush();
+        cnt = tlog.Query(0, 0xFFFFFFFF, out, WEEK_CNT);
+        objTimeLog reopen;
+        bReopen &= reopen.Begin(&ram, 10);
+        tlogSample lastSmp;
+        bReopen &= reopen.GetLast(&lastSmp);
+        bReopen &= (lastSmp.secTime == secTime) && (lastSmp.temp == temp);
+        bReopen &= (reopen.Query(0, 0xFFFFFFFF, &out[cnt], WEEK_CNT - cnt) == cnt);
+        bReopen &= sameSamples(out, &out[cnt], cnt);
+    }
+    TEST_CHECK(bReopen);
+    TEST_CHECK(!pageFound(WRAP_SEQ) && !pageFound(254));
+}
+
+//------------------------------------------------------------------------------
+// Reopen with "Begin()": query, continue appending after the newest sample
+//------------------------------------------------------------------------------
+static void testReopen(void)
+{
+    U16 cnt = 500;
+    makeReadings(ref, cnt, WEEK_PERIOD, 100000);
+    objTimeLog tlog;
+    tlogRam ram(region, 16 * 64, 64);
+    TEST_CHECK(tlog.Begin(&ram, WEEK_PERIOD));
+    tlog.Clear();
+    for (U16 i=0; i<cnt - 100; i++)
+        tlog.Append(ref[i].secTime, ref[i].temp, ref[i].humi);
+    tlog.Flush();
+    
+    objTimeLog reopen;
+    TEST_CHECK(reopen.Begin(&ram, WEEK_PERIOD));
+    TEST_EQUAL(reopen.Query(0, 0xFFFFFFFF, out, WEEK_CNT), cnt - 100);
+    TEST_CHECK(sameSamples(out, ref, cnt - 100));
+    
+    /* Range in the middle of the log */
+    U32 secFrom = ref[123].secTime;
+    U32 secTo = ref[345].secTime;
+    TEST_EQUAL(reopen.Query(secFrom, secTo, out, WEEK_CNT), 345 - 123 + 1);
+    TEST_CHECK(sameSamples(out, &ref[123], 345 - 123 + 1));
+    
+    /* Continue: older time rejected, then the rest of the readings */
+    TEST_CHECK(!reopen.Append(ref[0].secTime, 200, 400));
+    for (U16 i=cnt - 100; i<cnt; i++)
+        TEST_CHECK(reopen.Append(ref[i].secTime, ref[i].temp, ref[i].humi));
+    reopen.Flush();
+    objTimeLog third;
+    TEST_CHECK(third.Begin(&ram, WEEK_PERIOD));
+    TEST_EQUAL(third.Query(0, 0xFFFFFFFF, out, WEEK_CNT), cnt);
+    TEST_CHECK(sameSamples(out, ref, cnt));
+}
+
+//------------------------------------------------------------------------------
+// Week replay: one reading per minute, compression vs. 4 byte samples
+//------------------------------------------------------------------------------
+static void benchWeek(void)
+{
+    static U8 weekRegion[WEEK_PAGES * WEEK_PAGE];
+    makeReadings(ref, WEEK_CNT, WEEK_PERIOD, 0);
+    objTimeLog tlog;
+    tlogRam ram(weekRegion, sizeof(weekRegion), WEEK_PAGE);
+    TEST_CHECK(tlog.Begin(&ram, WEEK_PERIOD));
+    tlog.Clear();
+    
+    double ns = wallNs();
+    for (U16 i=0; i<WEEK_CNT; i++)
+        tlog.Append(ref[i].secTime, ref[i].temp, ref[i].humi);
+    tlog.Flush();
+    double nsAppend = (wallNs() - ns) / WEEK_CNT;
+    
+    U32 sampleCnt = 0;
+    U32 byteCnt = 0;
+    tlog.GetStats(&sampleCnt, &byteCnt);
+    TEST_EQUAL(sampleCnt, WEEK_CNT);
+    
+    ns = wallNs();
+    U16 cnt = tlog.Query(0, 0xFFFFFFFF, out, WEEK_CNT + 1);
+    double msQuery = (wallNs() - ns) / 1e6;
+    TEST_EQUAL(cnt, WEEK_CNT);
+    TEST_CHECK(sameSamples(out, ref, WEEK_CNT));
+    
+    /* Last day only: pages in front are skipped */
+    ns = wallNs();
+    U32 secDay = ref[WEEK_CNT - 1].secTime - 86400 + WEEK_PERIOD;
+    TEST_EQUAL(tlog.Query(secDay, 0xFFFFFFFF, out, WEEK_CNT), 24 * 60);
+    double msDay = (wallNs() - ns) / 1e6;
+    
+    double ratio = (4.0 * WEEK_CNT) / byteCnt;
+    printf("  week, %u readings: %lu bytes (%.2f bytes per reading), compression %.1fx, "
+           "Append() %.0f ns, Query() week %.2f ms, last day %.2f ms\n",
+           WEEK_CNT, (unsigned long)byteCnt, (double)byteCnt / WEEK_CNT, ratio,
+           nsAppend, msQuery, msDay);
+    TEST_CHECK(ratio >= 4.0);
+}
+
+//------------------------------------------------------------------------------
+int main(void)
+{
+    /* Page size: header and one longest record .. TLOG_PAGE_MAX */
+    objTimeLog tlog;
+    tlogRam ramSmall(region, 2 * (TLOG_PAGE_MIN - 1), TLOG_PAGE_MIN - 1);
+    TEST_CHECK(!tlog.Begin(&ramSmall, 60));
+    tlogRam ramLarge(region, 2 * (TLOG_PAGE_MAX + 1), TLOG_PAGE_MAX + 1);
+    TEST_CHECK(!tlog.Begin(&ramLarge, 60));
+    tlogRam ramMax(region, 2 * TLOG_PAGE_MAX, TLOG_PAGE_MAX);
+    TEST_CHECK(tlog.Begin(&ramMax, 60));
+
+    /* Smallest pages, samples of the same second over several pages */
+    tlogRam ram(region, PAGE_CNT * TLOG_PAGE_MIN, TLOG_PAGE_MIN);
+    TEST_CHECK(tlog.Begin(&ram, 60));
+    tlog.Clear();
+    TEST_CHECK(tlog.Append(0, 200, 500));
+    for (U8 i=0; i<SAME_CNT; i++)
+    {
+        TEST_CHECK(tlog.Append(600, (i & 1) ? 200 : 700, 500));
+    }
+    tlog.Flush();
+
+    /* All of them, also those in front of the page starting at 600 */
+    TEST_EQUAL(tlog.Query(600, 600, out, SAME_CNT + 2), SAME_CNT);
+    TEST_EQUAL(out[0].temp, 700);
+    TEST_EQUAL(out[SAME_CNT - 1].temp, 200);
+    TEST_EQUAL(tlog.Query(0, 600, out, SAME_CNT + 2), SAME_CNT + 1);
+    TEST_EQUAL(out[0].secTime, 0);
+    TEST_EQUAL(tlog.Query(601, 1000, out, SAME_CNT + 2), 0);
+    
+    testWrap();
+    testReopen();
+    benchWeek();
+
+    return TestResult("testTimeLog");
+}
+
+// END OF testTimeLog.cpp